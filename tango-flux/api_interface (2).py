@@ -66,7 +66,7 @@ model.to(device)
 model.eval()
 print("Modèle chargé avec succès!")
 
-def generate_audio(prompt, duration, steps, guidance_scale=3.5, seed=42):
+def generate_audio(prompt, duration, steps, guidance_scale=3.5, seed=42, output_format="wav"):
     """Fonction de génération pour l'interface Gradio et l'API"""
     start_time = time.time()
     print(f"Génération avec prompt: '{prompt}', durée: {duration}s, guidance: {guidance_scale}, seed: {seed}")
@@ -94,10 +94,19 @@ def generate_audio(prompt, duration, steps, guidance_scale=3.5, seed=42):
         wave = wave[:, :waveform_end]
         wave = wave.to(torch.float32)
         
-        # Sauvegarder dans un fichier temporaire
-        with tempfile.NamedTemporaryFile(suffix=".wav", delete=False) as f:
+        # Sauvegarder dans un fichier temporaire.
+        # FLAC 24 bits : sans perte à la résolution utile, 2 à 3 fois plus léger que le WAV flottant.
+        # Ogg Vorbis : beaucoup plus léger mais avec perte.
+        if output_format == "flac":
+            suffix, save_args = ".flac", {"format": "flac", "bits_per_sample": 24}
+        elif output_format == "ogg":
+            suffix, save_args = ".ogg", {"format": "vorbis"}
+        else:
+            suffix, save_args = ".wav", {}
+
+        with tempfile.NamedTemporaryFile(suffix=suffix, delete=False) as f:
             temp_path = f.name
-            torchaudio.save(temp_path, wave, sample_rate=44100)
+        torchaudio.save(temp_path, wave, sample_rate=44100, **save_args)
     
     end_time = time.time()
     print(f"Génération terminée en {end_time - start_time:.2f} secondes")
@@ -116,13 +125,14 @@ with gr.Blocks(title="TangoFlux API") as demo:
         steps = gr.Number(value=50)
         guidance_scale = gr.Number(value=3.5)
         seed = gr.Number(value=42)
+        output_format = gr.Textbox(value="wav")  # wav, flac ou ogg
         audio_output = gr.Audio()
         
         # Ce bouton n'est pas visible, mais définit l'endpoint API
         generate_btn = gr.Button("Générer")
         generate_btn.click(
             fn=generate_audio, 
-            inputs=[prompt, duration, steps, guidance_scale, seed], 
+            inputs=[prompt, duration, steps, guidance_scale, seed, output_format], 
             outputs=audio_output
         )
 
@@ -0,0 +1,123 @@
+// Banc de mesure du pipeline réseau du client TangoFlux (join -> SSE -> téléchargement).
+// A lancer contre le serveur local de substitution (gradio_standin.py) pour mesurer
+// hors ligne l'effet des optimisations du chemin réseau :
+//
+//     python gradio_standin.py --port 7860 --latency 40 --jitter 10
+//     GenIR_ClientBenchmark --server=http://127.0.0.1:7860 --runs=20 --duration=10
+//
+// --trace=fichier.json enregistre en plus la chronologie des étapes de chaque essai (TraceLog),
+// à ouvrir dans chrome://tracing ou Perfetto.
+
+#include <JuceHeader.h>
+#include "../src/TangoFluxClient.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct StageSamples
+    {
+        juce::String name;
+        std::vector<double> values;
+    };
+
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort(values.begin(), values.end());
+        const auto index = (size_t) juce::jlimit(0.0, (double) values.size() - 1.0,
+            std::ceil(p * (double) values.size()) - 1.0);
+        return values[index];
+    }
+
+    void printStage(const StageSamples& stage)
+    {
+        if (stage.values.empty())
+            return;
+
+        std::cout << stage.name.paddedRight(' ', 16)
+                  << juce::String(percentile(stage.values, 0.0), 1).paddedLeft(' ', 10)
+                  << juce::String(percentile(stage.values, 0.5), 1).paddedLeft(' ', 10)
+                  << juce::String(percentile(stage.values, 0.95), 1).paddedLeft(' ', 10)
+                  << juce::String(percentile(stage.values, 1.0), 1).paddedLeft(' ', 10)
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    const juce::String server = args.containsOption("--server")
+        ? args.getValueForOption("--server") : juce::String("http://127.0.0.1:7860");
+    const int runs = args.containsOption("--runs") ? args.getValueForOption("--runs").getIntValue() : 10;
+    const float duration = args.containsOption("--duration") ? args.getValueForOption("--duration").getFloatValue() : 5.0f;
+    const int steps = args.containsOption("--steps") ? args.getValueForOption("--steps").getIntValue() : 25;
+
+    JuceImpl_TangoFluxClient client(server.toStdString(), args.containsOption("--verbose"));
+    juce::File output = juce::File::createTempFile(".wav");
+
+    if (args.containsOption("--format"))
+        client.set_transfer_format(args.getValueForOption("--format").toStdString());
+
+    StageSamples join{ "join" }, firstEvent{ "first event" }, wait{ "result wait" },
+                 download{ "download" }, total{ "total" };
+    int failures = 0;
+    juce::int64 bytes = 0;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        // Une ligne de la trace par essai
+        const TraceLog::ScopedGeneration traced(trace->newGeneration());
+
+        try
+        {
+            // Une seed différente par essai pour ne jamais profiter d'un cache
+            const juce::File written(client.generate_audio("benchmark room", duration, steps, 3.5f, run,
+                                                           output.getFullPathName().toStdString()));
+            if (written != output)
+                written.deleteFile();
+
+            const auto& t = client.get_last_timings();
+            join.values.push_back(t.join_ms);
+            firstEvent.values.push_back(t.first_event_ms);
+            wait.values.push_back(t.result_wait_ms);
+            download.values.push_back(t.download_ms);
+            total.values.push_back(t.total_ms);
+            bytes = t.downloaded_bytes;
+        }
+        catch (const std::exception& e)
+        {
+            ++failures;
+            std::cerr << "Essai " << run << " en échec: " << e.what() << std::endl;
+        }
+    }
+
+    output.deleteFile();
+
+    std::cout << "Serveur: " << server << "  essais: " << runs << "  échecs: " << failures
+              << "  taille IR: " << bytes << " octets" << std::endl;
+    std::cout << juce::String("étape (ms)").paddedRight(' ', 16)
+              << juce::String("min").paddedLeft(' ', 10) << juce::String("p50").paddedLeft(' ', 10)
+              << juce::String("p95").paddedLeft(' ', 10) << juce::String("max").paddedLeft(' ', 10)
+              << std::endl;
+
+    for (auto* stage : { &join, &firstEvent, &wait, &download, &total })
+        printStage(*stage);
+
+    if (args.containsOption("--trace"))
+    {
+        const juce::File traceFile = juce::File::getCurrentWorkingDirectory()
+            .getChildFile(args.getValueForOption("--trace"));
+
+        if (trace->exportChromeTrace(traceFile))
+            std::cout << "Trace: " << traceFile.getFullPathName() << std::endl;
+    }
+
+    return failures == runs ? 1 : 0;
+}
@@ -0,0 +1,293 @@
+// Démon GenIR : service de génération partagé par toutes les instances du plugin de la machine,
+// y compris celles d'hôtes qui isolent chaque plugin dans son propre processus.
+//
+// Le démon possède le client réseau, le cache des générations et les spectres préparés. Les
+// instances s'y connectent en local (DaemonClient, protocole dans DaemonProtocol.h) ; sans
+// démon, chacune retombe sur le service de génération de son processus.
+//
+//     GenIR_Daemon [--port=52817]
+//
+// Les spectres de chaque IR sont calculés une fois pour la fréquence et la taille de partition
+// demandées, écrits dans DaemonProtocol::getSpectraDirectory() et projetés en mémoire par les
+// instances : les pages sont partagées au lieu d'être copiées par la connexion. Les IRs
+// générées sont écrites dans DaemonProtocol::getResultsDirectory(), d'où l'instance les reprend.
+
+#include <JuceHeader.h>
+#include "../src/DaemonProtocol.h"
+#include "../src/PartitionedConvolution.h"
+#include "../src/TangoFluxClient.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace
+{
+    // Spectres de l'IR pour la configuration du demandeur ; fichier vide si rien à préparer
+    juce::File prepareSpectra(const GenerationRequest& request, const ImpulseResponse& impulseResponse)
+    {
+        if (request.preparedSampleRate <= 0.0 || request.preparedBlockSize <= 0 || !impulseResponse.isValid())
+            return {};
+
+        // Déjà dans le conteneur .genir : l'instance les projette en l'ouvrant
+        if (impulseResponse.findPrepared(request.preparedSampleRate, request.preparedBlockSize) != nullptr)
+            return {};
+
+        const juce::String cacheKey = GenerationCache::makeKey(request.prompt, request.duration, request.steps,
+                                                               request.guidanceScale, request.seed);
+        const juce::File file = DaemonProtocol::getSpectraFile(cacheKey, request.preparedSampleRate,
+                                                               request.preparedBlockSize);
+        if (file.existsAsFile())
+            return file;
+
+        DaemonProtocol::getSpectraDirectory().createDirectory();
+
+        // Même découpage que PartitionedConvolution, pour que les spectres y soient utilisables tels quels
+        const int channels = juce::jmin(2, impulseResponse.samples.getNumChannels());
+        const int numPartitions = IRPartitioner::getNumPartitions(impulseResponse.samples.getNumSamples(),
+                                                                  impulseResponse.sampleRate,
+                                                                  request.preparedSampleRate,
+                                                                  request.preparedBlockSize);
+
+        PreparedIR prepared(channels, request.preparedBlockSize, numPartitions, request.preparedSampleRate);
+        IRPartitioner partitioner(prepared, impulseResponse.sampleRate);
+        partitioner.append(impulseResponse.samples, impulseResponse.samples.getNumSamples());
+        partitioner.finish();
+
+        return prepared.writeToFile(file) ? file : juce::File();
+    }
+
+    // Une demande d'une instance du plugin, confiée au service de génération du démon.
+    // Les notifications sont renvoyées à l'instance ; le téléchargement progressif n'est pas
+    // relayé, l'instance installe l'IR complète.
+    class PendingRequest : public GenerationSubscriber
+    {
+    public:
+        using Reply = std::function<void(const juce::var&)>;
+
+        PendingRequest(int requestId, const GenerationRequest& r, Reply replyFunction)
+            : id(requestId), request(r), reply(std::move(replyFunction))
+        {
+        }
+
+        bool isFinished() const noexcept
+        {
+            return finished;
+        }
+
+    private:
+        void generationProgress(float progress, const juce::String& stage) override
+        {
+            // Le service annonce la fin par generationCompleted() puis generationProgress(1, message) :
+            // les deux partent dans un seul message
+            if (completed)
+            {
+                juce::var message = DaemonProtocol::makeMessage("completed", id);
+                message.getDynamicObject()->setProperty("file", completedFile.getFullPathName());
+                message.getDynamicObject()->setProperty("spectra", spectraFile.getFullPathName());
+                message.getDynamicObject()->setProperty("message", stage);
+                reply(message);
+                finished = true;
+                return;
+            }
+
+            juce::var message = DaemonProtocol::makeMessage("progress", id);
+            message.getDynamicObject()->setProperty("progress", (double) progress);
+            message.getDynamicObject()->setProperty("stage", stage);
+            reply(message);
+        }
+
+        void generationStreamStarted(std::shared_ptr<ProgressiveBuffer>) override {}
+
+        void generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse) override
+        {
+            // Une prédiction n'est que mise en cache : rien à décoder côté instance
+            if (!request.speculative)
+            {
+                completedFile = irFile;
+                spectraFile = prepareSpectra(request, impulseResponse);
+            }
+
+            completed = true;
+        }
+
+        void generationFailed(const juce::String& errorMessage) override
+        {
+            juce::var message = DaemonProtocol::makeMessage("failed", id);
+            message.getDynamicObject()->setProperty("message", errorMessage);
+            reply(message);
+            finished = true;
+        }
+
+        const int id;
+        const GenerationRequest request;
+        const Reply reply;
+
+        bool completed = false;
+        juce::File completedFile, spectraFile;
+        std::atomic<bool> finished { false };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PendingRequest)
+    };
+
+    // Connexion d'un processus hôte. Ses demandes sont annulées quand il se déconnecte.
+    class Session : public juce::InterprocessConnection
+    {
+    public:
+        explicit Session(GenerationService& s)
+            : juce::InterprocessConnection(false, DaemonProtocol::magicHeader),
+              service(s)
+        {
+        }
+
+        ~Session() override
+        {
+            disconnect();
+            cancelAll();
+        }
+
+        bool isClosed() const noexcept
+        {
+            return closed;
+        }
+
+    private:
+        void connectionMade() override {}
+
+        void connectionLost() override
+        {
+            closed = true;
+            cancelAll();
+        }
+
+        // requests n'est utilisé que depuis le thread de la connexion (et le destructeur)
+        void messageReceived(const juce::MemoryBlock& block) override
+        {
+            removeFinished();
+
+            const juce::var message = DaemonProtocol::decode(block);
+            const juce::String type = message["type"].toString();
+            const int id = (int) message["id"];
+
+            if (type == "generate")
+            {
+                cancel(id);
+
+                // Le résultat est écrit dans le répertoire du démon, jamais à un chemin fourni par
+                // le client : la connexion n'est pas authentifiée
+                GenerationRequest request = DaemonProtocol::requestFromVar(message);
+                request.outputFile = DaemonProtocol::getResultsDirectory()
+                                         .getChildFile("result_" + juce::Uuid().toString() + ".wav");
+
+                auto pending = std::make_unique<PendingRequest>(id, request, [this](const juce::var& reply)
+                {
+                    sendMessage(DaemonProtocol::encode(reply));
+                });
+
+                service.submit(*pending, request);
+                requests[id] = std::move(pending);
+            }
+            else if (type == "cancel")
+            {
+                cancel(id);
+            }
+        }
+
+        void cancel(int id)
+        {
+            auto it = requests.find(id);
+            if (it == requests.end())
+                return;
+
+            service.cancel(*it->second);
+            requests.erase(it);
+        }
+
+        // Une fois annulée auprès du service, une demande ne reçoit plus de notification
+        void removeFinished()
+        {
+            for (auto it = requests.begin(); it != requests.end();)
+            {
+                if (it->second->isFinished())
+                {
+                    service.cancel(*it->second);
+                    it = requests.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        void cancelAll()
+        {
+            for (auto& entry : requests)
+                service.cancel(*entry.second);
+
+            requests.clear();
+        }
+
+        GenerationService& service;
+        std::map<int, std::unique_ptr<PendingRequest>> requests;
+        std::atomic<bool> closed { false };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Session)
+    };
+
+    class Daemon : public juce::InterprocessConnectionServer
+    {
+    public:
+        ~Daemon() override
+        {
+            stop();
+
+            const juce::ScopedLock lock(sessionLock);
+            sessions.clear();
+        }
+
+    private:
+        // Appelé par le thread du serveur à chaque connexion ; les sessions fermées sont libérées ici
+        juce::InterprocessConnection* createConnectionObject() override
+        {
+            const juce::ScopedLock lock(sessionLock);
+
+            for (int i = sessions.size(); --i >= 0;)
+                if (sessions.getUnchecked(i)->isClosed())
+                    sessions.remove(i);
+
+            return sessions.add(new Session(*service));
+        }
+
+        juce::SharedResourcePointer<GenerationService> service;
+        juce::CriticalSection sessionLock;
+        juce::OwnedArray<Session> sessions;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    const int port = args.containsOption("--port")
+        ? args.getValueForOption("--port").getIntValue() : DaemonProtocol::getPort();
+
+    // Résultats qu'aucune instance n'a repris avant l'arrêt précédent du démon
+    const juce::File results = DaemonProtocol::getResultsDirectory();
+    results.deleteRecursively();
+    results.createDirectory();
+
+    Daemon daemon;
+
+    // Écoute uniquement en local : les instances du plugin sont sur la même machine
+    if (!daemon.beginWaitingForSocket(port, "127.0.0.1"))
+    {
+        std::cerr << "GenIR daemon: port " << port << " unavailable" << std::endl;
+        return 1;
+    }
+
+    std::cout << "GenIR daemon listening on 127.0.0.1:" << port << std::endl;
+
+    for (;;)
+        juce::Thread::sleep(1000);
+}
@@ -0,0 +1,328 @@
+"""Serveur local imitant l'API Gradio de TangoFlux (queue/join -> SSE -> file=).
+
+Permet de tester et de mesurer le client du plugin sans GPU ni URL gradio.live :
+les IRs renvoyées sont synthétiques (bruit à décroissance exponentielle) et la
+latence, la gigue et les pannes peuvent être injectées depuis la ligne de commande.
+
+Exemple :
+    python gradio_standin.py --port 7860 --latency 50 --jitter 20 --step-time 0.05 --failure-rate 0.1
+"""
+
+import argparse
+import gzip
+import io
+import json
+import math
+import random
+import struct
+import threading
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, unquote, urlparse
+
+SAMPLE_RATE = 44100
+
+# Etat partagé entre les requêtes
+events = {}           # event_id -> paramètres et horodatage de la génération
+session_events = {}   # session_hash -> liste des event_id non encore diffusés
+state_lock = threading.Lock()
+ir_cache = {}         # (durée, seed) -> octets WAV
+
+
+def synth_ir(duration, seed):
+    """Génère une IR stéréo synthétique au format WAV flottant 32 bits"""
+    key = (round(duration, 3), seed)
+    with state_lock:
+        if key in ir_cache:
+            return ir_cache[key]
+
+    rng = random.Random(seed)
+    num_samples = max(1, int(duration * SAMPLE_RATE))
+    decay = 6.9 / max(0.1, duration * 0.6)  # -60 dB à 60 % de la durée
+    samples = bytearray()
+    for n in range(num_samples):
+        env = math.exp(-decay * n / SAMPLE_RATE)
+        left = (rng.random() * 2.0 - 1.0) * env
+        right = (rng.random() * 2.0 - 1.0) * env
+        samples += struct.pack("<ff", left, right)
+
+    channels, bits = 2, 32
+    block_align = channels * bits // 8
+    header = io.BytesIO()
+    header.write(b"RIFF")
+    header.write(struct.pack("<I", 36 + len(samples)))
+    header.write(b"WAVEfmt ")
+    header.write(struct.pack("<IHHIIHH", 16, 3, channels, SAMPLE_RATE,
+                             SAMPLE_RATE * block_align, block_align, bits))
+    header.write(b"data")
+    header.write(struct.pack("<I", len(samples)))
+    data = header.getvalue() + bytes(samples)
+
+    with state_lock:
+        ir_cache[key] = data
+    return data
+
+
+class StandInHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    config = None
+
+    def log_message(self, fmt, *args):
+        if self.config.verbose:
+            super().log_message(fmt, *args)
+
+    # Latence et pannes injectées
+    def inject_latency(self):
+        delay = self.config.latency + random.uniform(-self.config.jitter, self.config.jitter)
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+    def should_fail(self):
+        return random.random() < self.config.failure_rate
+
+    def send_json(self, payload, status=200):
+        body = json.dumps(payload).encode("utf-8")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_failure(self):
+        self.send_json({"error": "injected failure"}, status=503)
+
+    def completed_message(self, event_id):
+        event = events[event_id]
+        path = "/tmp/gradio/%s/audio.wav" % event_id
+        host = self.headers.get("Host", "127.0.0.1")
+        return {
+            "msg": "process_completed",
+            "event_id": event_id,
+            "output": {
+                "data": [{
+                    "path": path,
+                    "url": "http://%s/gradio_api/file=%s" % (host, path),
+                    "orig_name": "audio.wav",
+                    "mime_type": "audio/wav",
+                    "meta": {"_type": "gradio.FileData"},
+                }],
+                "is_generating": False,
+                "duration": event["inference_time"],
+            },
+            "success": True,
+        }
+
+    def do_POST(self):
+        self.inject_latency()
+        url = urlparse(self.path)
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length) if length > 0 else b""
+
+        if url.path != "/gradio_api/queue/join":
+            self.send_json({"error": "not found"}, status=404)
+            return
+        if self.should_fail():
+            self.send_failure()
+            return
+
+        try:
+            request = json.loads(body.decode("utf-8"))
+            prompt, duration, steps, guidance, seed = request["data"][:5]
+            # 6e entrée optionnelle : format demandé. Le stand-in répond toujours en WAV,
+            # ce que le client doit accepter (il se fie au contenu, pas à l'extension)
+            output_format = request["data"][5] if len(request["data"]) > 5 else "wav"
+            session_hash = request["session_hash"]
+        except (ValueError, KeyError, TypeError):
+            self.send_json({"error": "invalid payload"}, status=422)
+            return
+
+        event_id = uuid.uuid4().hex
+        with state_lock:
+            # Les générations sont traitées une par une, comme sur le vrai serveur
+            queue_end = max([e["finish"] for e in events.values()] + [time.time()])
+            inference_time = int(steps) * self.config.step_time
+            events[event_id] = {
+                "prompt": prompt,
+                "duration": float(duration),
+                "steps": int(steps),
+                "guidance": float(guidance),
+                "seed": int(seed),
+                "format": output_format,
+                "start": queue_end,
+                "finish": queue_end + inference_time,
+                "inference_time": inference_time,
+            }
+            session_events.setdefault(session_hash, []).append(event_id)
+
+        self.send_json({"event_id": event_id})
+
+    def do_GET(self):
+        self.inject_latency()
+        url = urlparse(self.path)
+        query = parse_qs(url.query)
+
+        if url.path == "/gradio_api/queue/data":
+            self.stream_events(query.get("session_hash", [""])[0])
+        elif url.path == "/gradio_api/queue/status":
+            self.send_status(query.get("event_id", [""])[0])
+        elif url.path.startswith("/gradio_api/file="):
+            self.send_file(unquote(url.path[len("/gradio_api/file="):]))
+        else:
+            self.send_json({"error": "not found"}, status=404)
+
+    def send_status(self, event_id):
+        if self.should_fail():
+            self.send_failure()
+            return
+        with state_lock:
+            event = events.get(event_id)
+        if not event_id:
+            # Etat de la file, comme le GET /queue/status de Gradio (sonde de santé du client)
+            now = time.time()
+            with state_lock:
+                queued = [e for e in events.values() if e["finish"] > now]
+            self.send_json({"msg": "estimation", "queue_size": len(queued),
+                            "rank_eta": max([e["finish"] - now for e in queued], default=0.0)})
+        elif event is None:
+            self.send_json({"error": "unknown event"}, status=404)
+        elif time.time() >= event["finish"]:
+            self.send_json(self.completed_message(event_id))
+        else:
+            self.send_json({"msg": "estimation", "event_id": event_id,
+                            "rank_eta": max(0.0, event["finish"] - time.time())})
+
+    def send_file(self, path):
+        if self.should_fail():
+            self.send_failure()
+            return
+        event_id = path.strip("/").split("/")[-2] if path.count("/") >= 2 else ""
+        with state_lock:
+            event = events.get(event_id)
+        if event is None:
+            self.send_json({"error": "unknown file"}, status=404)
+            return
+
+        data = synth_ir(event["duration"], event["seed"])
+        encoding = None
+        if "gzip" in self.headers.get("Accept-Encoding", ""):
+            # mtime fixe : le flux compressé est identique d'une requête à l'autre, ce qui permet
+            # de reprendre un téléchargement compressé avec Range
+            data = gzip.compress(data, mtime=0)
+            encoding = "gzip"
+
+        # Reprise de téléchargement : Range: bytes=<début>-
+        start = 0
+        range_header = self.headers.get("Range", "")
+        if range_header.startswith("bytes=") and range_header.endswith("-"):
+            try:
+                start = int(range_header[len("bytes="):-1])
+            except ValueError:
+                start = 0
+        if start >= len(data):
+            start = 0
+
+        self.send_response(206 if start > 0 else 200)
+        self.send_header("Content-Type", "audio/wav")
+        self.send_header("Accept-Ranges", "bytes")
+        if encoding:
+            self.send_header("Content-Encoding", encoding)
+        if start > 0:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, len(data) - 1, len(data)))
+        self.send_header("Content-Length", str(len(data) - start))
+        self.end_headers()
+        data = data[start:]
+
+        # Débit limité optionnel pour simuler un lien lent
+        chunk = 64 * 1024
+        for offset in range(0, len(data), chunk):
+            if offset > 0 and self.should_fail():
+                # Coupure au milieu du transfert, pour tester la reprise
+                self.close_connection = True
+                return
+            self.wfile.write(data[offset:offset + chunk])
+            if self.config.bandwidth > 0:
+                time.sleep(chunk / (self.config.bandwidth * 1024.0))
+
+    def write_event(self, payload):
+        line = ("data: %s\n\n" % json.dumps(payload)).encode("utf-8")
+        self.wfile.write(b"%x\r\n%s\r\n" % (len(line), line))
+        self.wfile.flush()
+
+    def stream_events(self, session_hash):
+        # Attendre qu'une génération soit en file pour cette session
+        deadline = time.time() + 5.0
+        event_id = None
+        while event_id is None and time.time() < deadline:
+            with state_lock:
+                pending = session_events.get(session_hash, [])
+                event_id = pending.pop(0) if pending else None
+            if event_id is None:
+                time.sleep(0.05)
+
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+
+        try:
+            if event_id is not None:
+                self.stream_event(event_id)
+            self.write_event({"msg": "close_stream", "event_id": None})
+            self.wfile.write(b"0\r\n\r\n")
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+    def stream_event(self, event_id):
+        with state_lock:
+            event = events[event_id]
+            queue_size = sum(1 for e in events.values() if e["finish"] > time.time())
+
+        # Position dans la file jusqu'au début du traitement
+        while time.time() < event["start"]:
+            self.write_event({"msg": "estimation", "event_id": event_id,
+                              "rank": max(0, queue_size - 1), "queue_size": queue_size,
+                              "rank_eta": event["finish"] - time.time()})
+            time.sleep(min(1.0, max(0.01, event["start"] - time.time())))
+
+        self.write_event({"msg": "process_starts", "event_id": event_id,
+                          "eta": event["inference_time"]})
+
+        # Progression pas à pas de l'inférence
+        for step in range(event["steps"]):
+            if self.should_fail():
+                # Coupure brutale du flux au milieu de la génération
+                raise ConnectionResetError()
+            self.write_event({"msg": "progress", "event_id": event_id,
+                              "progress_data": [{"index": step + 1, "length": event["steps"],
+                                                 "unit": "steps", "progress": None, "desc": None}]})
+            remaining = event["finish"] - time.time()
+            time.sleep(max(0.0, min(self.config.step_time, remaining)))
+
+        self.write_event(self.completed_message(event_id))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serveur Gradio local de substitution pour GenIR")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=7860)
+    parser.add_argument("--latency", type=float, default=0.0, help="latence ajoutée par requête (ms)")
+    parser.add_argument("--jitter", type=float, default=0.0, help="gigue uniforme +/- (ms)")
+    parser.add_argument("--failure-rate", type=float, default=0.0, help="probabilité de panne par requête (0-1)")
+    parser.add_argument("--step-time", type=float, default=0.02, help="durée simulée d'une étape d'inférence (s)")
+    parser.add_argument("--bandwidth", type=float, default=0.0, help="débit des téléchargements (Kio/s, 0 = illimité)")
+    parser.add_argument("--verbose", action="store_true")
+    config = parser.parse_args()
+
+    StandInHandler.config = config
+    server = ThreadingHTTPServer((config.host, config.port), StandInHandler)
+    print("Serveur GenIR de substitution sur http://%s:%d" % (config.host, config.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DaemonProtocol.h"
+#include "GenerationRequest.h"
+#include "ImpulseResponse.h"
+#include "PreparedIR.h"
+
+#include <map>
+
+// Connexion d'un processus au démon GenIR, partagée par toutes ses instances du plugin
+// (SharedResourcePointer). Quand un démon écoute sur la machine, il possède le client réseau,
+// le cache des générations et les spectres préparés : chaque génération et chaque FFT des
+// partitions n'est payée qu'une fois pour tous les processus. Sans démon, TangoFluxClient
+// utilise le service de génération du processus.
+//
+// Moteur de génération comme GenerationService, avec les mêmes notifications aux demandeurs,
+// reçues sur le thread de la connexion.
+class DaemonClient : public GenerationBackend,
+                     private juce::InterprocessConnection
+{
+public:
+    DaemonClient()
+        : juce::InterprocessConnection(false, DaemonProtocol::magicHeader)
+    {
+        // Première tentative dès la création, avant la première demande
+        lastAttemptMs = juce::Time::getMillisecondCounterHiRes();
+        connector.startThread();
+    }
+
+    ~DaemonClient() override
+    {
+        connector.signalThreadShouldExit();
+        connector.notify();
+        connector.stopThread(connectTimeoutMs + 2000);
+        disconnect();
+    }
+
+    // Vrai si le démon est connecté. Sinon, une tentative de connexion est lancée sur le thread
+    // de connexion, au plus une par retryIntervalMs : l'appelant (souvent le thread des messages)
+    // n'attend jamais, et la demande en cours va au service du processus.
+    bool ensureConnected()
+    {
+        if (isConnected())
+            return true;
+
+        const juce::ScopedLock lock(connectLock);
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        if (now - lastAttemptMs >= retryIntervalMs)
+        {
+            lastAttemptMs = now;
+            connector.notify();
+        }
+
+        return false;
+    }
+
+    void submit(GenerationSubscriber& subscriber, const GenerationRequest& request) override
+    {
+        int id = 0;
+        int replacedId = 0;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            replacedId = findId(subscriber);
+            if (replacedId != 0)
+                pending.erase(replacedId);
+
+            id = ++nextId;
+            pending[id] = { &subscriber, request.outputFile };
+        }
+
+        if (replacedId != 0)
+            sendMessage(DaemonProtocol::encode(DaemonProtocol::makeMessage("cancel", replacedId)));
+
+        if (!sendMessage(DaemonProtocol::encode(DaemonProtocol::requestToVar(id, request))))
+        {
+            {
+                const juce::ScopedLock lock(stateLock);
+                pending.erase(id);
+            }
+
+            subscriber.generationFailed("Error: the GenIR daemon is unreachable");
+        }
+    }
+
+    // Après le retour, subscriber ne reçoit plus aucune notification.
+    // Retourne false s'il n'attendait aucune génération.
+    bool cancel(GenerationSubscriber& subscriber) override
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+        int id = 0;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            id = findId(subscriber);
+            if (id == 0)
+                return false;
+
+            pending.erase(id);
+        }
+
+        sendMessage(DaemonProtocol::encode(DaemonProtocol::makeMessage("cancel", id)));
+        return true;
+    }
+
+    bool isPending(GenerationSubscriber& subscriber) const override
+    {
+        const juce::ScopedLock lock(stateLock);
+        return findId(subscriber) != 0;
+    }
+
+private:
+    static constexpr double retryIntervalMs = 5000.0;
+    static constexpr int connectTimeoutMs = 200;
+
+    // connectToSocket bloque jusqu'à connectTimeoutMs quand aucun démon n'écoute : les
+    // tentatives sont faites ici, à la demande de ensureConnected()
+    class Connector : public juce::Thread
+    {
+    public:
+        explicit Connector(DaemonClient& c)
+            : juce::Thread("GenIR daemon connection"),
+            client(c)
+        {
+        }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                if (!client.isConnected())
+                    client.connectToSocket("127.0.0.1", DaemonProtocol::getPort(), connectTimeoutMs);
+
+                wait(-1);
+            }
+        }
+
+    private:
+        DaemonClient& client;
+    };
+
+    // Demande envoyée au démon : le fichier de l'IR y est déplacé à la fin de la génération
+    struct Pending
+    {
+        GenerationSubscriber* subscriber = nullptr;
+        juce::File outputFile;
+    };
+
+    // Sous stateLock
+    int findId(GenerationSubscriber& subscriber) const
+    {
+        for (auto& entry : pending)
+            if (entry.second.subscriber == &subscriber)
+                return entry.first;
+        return 0;
+    }
+
+    Pending findPending(int id, bool finished)
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = pending.find(id);
+        if (it == pending.end())
+            return {};
+
+        const Pending found = it->second;
+        if (finished)
+            pending.erase(it);
+        return found;
+    }
+
+    void connectionMade() override {}
+
+    // Démon arrêté : les générations en cours ne se termineront pas
+    void connectionLost() override
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+        std::map<int, Pending> lost;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            lost.swap(pending);
+        }
+
+        for (auto& entry : lost)
+            entry.second.subscriber->generationFailed("Error: connection to the GenIR daemon lost");
+    }
+
+    void messageReceived(const juce::MemoryBlock& block) override
+    {
+        const juce::var message = DaemonProtocol::decode(block);
+        const juce::String type = message["type"].toString();
+        const int id = (int) message["id"];
+
+        const juce::ScopedLock callbacks(callbackLock);
+
+        if (type == "progress")
+        {
+            if (auto* subscriber = findPending(id, false).subscriber)
+                subscriber->generationProgress((float) (double) message["progress"], message["stage"].toString());
+        }
+        else if (type == "completed")
+        {
+            const Pending request = findPending(id, true);
+            if (request.subscriber != nullptr)
+                deliver(request, message);
+        }
+        else if (type == "failed")
+        {
+            if (auto* subscriber = findPending(id, true).subscriber)
+                subscriber->generationFailed(message["message"].toString());
+        }
+    }
+
+    // Le fichier est repris du répertoire du démon et décodé ici ; les spectres, s'ils existent,
+    // sont projetés sans copie
+    void deliver(const Pending& request, const juce::var& message)
+    {
+        GenerationSubscriber& subscriber = *request.subscriber;
+        const juce::String irPath = message["file"].toString();
+        ImpulseResponse impulseResponse;
+
+        // Prédiction : le résultat est seulement dans le cache du démon
+        if (!juce::File::isAbsolutePath(irPath))
+        {
+            subscriber.generationCompleted({}, impulseResponse);
+            subscriber.generationProgress(1.0f, message["message"].toString());
+            return;
+        }
+
+        // Seul un fichier du répertoire des résultats est accepté, et déplacé au nom demandé
+        juce::File irFile(irPath);
+        if (!irFile.isAChildOf(DaemonProtocol::getResultsDirectory()))
+        {
+            subscriber.generationFailed("Error: unexpected result location " + irFile.getFullPathName());
+            return;
+        }
+
+        if (request.outputFile != juce::File())
+        {
+            const juce::File destination = request.outputFile.withFileExtension(irFile.getFileExtension());
+            if (irFile.moveFileTo(destination))
+                irFile = destination;
+        }
+
+        if (!impulseResponse.loadFromFile(irFile))
+        {
+            subscriber.generationFailed("Error: unreadable audio file " + irFile.getFileName());
+            return;
+        }
+
+        const juce::String spectraPath = message["spectra"].toString();
+        if (juce::File::isAbsolutePath(spectraPath))
+            if (auto spectra = PreparedIR::mapFile(juce::File(spectraPath)))
+                impulseResponse.prepared.push_back(std::move(spectra));
+
+        subscriber.generationCompleted(irFile, impulseResponse);
+        subscriber.generationProgress(1.0f, message["message"].toString());
+    }
+
+    juce::CriticalSection connectLock;
+    double lastAttemptMs = 0.0;
+    Connector connector { *this };
+
+    // Générations en attente côté démon, par identifiant de requête
+    mutable juce::CriticalSection stateLock;
+    std::map<int, Pending> pending;
+    int nextId = 0;
+
+    // Tenu pendant les notifications, pour que cancel() puisse garantir qu'il n'y en a plus
+    juce::CriticalSection callbackLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DaemonClient)
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GenerationRequest.h"
+
+// Protocole entre les instances du plugin et le démon GenIR (GenIR_Daemon).
+// Messages JSON sur une connexion locale juce::InterprocessConnection :
+//   plugin -> démon : {"type": "generate", "id", paramètres...}, {"type": "cancel", "id"}
+//   démon -> plugin : {"type": "progress", "id", "progress", "stage"},
+//                     {"type": "completed", "id", "file", "spectra", "message"},
+//                     {"type": "failed", "id", "message"}
+// Les spectres préparés ne passent pas par la connexion : le démon les écrit dans un fichier
+// de getSpectraDirectory(), que chaque instance projette en mémoire (PreparedIR::mapFile).
+//
+// La connexion n'est pas authentifiée : le démon n'écrit que dans ses propres répertoires.
+// Le fichier de l'IR ("file") est créé dans getResultsDirectory() ; l'instance le déplace
+// ensuite vers le nom qu'elle a choisi.
+struct DaemonProtocol
+{
+    static constexpr int defaultPort = 52817;
+    static constexpr juce::uint32 magicHeader = 0x47495244;   // "GIRD"
+
+    // Port d'écoute, modifiable par la variable d'environnement GENIR_DAEMON_PORT
+    static int getPort()
+    {
+        const int port = juce::SystemStats::getEnvironmentVariable("GENIR_DAEMON_PORT", {}).getIntValue();
+        return port > 0 ? port : defaultPort;
+    }
+
+    static juce::MemoryBlock encode(const juce::var& message)
+    {
+        const juce::String json = juce::JSON::toString(message, true);
+        return juce::MemoryBlock(json.toRawUTF8(), json.getNumBytesAsUTF8());
+    }
+
+    static juce::var decode(const juce::MemoryBlock& block)
+    {
+        return juce::JSON::parse(block.toString());
+    }
+
+    static juce::var makeMessage(const juce::String& type, int id)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("type", type);
+        object->setProperty("id", id);
+        return juce::var(object);
+    }
+
+    static juce::var requestToVar(int id, const GenerationRequest& request)
+    {
+        juce::var message = makeMessage("generate", id);
+        auto* object = message.getDynamicObject();
+        object->setProperty("prompt", request.prompt);
+        object->setProperty("duration", (double) request.duration);
+        object->setProperty("steps", request.steps);
+        object->setProperty("guidanceScale", (double) request.guidanceScale);
+        object->setProperty("seed", request.seed);
+        object->setProperty("serverUrl", request.serverUrl);
+        object->setProperty("speculative", request.speculative);
+        object->setProperty("delayMs", request.delayMs);
+        object->setProperty("verbose", request.verbose);
+        object->setProperty("preparedSampleRate", request.preparedSampleRate);
+        object->setProperty("preparedBlockSize", request.preparedBlockSize);
+        return message;
+    }
+
+    static GenerationRequest requestFromVar(const juce::var& message)
+    {
+        GenerationRequest request;
+        request.prompt = message["prompt"].toString();
+        request.duration = (float) (double) message["duration"];
+        request.steps = (int) message["steps"];
+        request.guidanceScale = (float) (double) message["guidanceScale"];
+        request.seed = (int) message["seed"];
+        request.serverUrl = message["serverUrl"].toString();
+        request.speculative = (bool) message["speculative"];
+        request.delayMs = (int) message["delayMs"];
+        request.verbose = (bool) message["verbose"];
+        request.preparedSampleRate = (double) message["preparedSampleRate"];
+        request.preparedBlockSize = (int) message["preparedBlockSize"];
+        return request;
+    }
+
+    // Spectres préparés, partagés par tous les processus de la machine
+    static juce::File getSpectraDirectory()
+    {
+        return juce::File::getSpecialLocation(juce::File::tempDirectory)
+            .getChildFile("GenIR").getChildFile("Spectra");
+    }
+
+    // IRs générées par le démon, en attendant que l'instance qui les a demandées les reprenne
+    static juce::File getResultsDirectory()
+    {
+        return juce::File::getSpecialLocation(juce::File::tempDirectory)
+            .getChildFile("GenIR").getChildFile("Results");
+    }
+
+    static juce::File getSpectraFile(const juce::String& cacheKey, double sampleRate, int blockSize)
+    {
+        return getSpectraDirectory().getChildFile(cacheKey + "_" + juce::String(juce::roundToInt(sampleRate))
+            + "_" + juce::String(blockSize) + ".girs");
+    }
+};
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRStore.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+// IRs intégrées à l'état du plugin, partagées par toutes les instances du processus
+// (SharedResourcePointer).
+//
+// Le contenu du fichier de l'IR est compressé sans perte (gzip) et identifié par son empreinte
+// SHA-256. Dans un projet, une seule instance par contenu (la première enregistrée encore en vie
+// parmi celles qui intègrent leur IR) écrit les données dans son état ; les autres n'écrivent que
+// l'empreinte.
+//
+// À la restauration, les données sont gardées compressées. Elles ne sont décompressées, dans le
+// stockage des IRs (IRStore), que si aucune copie locale n'existe. Une instance dont l'état ne
+// contient qu'une référence attend que l'instance qui porte les données soit restaurée.
+class EmbeddedIRRegistry
+{
+public:
+    struct Blob
+    {
+        juce::String hash;
+        juce::String extension;
+        juce::int64 originalSize = 0;
+        juce::MemoryBlock compressed;
+    };
+
+    using Callback = std::function<void(const juce::File&)>;
+
+    EmbeddedIRRegistry() = default;
+
+    //==============================================================================
+    // Empreinte du contenu d'un fichier : gratuite pour un fichier du stockage, sinon calculée
+    // une fois par version du fichier
+    juce::String getHash(const juce::File& file)
+    {
+        const juce::String stored = store->getHash(file);
+        if (stored.isNotEmpty())
+            return stored;
+
+        if (!file.existsAsFile())
+            return {};
+
+        const juce::String key = getFileKey(file);
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = hashesByFile.find(key);
+            if (it != hashesByFile.end())
+                return it->second;
+        }
+
+        const juce::String hash = juce::SHA256(file).toHexString();
+
+        const juce::ScopedLock lock(stateLock);
+        hashesByFile[key] = hash;
+        return hash;
+    }
+
+    // Données compressées d'un fichier, calculées au premier enregistrement puis gardées
+    std::shared_ptr<const Blob> getBlob(const juce::File& file, const juce::String& hash)
+    {
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = blobs.find(hash);
+            if (it != blobs.end())
+                return it->second;
+        }
+
+        juce::MemoryBlock original;
+        if (!file.loadFileAsData(original))
+            return nullptr;
+
+        auto blob = std::make_shared<Blob>();
+        blob->hash = hash;
+        blob->extension = file.getFileExtension();
+        blob->originalSize = (juce::int64) original.getSize();
+
+        {
+            juce::MemoryOutputStream output(blob->compressed, false);
+            juce::GZIPCompressorOutputStream compressor(output, 9);
+            compressor.write(original.getData(), original.getSize());
+        }
+
+        const juce::ScopedLock lock(stateLock);
+        pruneBlobs();
+        blobs[hash] = blob;
+        return blob;
+    }
+
+    // Données lues dans un état restauré. Les instances qui attendaient ce contenu le reçoivent.
+    // Chaque rappel n'est fait que si son instance attend toujours (ni retirée ni passée à une
+    // autre IR pendant la décompression), sous callbackLock : après removeInstance() ou
+    // stopWaiting(), l'instance n'en reçoit plus aucun.
+    void addBlob(std::shared_ptr<const Blob> blob)
+    {
+        if (blob == nullptr || blob->hash.isEmpty())
+            return;
+
+        std::vector<juce::uint64> tickets;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            blobs[blob->hash] = blob;
+
+            for (auto& w : waiting)
+                if (w.hash == blob->hash)
+                    tickets.push_back(w.ticket);
+        }
+
+        if (tickets.empty())
+            return;
+
+        const juce::File file = materialise(blob->hash);
+        const juce::ScopedLock callbacks(callbackLock);
+
+        for (auto ticket : tickets)
+        {
+            Callback callback;
+
+            {
+                const juce::ScopedLock lock(stateLock);
+                auto it = std::find_if(waiting.begin(), waiting.end(), [ticket](const Waiting& w) { return w.ticket == ticket; });
+                if (it == waiting.end())
+                    continue;
+
+                callback = std::move(it->callback);
+                waiting.erase(it);
+            }
+
+            callback(file);
+        }
+    }
+
+    // Fichier local de ce contenu : dans le stockage, ou décompressé depuis les données connues.
+    // File() si le contenu n'est pas disponible.
+    juce::File materialise(const juce::String& hash)
+    {
+        const juce::File stored = store->find(hash);
+        if (stored.existsAsFile())
+            return stored;
+
+        std::shared_ptr<const Blob> blob;
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = blobs.find(hash);
+            if (it == blobs.end())
+                return {};
+            blob = it->second;
+        }
+
+        // Nom propre à cet appel : des instances restaurées en parallèle avec le même contenu
+        // décompressent chacune dans leur fichier, et le stockage ne reçoit qu'un fichier complet
+        const juce::File partial = store->getDirectory().getParentDirectory()
+                                        .getChildFile("Embedded_" + hash.substring(0, 16) + "_"
+                                                      + juce::Uuid().toString().substring(0, 12) + blob->extension);
+
+        bool written = false;
+        {
+            juce::MemoryInputStream input(blob->compressed, false);
+            juce::GZIPDecompressorInputStream decompressor(input);
+
+            juce::FileOutputStream output(partial);
+            written = output.openedOk() && output.writeFromInputStream(decompressor, -1) == blob->originalSize;
+        }
+
+        if (!written)
+        {
+            partial.deleteFile();
+            return {};
+        }
+
+        return store->add(partial);
+    }
+
+    // Fichier local dont la taille correspond au contenu attendu (les données ne sont pas relues)
+    bool matchesSize(const juce::String& hash, const juce::File& file) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = blobs.find(hash);
+        return it == blobs.end() || it->second->originalSize == file.getSize();
+    }
+
+    //==============================================================================
+    // Contenu installé par une instance (vide si aucun ou pas encore calculé)
+    void setInstanceHash(const void* instance, const juce::String& hash)
+    {
+        const juce::ScopedLock lock(stateLock);
+
+        for (auto it = instances.begin(); it != instances.end(); ++it)
+        {
+            if (it->first == instance)
+            {
+                if (it->second == hash)
+                    return;
+
+                instances.erase(it);
+                break;
+            }
+        }
+
+        // Ajoutée en fin : les instances déjà enregistrées avec ce contenu le gardent
+        if (hash.isNotEmpty())
+            instances.push_back({ instance, hash });
+    }
+
+    // Option "intégrer l'IR" de l'instance : seules celles qui intègrent peuvent porter les données
+    void setInstanceEmbeds(const void* instance, bool embeds)
+    {
+        const juce::ScopedLock lock(stateLock);
+
+        if (embeds)
+            embeddingInstances.insert(instance);
+        else
+            embeddingInstances.erase(instance);
+    }
+
+    // Vrai si cette instance porte les données du contenu dans son état
+    bool isOwner(const void* instance, const juce::String& hash) const
+    {
+        const juce::ScopedLock lock(stateLock);
+
+        for (auto& registered : instances)
+            if (registered.second == hash && embeddingInstances.count(registered.first) > 0)
+                return registered.first == instance;
+
+        return false;
+    }
+
+    // Rappel appelé quand le contenu sera disponible (restauration d'une autre instance)
+    void whenAvailable(const void* instance, const juce::String& hash, Callback callback)
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+        const juce::ScopedLock lock(stateLock);
+        cancelWaiting(instance);
+        waiting.push_back({ instance, hash, std::move(callback), ++nextTicket });
+    }
+
+    // Au retour, aucun rappel de l'instance n'est en cours ni ne sera fait
+    void stopWaiting(const void* instance)
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+        const juce::ScopedLock lock(stateLock);
+        cancelWaiting(instance);
+    }
+
+    void removeInstance(const void* instance)
+    {
+        setInstanceHash(instance, {});
+        setInstanceEmbeds(instance, false);
+
+        const juce::ScopedLock callbacks(callbackLock);
+        const juce::ScopedLock lock(stateLock);
+        cancelWaiting(instance);
+        pruneBlobs();
+    }
+
+private:
+    struct Waiting
+    {
+        const void* instance;
+        juce::String hash;
+        Callback callback;
+        juce::uint64 ticket;
+    };
+
+    static juce::String getFileKey(const juce::File& file)
+    {
+        return file.getFullPathName() + "|" + juce::String(file.getSize())
+             + "|" + juce::String(file.getLastModificationTime().toMilliseconds());
+    }
+
+    // Données qu'aucune instance n'utilise ni n'attend
+    void pruneBlobs()
+    {
+        for (auto it = blobs.begin(); it != blobs.end();)
+        {
+            const juce::String& hash = it->first;
+            const bool used = std::any_of(instances.begin(), instances.end(), [&hash](const auto& i) { return i.second == hash; })
+                           || std::any_of(waiting.begin(), waiting.end(), [&hash](const Waiting& w) { return w.hash == hash; });
+
+            if (used)
+                ++it;
+            else
+                it = blobs.erase(it);
+        }
+    }
+
+    void cancelWaiting(const void* instance)
+    {
+        waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                                     [instance](const Waiting& w) { return w.instance == instance; }),
+                      waiting.end());
+    }
+
+    juce::SharedResourcePointer<IRStore> store;
+
+    mutable juce::CriticalSection stateLock;
+    std::map<juce::String, juce::String> hashesByFile;              // chemin, taille, date -> empreinte
+    std::map<juce::String, std::shared_ptr<const Blob>> blobs;      // par empreinte
+    std::vector<std::pair<const void*, juce::String>> instances;    // dans l'ordre d'enregistrement
+    std::set<const void*> embeddingInstances;                       // option "intégrer l'IR" active
+    std::vector<Waiting> waiting;
+    juce::uint64 nextTicket = 0;
+
+    // Tenu pendant les rappels de addBlob(), et par ceux qui retirent une attente
+    juce::CriticalSection callbackLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EmbeddedIRRegistry)
+};
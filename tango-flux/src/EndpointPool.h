@@ -0,0 +1,329 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cmath>
+#include <map>
+#include <memory>
+
+// Serveurs TangoFlux disponibles pour les générations, quand on en fait tourner plusieurs.
+// L'URL configurée peut en lister plusieurs, séparées par des virgules, des points-virgules
+// ou des espaces.
+//
+// Un thread sonde régulièrement chaque serveur connu (GET /gradio_api/queue/status) :
+// temps de réponse et longueur de sa file d'attente Gradio. Avec le nombre de générations
+// que nous y avons en cours et la durée récente de nos générations, ces mesures donnent une
+// estimation du temps de fin d'une nouvelle génération sur chaque serveur ; acquire() choisit
+// le plus rapide parmi ceux qui répondent. Un serveur qui échoue est écarté jusqu'à ce qu'une
+// sonde le retrouve, avec un délai croissant entre les essais.
+//
+// Seuls les serveurs que l'utilisateur désigne encore sont suivis (setEndpoints) : un serveur
+// retiré de la liste n'est plus sondé ni compté, dès que ses générations en cours sont finies.
+class EndpointPool : private juce::Thread
+{
+public:
+    EndpointPool()
+        : juce::Thread("GenIR endpoint probe")
+    {
+    }
+
+    ~EndpointPool() override
+    {
+        stopThread(5000);
+    }
+
+    // URLs d'une liste de serveurs, nettoyées (sans « / » final) et sans doublon
+    static juce::StringArray parseUrls(const juce::String& serverList)
+    {
+        juce::StringArray urls;
+        urls.addTokens(serverList, ",; \t\r\n", "");
+        urls.trim();
+        urls.removeEmptyStrings();
+
+        for (auto& url : urls)
+            while (url.endsWith("/"))
+                url = url.dropLastCharacters(1);
+
+        urls.removeDuplicates(false);
+        return urls;
+    }
+
+    // Liste normalisée, telle qu'enregistrée dans l'état du plugin
+    static juce::String normalise(const juce::String& serverList)
+    {
+        return parseUrls(serverList).joinIntoString(", ");
+    }
+
+    // Choisit le serveur de la prochaine génération parmi urls, en excluant ceux déjà essayés
+    // pour cette génération. Retourne une chaîne vide s'il n'en reste aucun. Le serveur choisi
+    // compte une génération en cours de plus jusqu'à release().
+    juce::String acquire(const juce::StringArray& urls, const juce::StringArray& excluded)
+    {
+        const juce::ScopedLock lock(poolLock);
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        Endpoint* best = nullptr;
+        bool bestAvailable = false;
+        double bestScore = 0.0;
+
+        for (auto& url : urls)
+        {
+            if (excluded.contains(url))
+                continue;
+
+            auto& endpoint = getOrCreate(url);
+            const bool available = endpoint.isAvailable(now);
+
+            // Tous écartés : essayer celui qui peut être retenté le plus tôt plutôt que d'échouer
+            const double score = available ? endpoint.estimateCompletionMs() : endpoint.retryAtMs;
+
+            if (best == nullptr || (available && !bestAvailable) || (available == bestAvailable && score < bestScore))
+            {
+                best = &endpoint;
+                bestAvailable = available;
+                bestScore = score;
+            }
+        }
+
+        if (best == nullptr)
+            return {};
+
+        ++best->inFlight;
+        return best->url;
+    }
+
+    // Fin d'une génération sur url. durationMs : durée totale, mesurée seulement si elle a réussi.
+    // serverFailed : l'échec désigne le serveur (connexion, délai, erreur 5xx).
+    void release(const juce::String& url, bool succeeded, bool serverFailed, double durationMs)
+    {
+        const juce::ScopedLock lock(poolLock);
+        auto it = endpoints.find(url);
+        if (it == endpoints.end())
+            return;
+
+        auto& endpoint = *it->second;
+        endpoint.inFlight = juce::jmax(0, endpoint.inFlight - 1);
+
+        if (succeeded)
+        {
+            endpoint.recordHealthy();
+            endpoint.generationMs = smooth(endpoint.generationMs, durationMs);
+        }
+        else if (serverFailed)
+        {
+            endpoint.recordFailure(juce::Time::getMillisecondCounterHiRes());
+        }
+    }
+
+    // Nombre de serveurs utilisables parmi urls, pour dimensionner le nombre de générations
+    // simultanées d'une demande. Un serveur pas encore sondé compte comme disponible.
+    int getNumAvailable(const juce::StringArray& urls) const
+    {
+        const juce::ScopedLock lock(poolLock);
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        int count = 0;
+
+        for (auto& url : urls)
+        {
+            auto it = endpoints.find(url);
+            if (it == endpoints.end() || it->second->isAvailable(now))
+                ++count;
+        }
+
+        return juce::jmax(1, count);
+    }
+
+    // Serveurs à suivre : ceux de urls sont sondés dès maintenant, avant leur première génération ;
+    // les autres sont oubliés, sauf tant qu'une génération y est en cours
+    void setEndpoints(const juce::StringArray& urls)
+    {
+        bool added = false;
+
+        {
+            const juce::ScopedLock lock(poolLock);
+
+            for (auto it = endpoints.begin(); it != endpoints.end();)
+            {
+                if (!urls.contains(it->first) && it->second->inFlight == 0)
+                    it = endpoints.erase(it);
+                else
+                    ++it;
+            }
+
+            for (auto& url : urls)
+            {
+                if (endpoints.find(url) == endpoints.end())
+                {
+                    getOrCreate(url);
+                    added = true;
+                }
+            }
+        }
+
+        if (added)
+        {
+            if (!isThreadRunning())
+                startThread();
+            notify();
+        }
+    }
+
+    // État d'un serveur, pour l'affichage et les journaux
+    struct Status
+    {
+        juce::String url;
+        bool available = false;
+        int inFlight = 0;
+        int queueDepth = -1;        // -1 : inconnue
+        double probeMs = 0.0;
+        double generationMs = 0.0;
+    };
+
+    juce::Array<Status> getStatus() const
+    {
+        const juce::ScopedLock lock(poolLock);
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        juce::Array<Status> result;
+
+        for (auto& entry : endpoints)
+        {
+            const auto& e = *entry.second;
+            result.add({ e.url, e.isAvailable(now), e.inFlight, e.queueDepth, e.probeMs, e.generationMs });
+        }
+
+        return result;
+    }
+
+private:
+    static constexpr int probeIntervalMs = 15000;
+    static constexpr int probeTimeoutMs = 5000;
+    static constexpr double defaultGenerationMs = 30000.0;   // avant la première génération mesurée
+    static constexpr double minRetryDelayMs = 5000.0;
+    static constexpr double maxRetryDelayMs = 120000.0;
+
+    struct Endpoint
+    {
+        juce::String url;
+        int inFlight = 0;               // nos générations en cours sur ce serveur
+        int queueDepth = -1;            // file d'attente Gradio lors de la dernière sonde
+        double probeMs = 0.0;           // temps de réponse récent de la sonde
+        double generationMs = 0.0;      // durée récente d'une génération complète
+        int consecutiveFailures = 0;
+        double retryAtMs = 0.0;         // écarté jusqu'à cette date après un échec
+
+        bool isAvailable(double now) const
+        {
+            return consecutiveFailures == 0 || now >= retryAtMs;
+        }
+
+        // Temps estimé avant la fin d'une génération de plus : celles qui la précèdent dans la
+        // file du serveur (les nôtres comprises) puis la sienne, plus l'aller-retour réseau
+        double estimateCompletionMs() const
+        {
+            const double perGeneration = generationMs > 0.0 ? generationMs : defaultGenerationMs;
+            const int ahead = juce::jmax(0, queueDepth) + inFlight;
+            return probeMs + perGeneration * (double) (ahead + 1);
+        }
+
+        void recordHealthy()
+        {
+            consecutiveFailures = 0;
+            retryAtMs = 0.0;
+        }
+
+        void recordFailure(double now)
+        {
+            ++consecutiveFailures;
+            const double delay = juce::jmin(maxRetryDelayMs,
+                                            minRetryDelayMs * std::pow(2.0, (double) (consecutiveFailures - 1)));
+            retryAtMs = now + delay;
+        }
+    };
+
+    static double smooth(double average, double sample)
+    {
+        return average > 0.0 ? average * 0.7 + sample * 0.3 : sample;
+    }
+
+    // Sous poolLock
+    Endpoint& getOrCreate(const juce::String& url)
+    {
+        auto& endpoint = endpoints[url];
+        if (endpoint == nullptr)
+        {
+            endpoint = std::make_unique<Endpoint>();
+            endpoint->url = url;
+        }
+        return *endpoint;
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            juce::StringArray urls;
+
+            {
+                const juce::ScopedLock lock(poolLock);
+                for (auto& entry : endpoints)
+                    urls.add(entry.first);
+            }
+
+            for (auto& url : urls)
+            {
+                if (threadShouldExit())
+                    return;
+
+                probe(url);
+            }
+
+            wait(probeIntervalMs);
+        }
+    }
+
+    // Interroge l'état de la file Gradio du serveur (réponse « estimation » : queue_size)
+    void probe(const juce::String& url)
+    {
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        bool ok = false;
+        int queueDepth = -1;
+
+        juce::WebInputStream stream(juce::URL(url + "/gradio_api/queue/status"), false);
+        stream.withConnectionTimeout(probeTimeoutMs);
+
+        if (stream.connect(nullptr) && stream.getStatusCode() > 0 && stream.getStatusCode() < 500)
+        {
+            ok = true;
+
+            const juce::var status = juce::JSON::parse(stream.readEntireStreamAsString());
+            if (status.isObject() && !status["queue_size"].isVoid())
+                queueDepth = (int) status["queue_size"];
+        }
+
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        const juce::ScopedLock lock(poolLock);
+
+        // Retiré de la liste pendant la sonde
+        auto it = endpoints.find(url);
+        if (it == endpoints.end())
+            return;
+
+        auto& endpoint = *it->second;
+
+        if (ok)
+        {
+            endpoint.recordHealthy();
+            endpoint.probeMs = smooth(endpoint.probeMs, now - start);
+            endpoint.queueDepth = queueDepth;
+        }
+        else if (endpoint.isAvailable(now))
+        {
+            endpoint.recordFailure(now);
+        }
+    }
+
+    mutable juce::CriticalSection poolLock;
+    std::map<juce::String, std::unique_ptr<Endpoint>> endpoints;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EndpointPool)
+};
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRAnalysis.h"
+#include "PreparedIR.h"
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Paramètres de génération d'une IR, conservés avec elle pour pouvoir la régénérer ou la varier
+struct GenIRRecipe
+{
+    juce::String prompt;
+    float duration = 0.0f;
+    int steps = 0;
+    float guidanceScale = 0.0f;
+    int seed = 0;
+
+    juce::var toVar() const
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("prompt", prompt);
+        object->setProperty("duration", duration);
+        object->setProperty("steps", steps);
+        object->setProperty("guidance", guidanceScale);
+        object->setProperty("seed", seed);
+        return juce::var(object);
+    }
+
+    static GenIRRecipe fromVar(const juce::var& value)
+    {
+        GenIRRecipe recipe;
+        recipe.prompt = value["prompt"].toString();
+        recipe.duration = (float) (double) value.getProperty("duration", 0.0);
+        recipe.steps = (int) value.getProperty("steps", 0);
+        recipe.guidanceScale = (float) (double) value.getProperty("guidance", 0.0);
+        recipe.seed = (int) value.getProperty("seed", 0);
+        return recipe;
+    }
+};
+
+// Conteneur .genir : une IR générée et tout ce qui a été calculé à partir d'elle, dans un
+// fichier conçu pour être projeté en mémoire. La convolution lit les échantillons et les
+// spectres directement dans les pages du fichier, sans décodage ni copie.
+//
+//     en-tête (64 octets)           "GNIR", version, canaux, longueur, fréquence, positions
+//     échantillons                  float32 par canal, chaque canal aligné sur 64 octets
+//     métadonnées                   JSON : {"recipe": ..., "analysis": ...}
+//     table des spectres            (position, taille) sur 64 bits par bloc
+//     blocs de spectres             au format des fichiers de PreparedIR ("GIRS"), un par
+//                                   configuration (fréquence, taille de partition)
+//
+// Toutes les sections commencent sur une frontière de 64 octets. Les entiers et flottants
+// sont écrits dans l'ordre de la machine (petit-boutiste sur toutes les cibles du plugin).
+class GenIRFile
+{
+public:
+    static constexpr const char* fileExtension = ".genir";
+
+    // Ce qu'on écrit dans un conteneur
+    struct Contents
+    {
+        juce::AudioBuffer<float> samples;
+        double sampleRate = 0.0;
+
+        bool hasRecipe = false;
+        GenIRRecipe recipe;
+
+        bool hasAnalysis = false;
+        IRFeatures analysis;
+
+        std::vector<std::shared_ptr<const PreparedIR>> spectra;   // seuls les complets sont écrits
+    };
+
+    // Contenu lu par read() : les échantillons et les spectres font référence au fichier projeté,
+    // qui reste ouvert tant que mapping ou l'un des spectres existe
+    struct MappedContents : Contents
+    {
+        std::shared_ptr<const juce::MemoryMappedFile> mapping;
+    };
+
+    //==============================================================================
+    // Vrai si le fichier commence par la signature d'un conteneur
+    static bool isContainer(const juce::File& file)
+    {
+        juce::FileInputStream in(file);
+        char magic[4] = {};
+        return in.openedOk() && in.read(magic, 4) == 4 && std::memcmp(magic, "GNIR", 4) == 0;
+    }
+
+    // Écrit un conteneur, de façon atomique (fichier .part renommé)
+    static bool write(const juce::File& file, const Contents& contents)
+    {
+        const int numChannels = contents.samples.getNumChannels();
+        const int numSamples = contents.samples.getNumSamples();
+
+        if (numChannels < 1 || numChannels > maxChannels || numSamples < 1 || contents.sampleRate <= 0.0)
+            return false;
+
+        std::vector<std::shared_ptr<const PreparedIR>> spectra;
+        for (auto& prepared : contents.spectra)
+            if (prepared != nullptr && prepared->complete)
+                spectra.push_back(prepared);
+
+        auto* metadata = new juce::DynamicObject();
+        if (contents.hasRecipe)
+            metadata->setProperty("recipe", contents.recipe.toVar());
+        if (contents.hasAnalysis)
+            metadata->setProperty("analysis", contents.analysis.toVar());
+
+        const juce::String json = juce::JSON::toString(juce::var(metadata), true);
+        const size_t jsonSize = json.getNumBytesAsUTF8();
+
+        FileHeader header;
+        std::memcpy(header.magic, "GNIR", 4);
+        header.version = fileVersion;
+        header.numChannels = numChannels;
+        header.numSpectra = (juce::int32) spectra.size();
+        header.numSamples = numSamples;
+        header.sampleRate = contents.sampleRate;
+        header.samplesOffset = sizeof(FileHeader);
+        header.metadataOffset = align(header.samplesOffset + (juce::int64) numChannels * getChannelStride(numSamples) * (juce::int64) sizeof(float));
+        header.metadataSize = (juce::int64) jsonSize;
+        header.spectraTableOffset = align(header.metadataOffset + header.metadataSize);
+
+        std::vector<juce::int64> table;
+        juce::int64 position = align(header.spectraTableOffset + (juce::int64) (2 * spectra.size() * sizeof(juce::int64)));
+
+        for (auto& prepared : spectra)
+        {
+            table.push_back(position);
+            table.push_back((juce::int64) prepared->getSerialisedSize());
+            position = align(position + (juce::int64) prepared->getSerialisedSize());
+        }
+
+        const juce::File partial = file.getSiblingFile(file.getFileName() + ".part");
+        partial.deleteFile();
+
+        bool ok = false;
+        {
+            juce::FileOutputStream out(partial);
+            if (!out.openedOk())
+                return false;
+
+            ok = out.write(&header, sizeof(header));
+
+            for (int ch = 0; ok && ch < numChannels; ++ch)
+                ok = out.write(contents.samples.getReadPointer(ch), (size_t) numSamples * sizeof(float))
+                  && pad(out, (getChannelStride(numSamples) - numSamples) * (juce::int64) sizeof(float));
+
+            ok = ok && out.write(json.toRawUTF8(), jsonSize)
+                    && padTo(out, header.spectraTableOffset);
+
+            if (ok && !table.empty())
+                ok = out.write(table.data(), table.size() * sizeof(juce::int64));
+
+            for (size_t i = 0; ok && i < spectra.size(); ++i)
+                ok = padTo(out, table[2 * i]) && spectra[i]->writeTo(out);
+
+            ok = ok && padTo(out, position);
+            out.flush();
+            ok = ok && out.getStatus().wasOk();
+        }
+
+        if (!ok || !partial.moveFileTo(file))
+        {
+            partial.deleteFile();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Projette un conteneur en mémoire. Retourne false s'il est absent ou invalide.
+    static bool read(const juce::File& file, MappedContents& contents)
+    {
+        auto mapped = std::make_shared<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly, false);
+        const char* data = static_cast<const char*>(mapped->getData());
+        const juce::int64 fileSize = (juce::int64) mapped->getSize();
+
+        FileHeader header;
+        if (!readHeader(data, fileSize, header))
+            return false;
+
+        // Données en lecture seule : les échantillons ne doivent pas être modifiés sur place
+        // (une copie de l'AudioBuffer, elle, alloue sa propre mémoire)
+        float* channels[maxChannels] = {};
+        for (int ch = 0; ch < header.numChannels; ++ch)
+            channels[ch] = reinterpret_cast<float*>(const_cast<char*>(data + header.samplesOffset))
+                         + (size_t) ch * (size_t) getChannelStride(header.numSamples);
+
+        contents.samples = juce::AudioBuffer<float>(channels, header.numChannels, (int) header.numSamples);
+        contents.sampleRate = header.sampleRate;
+
+        readMetadata(data, header, contents);
+
+        contents.spectra.clear();
+        for (int i = 0; i < header.numSpectra; ++i)
+        {
+            juce::int64 entry[2] = {};
+            std::memcpy(entry, data + header.spectraTableOffset + i * (juce::int64) sizeof(entry), sizeof(entry));
+
+            if (entry[0] < 0 || entry[1] < 0 || entry[0] + entry[1] > fileSize)
+                continue;
+
+            if (auto prepared = PreparedIR::mapRegion(mapped, (size_t) entry[0], (size_t) entry[1]))
+                contents.spectra.push_back(std::move(prepared));
+        }
+
+        contents.mapping = std::move(mapped);
+        return true;
+    }
+
+    // Recette et analyse seulement, sans garder le fichier ouvert (indexation de la bibliothèque)
+    static bool readInfo(const juce::File& file, Contents& contents)
+    {
+        juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly, false);
+        const char* data = static_cast<const char*>(mapped.getData());
+
+        FileHeader header;
+        if (!readHeader(data, (juce::int64) mapped.getSize(), header))
+            return false;
+
+        contents.sampleRate = header.sampleRate;
+        readMetadata(data, header, contents);
+        return true;
+    }
+
+    // Exporte les échantillons d'un conteneur en WAV 32 bits flottants
+    static bool exportToWav(const juce::File& container, const juce::File& wavFile)
+    {
+        MappedContents contents;
+        return read(container, contents) && writeWav(wavFile, contents.samples, contents.sampleRate);
+    }
+
+    // Écrit des échantillons en WAV 32 bits flottants, de façon atomique
+    static bool writeWav(const juce::File& wavFile, const juce::AudioBuffer<float>& samples, double sampleRate)
+    {
+        if (samples.getNumSamples() == 0 || samples.getNumChannels() == 0 || sampleRate <= 0.0)
+            return false;
+
+        const juce::File partial = wavFile.getSiblingFile(wavFile.getFileName() + ".part");
+        partial.deleteFile();
+
+        bool ok = false;
+        {
+            std::unique_ptr<juce::FileOutputStream> stream(partial.createOutputStream());
+            if (stream == nullptr)
+                return false;
+
+            juce::WavAudioFormat wav;
+            std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                (unsigned int) samples.getNumChannels(), 32, {}, 0));
+
+            if (writer != nullptr)
+            {
+                stream.release();   // appartient désormais au writer
+                ok = writer->writeFromAudioSampleBuffer(samples, 0, samples.getNumSamples());
+            }
+        }
+
+        if (!ok || !partial.moveFileTo(wavFile))
+        {
+            partial.deleteFile();
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr juce::int32 fileVersion = 1;
+    static constexpr int maxChannels = 16;
+    static constexpr juce::int64 alignment = 64;
+
+    struct FileHeader
+    {
+        char magic[4];
+        juce::int32 version;
+        juce::int32 numChannels;
+        juce::int32 numSpectra;
+        juce::int64 numSamples;
+        double sampleRate;
+        juce::int64 samplesOffset;
+        juce::int64 metadataOffset;
+        juce::int64 metadataSize;
+        juce::int64 spectraTableOffset;
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "en-tête du conteneur sur 64 octets");
+
+    // Échantillons réservés par canal : un multiple de 16 floats, pour que chaque canal reste aligné
+    static juce::int64 getChannelStride(juce::int64 numSamples) noexcept
+    {
+        return (numSamples + 15) & ~(juce::int64) 15;
+    }
+
+    static juce::int64 align(juce::int64 position) noexcept
+    {
+        return (position + alignment - 1) & ~(alignment - 1);
+    }
+
+    static bool pad(juce::OutputStream& out, juce::int64 numBytes)
+    {
+        return numBytes <= 0 || out.writeRepeatedByte(0, (size_t) numBytes);
+    }
+
+    static bool padTo(juce::OutputStream& out, juce::int64 position)
+    {
+        return pad(out, position - out.getPosition());
+    }
+
+    static bool readHeader(const char* data, juce::int64 fileSize, FileHeader& header)
+    {
+        if (data == nullptr || fileSize < (juce::int64) sizeof(FileHeader))
+            return false;
+
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, "GNIR", 4) != 0 || header.version != fileVersion
+            || header.numChannels < 1 || header.numChannels > maxChannels
+            || header.numSamples < 1 || header.numSamples > std::numeric_limits<int>::max()
+            || header.sampleRate <= 0.0 || header.numSpectra < 0)
+            return false;
+
+        const juce::int64 samplesEnd = header.samplesOffset
+                                     + header.numChannels * getChannelStride(header.numSamples) * (juce::int64) sizeof(float);
+
+        return header.samplesOffset >= (juce::int64) sizeof(FileHeader) && header.samplesOffset % alignment == 0
+            && samplesEnd <= fileSize
+            && header.metadataOffset >= samplesEnd && header.metadataSize >= 0
+            && header.metadataOffset + header.metadataSize <= fileSize
+            && header.spectraTableOffset >= 0
+            && header.spectraTableOffset + header.numSpectra * 2 * (juce::int64) sizeof(juce::int64) <= fileSize;
+    }
+
+    static void readMetadata(const char* data, const FileHeader& header, Contents& contents)
+    {
+        const juce::var metadata = juce::JSON::parse(juce::String::fromUTF8(data + header.metadataOffset,
+                                                                            (int) header.metadataSize));
+
+        contents.hasRecipe = metadata.hasProperty("recipe");
+        if (contents.hasRecipe)
+            contents.recipe = GenIRRecipe::fromVar(metadata["recipe"]);
+
+        contents.hasAnalysis = metadata.hasProperty("analysis");
+        if (contents.hasAnalysis)
+            contents.analysis = IRFeatures::fromVar(metadata["analysis"]);
+    }
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRStore.h"
+#include "RequestPolicy.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Cache local des IRs générées, adressé par le contenu des paramètres de génération.
+// Des paramètres et une seed identiques donnent le même résultat côté serveur : on peut
+// donc répondre depuis le disque sans refaire l'aller-retour réseau.
+// Une seule instance est partagée par tous les plugins du processus (SharedResourcePointer).
+//
+// Les IRs elles-mêmes sont dans le stockage (IRStore) : une entrée du cache n'est qu'une
+// référence (<clé>.ref, nom du fichier rangé). Une IR générée n'existe donc qu'une fois sur le
+// disque, et la seule limite de taille est celle du stockage ; une entrée dont l'IR a été
+// évincée est une absence.
+class GenerationCache
+{
+public:
+    GenerationCache()
+        : cacheDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+            .getChildFile("GenIR").getChildFile("Cache"))
+    {
+        cacheDirectory.createDirectory();
+    }
+
+    // Normalise le prompt : espaces superflus supprimés. La casse est gardée, le tokenizer du
+    // serveur la distingue ; c'est ce prompt normalisé qui est envoyé au serveur.
+    static juce::String canonicalisePrompt(const juce::String& prompt)
+    {
+        juce::StringArray words;
+        words.addTokens(prompt, " \t\r\n", "");
+        words.removeEmptyStrings();
+        return words.joinIntoString(" ");
+    }
+
+    // Clé de cache : empreinte SHA-256 des paramètres tels qu'ils sont envoyés au serveur
+    static juce::String makeKey(const juce::String& prompt, float duration, int steps,
+        float guidanceScale, int seed)
+    {
+        const juce::String canonical = canonicalisePrompt(prompt)
+            + "|" + juce::String(std::to_string(duration))
+            + "|" + juce::String(steps)
+            + "|" + juce::String(std::to_string(guidanceScale))
+            + "|" + juce::String(seed);
+
+        return juce::SHA256(canonical.toUTF8()).toHexString();
+    }
+
+    // Copie l'IR correspondant à la clé à côté de destination, avec l'extension du
+    // format stocké (genir, wav, flac, ogg). Retourne le fichier copié, ou un fichier vide si absente.
+    juce::File fetch(const juce::String& key, const juce::File& destination)
+    {
+        juce::ScopedLock lock(fileLock);
+
+        juce::File entry = findEntryFile(key);
+        if (!entry.existsAsFile())
+            return {};
+
+        juce::File copy = destination.withFileExtension(entry.getFileExtension());
+        if (!entry.copyFileTo(copy))
+            return {};
+
+        // Marquer l'IR comme récemment utilisée pour l'éviction LRU du stockage
+        irStore->touch(entry);
+        return copy;
+    }
+
+    // Indique si une entrée existe pour la clé, sans la copier
+    bool contains(const juce::String& key)
+    {
+        juce::ScopedLock lock(fileLock);
+        return findEntryFile(key).existsAsFile();
+    }
+
+    // Range une copie du fichier généré dans le stockage et y fait pointer la clé
+    void store(const juce::String& key, const juce::File& source)
+    {
+        juce::ScopedLock lock(fileLock);
+        writeReference(key, irStore->addCopy(source));
+    }
+
+    juce::File getDirectory() const
+    {
+        return cacheDirectory;
+    }
+
+    // Réservation d'une clé pendant sa génération.
+    // Les requêtes identiques, de cette instance, d'une autre instance du processus ou d'un
+    // autre processus, attendent la fin de la génération en cours puis relisent le cache :
+    // un seul appel serveur est fait pour toutes.
+    // L'attente est interrompue si le jeton d'annulation est déclenché. onWait est appelé une
+    // fois, avant la première attente, seulement si la clé est déjà tenue par un autre demandeur.
+    class ScopedReservation
+    {
+    public:
+        ScopedReservation(GenerationCache& c, const juce::String& k, CancellationToken* token = nullptr,
+            std::function<void()> onWait = nullptr)
+            : cache(c), key(k), waitCallback(std::move(onWait))
+        {
+            keyLock = cache.getKeyLock(key);
+            processLock = std::make_unique<juce::InterProcessLock>("GenIR_" + key.substring(0, 32));
+
+            try
+            {
+                while (!keyLock->tryEnter())
+                    waitBriefly(token);
+                ownsKeyLock = true;
+
+                while (!processLock->enter(0))
+                    waitBriefly(token);
+                ownsProcessLock = true;
+            }
+            catch (...)
+            {
+                release();
+                throw;
+            }
+        }
+
+        ~ScopedReservation()
+        {
+            release();
+        }
+
+    private:
+        void waitBriefly(CancellationToken* token)
+        {
+            if (waitCallback != nullptr)
+                std::exchange(waitCallback, nullptr)();
+
+            if (token != nullptr)
+                token->sleep("cache", 50);
+            else
+                juce::Thread::sleep(50);
+        }
+
+        void release()
+        {
+            if (ownsProcessLock)
+                processLock->exit();
+
+            if (ownsKeyLock)
+                keyLock->exit();
+
+            ownsProcessLock = ownsKeyLock = false;
+            processLock.reset();
+            keyLock.reset();
+            cache.releaseKeyLock(key);
+        }
+
+        GenerationCache& cache;
+        juce::String key;
+        std::shared_ptr<juce::CriticalSection> keyLock;
+        std::unique_ptr<juce::InterProcessLock> processLock;
+        bool ownsKeyLock = false;
+        bool ownsProcessLock = false;
+        std::function<void()> waitCallback;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedReservation)
+    };
+
+private:
+    static constexpr const char* legacyExtensions[] = { ".genir", ".wav", ".flac", ".ogg" };
+
+    // IR rangée pour la clé, ou File() si la clé est absente ou son IR évincée du stockage
+    juce::File findEntryFile(const juce::String& key)
+    {
+        migrateLegacyEntries();
+
+        const juce::File reference = cacheDirectory.getChildFile(key + ".ref");
+        if (!reference.existsAsFile())
+            return {};
+
+        // Seul un fichier du stockage est accepté, quel que soit le contenu de la référence
+        const juce::File entry = irStore->getDirectory().getChildFile(reference.loadFileAsString().trim());
+        if (irStore->getHash(entry).isNotEmpty() && entry.existsAsFile())
+            return entry;
+
+        reference.deleteFile();
+        return {};
+    }
+
+    void writeReference(const juce::String& key, const juce::File& stored)
+    {
+        if (stored.existsAsFile())
+            cacheDirectory.getChildFile(key + ".ref").replaceWithText(stored.getFileName());
+    }
+
+    // Entrées des versions précédentes, IRs complètes dans le répertoire du cache : rangées dans
+    // le stockage au premier accès (thread de génération), une fois par processus
+    void migrateLegacyEntries()
+    {
+        std::call_once(legacyMigrated, [this]
+            {
+                for (auto* extension : legacyExtensions)
+                {
+                    for (const auto& entry : juce::RangedDirectoryIterator(cacheDirectory, false,
+                                                                          juce::String("*") + extension,
+                                                                          juce::File::findFiles))
+                    {
+                        const juce::File file = entry.getFile();
+                        const juce::File stored = irStore->addCopy(file);
+
+                        if (stored.existsAsFile())
+                        {
+                            writeReference(file.getFileNameWithoutExtension(), stored);
+                            file.deleteFile();
+                        }
+                    }
+                }
+            });
+    }
+
+    std::shared_ptr<juce::CriticalSection> getKeyLock(const juce::String& key)
+    {
+        juce::ScopedLock lock(pendingLock);
+        auto& entry = pending[key];
+        if (entry.first == nullptr)
+            entry.first = std::make_shared<juce::CriticalSection>();
+        ++entry.second;
+        return entry.first;
+    }
+
+    void releaseKeyLock(const juce::String& key)
+    {
+        juce::ScopedLock lock(pendingLock);
+        auto it = pending.find(key);
+        if (it != pending.end() && --it->second == 0)
+            pending.erase(it);
+    }
+
+    juce::File cacheDirectory;
+    juce::SharedResourcePointer<IRStore> irStore;
+    juce::CriticalSection fileLock;
+    std::once_flag legacyMigrated;
+
+    // Verrous par clé des générations en cours dans ce processus, avec leur nombre d'utilisateurs
+    std::map<juce::String, std::pair<std::shared_ptr<juce::CriticalSection>, int>> pending;
+    juce::CriticalSection pendingLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GenerationCache)
+};
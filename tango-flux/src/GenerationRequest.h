@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ImpulseResponse.h"
+#include "ProgressiveStream.h"
+
+#include <memory>
+
+// Demande de génération adressée à un moteur de génération (GenerationBackend) : service du processus,
+// démon GenIR ou synthèse procédurale locale
+struct GenerationRequest
+{
+    juce::String prompt;
+    float duration = 5.0f;
+    int steps = 50;
+    float guidanceScale = 3.5f;
+    int seed = 42;
+    juce::String serverUrl;
+    juce::File outputFile;          // fichier du demandeur ; l'extension suit le format reçu
+    bool speculative = false;       // résultat seulement mis en cache, servi après les vraies demandes
+    int delayMs = 0;                // délai avant de pouvoir démarrer (anti-rebond des prédictions)
+    bool verbose = false;
+
+    // Configuration de la convolution du demandeur : le démon y prépare les spectres de l'IR
+    // une fois pour toute la machine (0 : rien à préparer)
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
+};
+
+// Demandeur : une instance de TangoFluxClient ou son générateur spéculatif.
+// Les notifications arrivent sur un thread du service.
+class GenerationSubscriber
+{
+public:
+    virtual ~GenerationSubscriber() = default;
+    virtual void generationProgress(float progress, const juce::String& stage) = 0;
+    virtual void generationStreamStarted(std::shared_ptr<ProgressiveBuffer> buffer) = 0;
+    virtual void generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse) = 0;
+    virtual void generationFailed(const juce::String& errorMessage) = 0;
+};
+
+// Moteur de génération : service du processus (GenerationService), démon GenIR (DaemonClient)
+// ou synthèse procédurale locale (ProceduralBackend). TangoFluxClient choisit le moteur de
+// chaque demande ; tous notifient leurs demandeurs de la même façon.
+class GenerationBackend
+{
+public:
+    virtual ~GenerationBackend() = default;
+
+    // Soumet ou remplace la demande de subscriber
+    virtual void submit(GenerationSubscriber& subscriber, const GenerationRequest& request) = 0;
+
+    // Après le retour, subscriber ne reçoit plus aucune notification.
+    // Retourne false s'il n'attendait aucune génération.
+    virtual bool cancel(GenerationSubscriber& subscriber) = 0;
+
+    virtual bool isPending(GenerationSubscriber& subscriber) const = 0;
+};
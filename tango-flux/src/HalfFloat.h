@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define GENIR_HALF_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define GENIR_HALF_NEON 1
+#endif
+
+// Précision de stockage des spectres de la queue d'une IR (PreparedIR)
+enum class SpectrumPrecision
+{
+    float32,    // flottants 32 bits, comme la tête
+    float16,    // IEEE 754 binary16 : 11 bits de mantisse, plage réduite
+    bfloat16    // 8 bits de mantisse, plage des float32
+};
+
+// Conversions entre float32 et formats 16 bits. Le rétrécissement (écriture des partitions, hors
+// du thread audio) est scalaire et arrondit au plus proche ; l'élargissement existe aussi par
+// paquets de 4 (SSE2, NEON) pour le noyau de multiplication-accumulation de la convolution.
+//
+// Les float16 sous-normaux ne sont pas utilisés : les valeurs trop petites deviennent 0. Les
+// spectres sont stockés divisés par le maximum de leur partition, ce qui place ce seuil à
+// 84 dB sous le maximum.
+struct HalfFloat
+{
+    static juce::uint16 fromFloat(float value, SpectrumPrecision precision) noexcept
+    {
+        const juce::uint32 bits = toBits(value);
+
+        if (precision == SpectrumPrecision::bfloat16)
+        {
+            // Arrondi au plus proche, à égalité vers le pair
+            return (juce::uint16) ((bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16);
+        }
+
+        const juce::uint32 sign = (bits >> 16) & 0x8000u;
+        const juce::uint32 magnitude = bits & 0x7fffffffu;
+
+        if (magnitude < 0x38800000u)         // sous 2^-14 : sous-normal en float16
+            return (juce::uint16) sign;
+
+        if (magnitude >= 0x477ff000u)        // au-delà de 65504 après arrondi
+            return (juce::uint16) (sign | 0x7bffu);
+
+        const juce::uint32 rounded = magnitude + 0xfffu + ((magnitude >> 13) & 1u);
+        return (juce::uint16) (sign | ((rounded - 0x38000000u) >> 13));
+    }
+
+    static float toFloat(juce::uint16 value, SpectrumPrecision precision) noexcept
+    {
+        if (precision == SpectrumPrecision::bfloat16)
+            return fromBits((juce::uint32) value << 16);
+
+        const juce::uint32 magnitude = value & 0x7fffu;
+        const juce::uint32 sign = (juce::uint32) (value & 0x8000u) << 16;
+        return fromBits(magnitude == 0 ? sign : sign | ((magnitude << 13) + 0x38000000u));
+    }
+
+   #if GENIR_HALF_SSE2
+    // 4 valeurs consécutives élargies
+    static __m128 toFloat4(const juce::uint16* values, SpectrumPrecision precision) noexcept
+    {
+        const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+
+        if (precision == SpectrumPrecision::bfloat16)
+            return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), packed));
+
+        const __m128i wide = _mm_unpacklo_epi16(packed, _mm_setzero_si128());
+        const __m128i magnitude = _mm_and_si128(wide, _mm_set1_epi32(0x7fff));
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(wide, _mm_set1_epi32(0x8000)), 16);
+        const __m128i rebased = _mm_add_epi32(_mm_slli_epi32(magnitude, 13), _mm_set1_epi32(0x38000000));
+        const __m128i isZero = _mm_cmpeq_epi32(magnitude, _mm_setzero_si128());
+
+        return _mm_castsi128_ps(_mm_or_si128(sign, _mm_andnot_si128(isZero, rebased)));
+    }
+   #elif GENIR_HALF_NEON
+    static float32x4_t toFloat4(const juce::uint16* values, SpectrumPrecision precision) noexcept
+    {
+        const uint32x4_t wide = vmovl_u16(vld1_u16(values));
+
+        if (precision == SpectrumPrecision::bfloat16)
+            return vreinterpretq_f32_u32(vshlq_n_u32(wide, 16));
+
+        const uint32x4_t magnitude = vandq_u32(wide, vdupq_n_u32(0x7fff));
+        const uint32x4_t sign = vshlq_n_u32(vandq_u32(wide, vdupq_n_u32(0x8000)), 16);
+        const uint32x4_t rebased = vaddq_u32(vshlq_n_u32(magnitude, 13), vdupq_n_u32(0x38000000));
+        const uint32x4_t isZero = vceqq_u32(magnitude, vdupq_n_u32(0));
+
+        return vreinterpretq_f32_u32(vorrq_u32(sign, vbicq_u32(rebased, isZero)));
+    }
+   #endif
+
+private:
+    static juce::uint32 toBits(float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static float fromBits(juce::uint32 bits) noexcept
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
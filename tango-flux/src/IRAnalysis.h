@@ -0,0 +1,265 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+// Descripteurs acoustiques d'une IR, calculés une fois à l'indexation de la bibliothèque
+// (IRLibrary) et conservés dans son index. toVector() en fait un vecteur compact pour la
+// recherche d'IRs semblables (SimilarityIndex).
+struct IRFeatures
+{
+    static constexpr int numBands = 7;                  // octaves de 125 Hz à 8 kHz
+    static constexpr int numDecayPoints = 8;
+    static constexpr std::array<double, numBands> bandFrequencies { 125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 8000.0 };
+    static constexpr std::array<double, numDecayPoints> decayTimes { 0.01, 0.02, 0.04, 0.08, 0.16, 0.32, 0.64, 1.28 };   // s après le son direct
+
+    double peakDb = -100.0;
+    double rmsDb = -100.0;
+    double rt60 = 0.0;              // s, estimé par la pente de la courbe de Schroeder (T30)
+    double spectralCentroid = 0.0;  // Hz, pondéré par l'énergie
+    std::array<double, numBands> t30 {};    // s, par octave (0 : non mesurable)
+    std::array<double, numBands> edt {};    // s, temps de décroissance initial (0 à -10 dB, × 6)
+    double c80 = 0.0;                       // dB, clarté : énergie avant / après 80 ms
+    std::array<double, numDecayPoints> decayCurve {};   // dB, courbe de Schroeder aux instants decayTimes
+
+    static constexpr int vectorSize = 2 * numBands + 2 + numDecayPoints;
+
+    // Vecteur de comparaison : temps de réverbération en logarithme (un écart relatif compte
+    // autant pour une petite salle que pour une grande), clarté et courbe de décroissance en dB
+    std::array<float, vectorSize> toVector() const
+    {
+        std::array<float, vectorSize> vector {};
+        size_t i = 0;
+
+        const double fallback = rt60 > 0.0 ? rt60 : 0.5;
+
+        for (auto t : t30)
+            vector[i++] = (float) std::log(t > 0.0 ? t : fallback);
+
+        for (auto t : edt)
+            vector[i++] = (float) std::log(t > 0.0 ? t : fallback);
+
+        vector[i++] = (float) c80;
+        vector[i++] = (float) std::log2(juce::jmax(20.0, spectralCentroid) / 1000.0);
+
+        for (auto level : decayCurve)
+            vector[i++] = (float) level;
+
+        return vector;
+    }
+
+    juce::var toVar() const
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("peakDb", peakDb);
+        object->setProperty("rmsDb", rmsDb);
+        object->setProperty("rt60", rt60);
+        object->setProperty("centroid", spectralCentroid);
+        object->setProperty("t30", arrayToVar(t30));
+        object->setProperty("edt", arrayToVar(edt));
+        object->setProperty("c80", c80);
+        object->setProperty("decay", arrayToVar(decayCurve));
+        return juce::var(object);
+    }
+
+    static IRFeatures fromVar(const juce::var& value)
+    {
+        IRFeatures features;
+        features.peakDb = value.getProperty("peakDb", -100.0);
+        features.rmsDb = value.getProperty("rmsDb", -100.0);
+        features.rt60 = value.getProperty("rt60", 0.0);
+        features.spectralCentroid = value.getProperty("centroid", 0.0);
+        varToArray(value["t30"], features.t30);
+        varToArray(value["edt"], features.edt);
+        features.c80 = value.getProperty("c80", 0.0);
+        varToArray(value["decay"], features.decayCurve);
+        return features;
+    }
+
+private:
+    template <size_t size>
+    static juce::var arrayToVar(const std::array<double, size>& values)
+    {
+        juce::Array<juce::var> list;
+        for (auto v : values)
+            list.add(v);
+        return list;
+    }
+
+    template <size_t size>
+    static void varToArray(const juce::var& value, std::array<double, size>& values)
+    {
+        if (auto* list = value.getArray())
+            for (int i = 0; i < juce::jmin((int) size, list->size()); ++i)
+                values[(size_t) i] = (*list)[i];
+    }
+};
+
+class IRAnalysis
+{
+public:
+    static IRFeatures analyse(const juce::AudioBuffer<float>& samples, double sampleRate)
+    {
+        IRFeatures features;
+        const int numSamples = samples.getNumSamples();
+        const int numChannels = samples.getNumChannels();
+
+        if (numSamples == 0 || numChannels == 0 || sampleRate <= 0.0)
+            return features;
+
+        // Mono : moyenne des canaux
+        std::vector<float> mono((size_t) numSamples, 0.0f);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = samples.getReadPointer(ch);
+            for (int i = 0; i < numSamples; ++i)
+                mono[(size_t) i] += data[i] / (float) numChannels;
+        }
+
+        double peak = 0.0, energy = 0.0;
+        for (auto s : mono)
+        {
+            peak = juce::jmax(peak, (double) std::abs(s));
+            energy += (double) s * s;
+        }
+
+        features.peakDb = juce::Decibels::gainToDecibels(peak, -100.0);
+        features.rmsDb = juce::Decibels::gainToDecibels(std::sqrt(energy / numSamples), -100.0);
+        features.rt60 = estimateRT60(mono.data(), numSamples, sampleRate);
+        features.spectralCentroid = computeCentroid(mono.data(), numSamples, sampleRate);
+
+        // Son direct : le pic ; la clarté et la courbe de décroissance se mesurent à partir de lui
+        int directIndex = 0;
+        for (int i = 1; i < numSamples; ++i)
+            if (std::abs(mono[(size_t) i]) > std::abs(mono[(size_t) directIndex]))
+                directIndex = i;
+
+        const float* fromDirect = mono.data() + directIndex;
+        const int decayLength = numSamples - directIndex;
+
+        features.c80 = computeClarity(fromDirect, decayLength, sampleRate);
+
+        const std::vector<double> decay = computeDecayCurve(fromDirect, decayLength);
+        for (int p = 0; p < IRFeatures::numDecayPoints; ++p)
+        {
+            const int index = (int) (IRFeatures::decayTimes[(size_t) p] * sampleRate);
+            features.decayCurve[(size_t) p] = index < decayLength ? decay[(size_t) index] : -100.0;
+        }
+
+        // Temps de réverbération par octave
+        std::vector<float> band((size_t) decayLength);
+
+        for (int b = 0; b < IRFeatures::numBands; ++b)
+        {
+            const double frequency = IRFeatures::bandFrequencies[(size_t) b];
+            if (frequency >= sampleRate * 0.45)
+                continue;
+
+            juce::IIRFilter filter;
+            filter.setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, frequency, 1.41));
+            std::copy(fromDirect, fromDirect + decayLength, band.begin());
+            filter.processSamples(band.data(), decayLength);
+
+            const std::vector<double> bandDecay = computeDecayCurve(band.data(), decayLength);
+            features.t30[(size_t) b] = fitDecay(bandDecay, sampleRate, -5.0, -35.0);
+            features.edt[(size_t) b] = fitDecay(bandDecay, sampleRate, 0.0, -10.0);
+        }
+
+        return features;
+    }
+
+    // Courbe de Schroeder (énergie restante, intégrée à rebours) en dB, 0 dB au début
+    static std::vector<double> computeDecayCurve(const float* data, int numSamples)
+    {
+        std::vector<double> decay((size_t) numSamples);
+        double sum = 0.0;
+
+        for (int i = numSamples; --i >= 0;)
+        {
+            sum += (double) data[i] * data[i];
+            decay[(size_t) i] = sum;
+        }
+
+        for (auto& d : decay)
+            d = sum > 0.0 ? 10.0 * std::log10(juce::jmax(d / sum, 1.0e-12)) : -120.0;
+
+        return decay;
+    }
+
+    // Temps de décroissance de 60 dB extrapolé de la pente entre upper et lower dB (moindres
+    // carrés). 0 si la courbe n'atteint pas lower.
+    static double fitDecay(const std::vector<double>& decay, double sampleRate, double upper, double lower)
+    {
+        double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        bool reachedLower = false;
+
+        for (size_t i = 0; i < decay.size(); ++i)
+        {
+            const double level = decay[i];
+            if (level > upper)
+                continue;
+
+            if (level < lower)
+            {
+                reachedLower = true;
+                break;
+            }
+
+            const double t = (double) i / sampleRate;
+            n += 1.0; sx += t; sy += level; sxx += t * t; sxy += t * level;
+        }
+
+        const double denominator = n * sxx - sx * sx;
+        if (!reachedLower || n < 10.0 || denominator <= 0.0)
+            return 0.0;
+
+        const double slope = (n * sxy - sx * sy) / denominator;   // dB/s
+        return slope < 0.0 ? -60.0 / slope : 0.0;
+    }
+
+    // C80 : énergie des 80 premières millisecondes sur celle du reste, en dB
+    static double computeClarity(const float* data, int numSamples, double sampleRate)
+    {
+        const int split = juce::jmin(numSamples, (int) (0.08 * sampleRate));
+        double early = 0.0, late = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+            (i < split ? early : late) += (double) data[i] * data[i];
+
+        return 10.0 * std::log10(juce::jmax(early, 1.0e-12) / juce::jmax(late, 1.0e-12));
+    }
+
+    // T30 : régression de la courbe de décroissance intégrée (Schroeder) entre -5 et -35 dB,
+    // extrapolée à -60 dB. Si la dynamique manque, T20 (-5 à -25 dB).
+    static double estimateRT60(const float* data, int numSamples, double sampleRate)
+    {
+        const std::vector<double> decay = computeDecayCurve(data, numSamples);
+        const double t30 = fitDecay(decay, sampleRate, -5.0, -35.0);
+        return t30 > 0.0 ? t30 : fitDecay(decay, sampleRate, -5.0, -25.0);
+    }
+
+    // Barycentre du spectre d'énergie, sur les 2^16 premiers échantillons au plus
+    static double computeCentroid(const float* data, int numSamples, double sampleRate)
+    {
+        const int order = juce::jlimit(4, 16, (int) std::ceil(std::log2((double) juce::jmax(2, numSamples))));
+        const int size = 1 << order;
+
+        juce::dsp::FFT fft(order);
+        std::vector<float> buffer((size_t) (2 * size), 0.0f);
+        std::copy(data, data + juce::jmin(numSamples, size), buffer.begin());
+        fft.performFrequencyOnlyForwardTransform(buffer.data(), true);
+
+        double weighted = 0.0, total = 0.0;
+        for (int bin = 1; bin <= size / 2; ++bin)
+        {
+            const double power = (double) buffer[(size_t) bin] * buffer[(size_t) bin];
+            weighted += power * bin * sampleRate / size;
+            total += power;
+        }
+
+        return total > 0.0 ? weighted / total : 0.0;
+    }
+};
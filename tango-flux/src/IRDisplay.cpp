@@ -0,0 +1,266 @@
+#include "IRDisplay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+IRDisplay::IRDisplay(GenIRAudioProcessor& p)
+    : audioProcessor(p),
+    overviews(p.getIROverviewCache())
+{
+    setOpaque(true);
+
+    // Spectrogram colours, from silence (dark blue) to the loudest band (pale yellow)
+    juce::ColourGradient gradient(juce::Colour(0xFF101020), 0.0f, 0.0f, juce::Colour(0xFFFFF0A0), 1.0f, 0.0f, false);
+    gradient.addColour(0.35, juce::Colour(0xFF3A1C71));
+    gradient.addColour(0.65, juce::Colour(0xFFD76D77));
+    gradient.addColour(0.85, juce::Colour(0xFFFFAF7B));
+
+    for (size_t i = 0; i < palette.size(); ++i)
+        palette[i] = gradient.getColourAtPosition((double) i / (palette.size() - 1));
+
+    overviews.addChangeListener(this);
+
+    // The processor does not announce IR changes to the UI: poll the loaded IR (a pointer copy)
+    startTimerHz(4);
+    refreshOverview();
+}
+
+IRDisplay::~IRDisplay()
+{
+    stopTimer();
+    overviews.removeChangeListener(this);
+}
+
+void IRDisplay::timerCallback()
+{
+    refreshOverview();
+}
+
+void IRDisplay::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    // An overview has been computed, possibly the one this display is waiting for
+    refreshOverview();
+}
+
+void IRDisplay::refreshOverview()
+{
+    auto current = audioProcessor.getCurrentImpulseResponse();
+
+    if (current != displayedIR.lock() || (current == nullptr && overview != nullptr))
+    {
+        displayedIR = current;
+        overview.reset();
+        spectrogramDirty = true;
+        repaint();
+    }
+
+    if (current == nullptr || overview != nullptr)
+        return;
+
+    overview = overviews.get(current);
+
+    if (overview != nullptr)
+    {
+        // New IR: show all of it
+        viewStart = 0.0;
+        viewLength = (double) overview->numSamples;
+        spectrogramDirty = true;
+        repaint();
+    }
+}
+
+void IRDisplay::setView(double start, double length)
+{
+    if (overview == nullptr || getWidth() <= 0)
+        return;
+
+    // No closer than one level-0 bucket per pixel
+    const double total = (double) overview->numSamples;
+    const double minLength = juce::jmin(total, (double) IROverview::baseBucketSize * getWidth());
+
+    length = juce::jlimit(minLength, total, length);
+    start = juce::jlimit(0.0, total - length, start);
+
+    if (start == viewStart && length == viewLength)
+        return;
+
+    viewStart = start;
+    viewLength = length;
+    spectrogramDirty = true;
+    repaint();
+}
+
+void IRDisplay::mouseDown(const juce::MouseEvent&)
+{
+    dragStartView = viewStart;
+}
+
+void IRDisplay::mouseDrag(const juce::MouseEvent& e)
+{
+    if (getWidth() > 0)
+        setView(dragStartView - e.getDistanceFromDragStartX() * viewLength / getWidth(), viewLength);
+}
+
+void IRDisplay::mouseDoubleClick(const juce::MouseEvent&)
+{
+    if (overview != nullptr)
+        setView(0.0, (double) overview->numSamples);
+}
+
+void IRDisplay::mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    if (overview == nullptr || getWidth() <= 0)
+        return;
+
+    // Zoom around the sample under the pointer
+    const double anchor = viewStart + viewLength * e.position.x / getWidth();
+    const double factor = std::pow(2.0, -wheel.deltaY * 4.0);
+
+    setView(anchor - (anchor - viewStart) * factor, viewLength * factor);
+}
+
+void IRDisplay::resized()
+{
+    auto area = getLocalBounds();
+    waveformArea = area.removeFromTop(area.getHeight() * 2 / 5);
+    area.removeFromTop(2);
+    spectrogramArea = area;
+
+    spectrogramDirty = true;
+
+    // Keep at least one bucket per pixel after a resize
+    setView(viewStart, viewLength);
+}
+
+void IRDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(0xFF222222));
+
+    if (overview == nullptr)
+    {
+        g.setColour(juce::Colours::grey);
+        g.setFont(14.0f);
+        g.drawText(displayedIR.expired() ? "No IR loaded" : "Analysing IR...", getLocalBounds(), juce::Justification::centred);
+        return;
+    }
+
+    paintWaveform(g, waveformArea);
+
+    if (spectrogramDirty)
+        renderSpectrogram(spectrogramArea.getWidth(), spectrogramArea.getHeight());
+
+    if (spectrogramImage.isValid())
+        g.drawImageAt(spectrogramImage, spectrogramArea.getX(), spectrogramArea.getY());
+
+    g.setFont(11.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.7f));
+
+    // Frequency marks on the spectrogram
+    const double nyquist = overview->sampleRate * 0.5;
+    for (double frequency : { 100.0, 1000.0, 10000.0 })
+    {
+        if (frequency >= nyquist)
+            continue;
+
+        const double position = std::log(frequency / IROverview::minFrequency) / std::log(nyquist / IROverview::minFrequency);
+        const int y = spectrogramArea.getBottom() - juce::roundToInt(position * spectrogramArea.getHeight());
+        g.drawHorizontalLine(y, (float) spectrogramArea.getX(), (float) spectrogramArea.getX() + 6.0f);
+        g.drawText(frequency >= 1000.0 ? juce::String(frequency / 1000.0, 0) + " kHz" : juce::String(frequency, 0) + " Hz",
+            spectrogramArea.getX() + 8, y - 7, 60, 14, juce::Justification::centredLeft);
+    }
+
+    // Visible time range
+    const double start = viewStart / overview->sampleRate;
+    const double end = (viewStart + viewLength) / overview->sampleRate;
+    auto labels = waveformArea.reduced(4, 2).removeFromBottom(14);
+    g.drawText(juce::String(start, 3) + " s", labels, juce::Justification::centredLeft);
+    g.drawText(juce::String(end, 3) + " s", labels, juce::Justification::centredRight);
+}
+
+void IRDisplay::paintWaveform(juce::Graphics& g, juce::Rectangle<int> area)
+{
+    const int width = area.getWidth();
+    const int numChannels = juce::jmax(1, overview->numChannels);
+    const int laneHeight = area.getHeight() / numChannels;
+
+    if (width <= 0 || laneHeight <= 0)
+        return;
+
+    const double samplesPerPixel = viewLength / width;
+    const float scale = overview->peak > 0.0f ? 1.0f / overview->peak : 1.0f;
+
+    for (int ch = 0; ch < overview->numChannels; ++ch)
+    {
+        const auto lane = juce::Rectangle<int>(area.getX(), area.getY() + ch * laneHeight, width, laneHeight).reduced(0, 2);
+        const float centre = (float) lane.getCentreY();
+        const float halfHeight = lane.getHeight() * 0.5f;
+
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+        g.drawHorizontalLine(lane.getCentreY(), (float) lane.getX(), (float) lane.getRight());
+
+        // One min/max pair per pixel column, taken from the matching pyramid level
+        g.setColour(juce::Colour(0xFF7FB2E5));
+        for (int x = 0; x < width; ++x)
+        {
+            const auto first = (juce::int64) (viewStart + x * samplesPerPixel);
+            const auto last = juce::jmax(first + 1, (juce::int64) (viewStart + (x + 1) * samplesPerPixel));
+            const auto range = overview->getRange(ch, first, last);
+
+            const float top = centre - range.getEnd() * scale * halfHeight;
+            const float bottom = centre - range.getStart() * scale * halfHeight;
+            g.drawVerticalLine(lane.getX() + x, top, juce::jmax(bottom, top + 1.0f));
+        }
+    }
+}
+
+void IRDisplay::renderSpectrogram(int width, int height)
+{
+    spectrogramDirty = false;
+
+    if (width <= 0 || height <= 0)
+    {
+        spectrogramImage = {};
+        return;
+    }
+
+    if (!spectrogramImage.isValid() || spectrogramImage.getWidth() != width || spectrogramImage.getHeight() != height)
+        spectrogramImage = juce::Image(juce::Image::RGB, width, height, false);
+
+    const double samplesPerPixel = viewLength / width;
+    const int level = overview->getSpectrogramLevel(samplesPerPixel);
+    const int numFrames = overview->getNumFrames(level);
+    const double samplesPerFrame = (double) (IROverview::hopSize << level);
+
+    if (numFrames <= 0)
+    {
+        spectrogramImage.clear(spectrogramImage.getBounds(), palette[0]);
+        return;
+    }
+
+    // Band shown on each row, lowest band at the bottom
+    std::vector<int> rowBands((size_t) height);
+    for (int y = 0; y < height; ++y)
+        rowBands[(size_t) y] = juce::jlimit(0, IROverview::numBands - 1, (height - 1 - y) * IROverview::numBands / height);
+
+    std::array<juce::uint8, IROverview::numBands> column;
+    juce::Image::BitmapData pixels(spectrogramImage, juce::Image::BitmapData::writeOnly);
+
+    for (int x = 0; x < width; ++x)
+    {
+        // The chosen level has at most two columns per pixel: keep the loudest of those covered
+        const int first = juce::jlimit(0, numFrames - 1, (int) ((viewStart + x * samplesPerPixel) / samplesPerFrame));
+        const int last = juce::jlimit(first, numFrames - 1, (int) std::ceil((viewStart + (x + 1) * samplesPerPixel) / samplesPerFrame) - 1);
+
+        std::copy_n(overview->getColumn(level, first), IROverview::numBands, column.begin());
+        for (int frame = first + 1; frame <= last; ++frame)
+        {
+            const juce::uint8* values = overview->getColumn(level, frame);
+            for (int band = 0; band < IROverview::numBands; ++band)
+                column[(size_t) band] = juce::jmax(column[(size_t) band], values[band]);
+        }
+
+        for (int y = 0; y < height; ++y)
+            pixels.setPixelColour(x, y, palette[column[(size_t) rowBands[(size_t) y]]]);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <array>
+#include <memory>
+
+// Waveform and spectrogram of the IR loaded in the processor.
+// Drawn only from the IR's overview (IROverviewCache), which is computed on a background
+// thread and shared by all open editors: painting never scans the IR's samples.
+// Mouse wheel zooms around the pointer, dragging scrolls, double-click shows the whole IR.
+class IRDisplay : public juce::Component,
+    private juce::Timer,
+    private juce::ChangeListener
+{
+public:
+    IRDisplay(GenIRAudioProcessor&);
+    ~IRDisplay() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+    void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    void timerCallback() override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+
+    // Picks up a newly loaded IR and its overview once it is ready
+    void refreshOverview();
+
+    // Clamps and applies the visible range, in samples
+    void setView(double start, double length);
+
+    void paintWaveform(juce::Graphics&, juce::Rectangle<int> area);
+    void renderSpectrogram(int width, int height);
+
+    GenIRAudioProcessor& audioProcessor;
+    IROverviewCache& overviews;
+
+    // Only a weak reference: an IR replaced in the processor must be freed, not kept alive here
+    std::weak_ptr<const ImpulseResponse> displayedIR;
+    std::shared_ptr<const IROverview> overview;
+
+    // Visible range, in samples
+    double viewStart = 0.0;
+    double viewLength = 0.0;
+    double dragStartView = 0.0;
+
+    juce::Rectangle<int> waveformArea;
+    juce::Rectangle<int> spectrogramArea;
+
+    // Spectrogram rendered for the current view, redrawn only when the view changes
+    juce::Image spectrogramImage;
+    bool spectrogramDirty = true;
+    std::array<juce::Colour, 256> palette;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRDisplay)
+};
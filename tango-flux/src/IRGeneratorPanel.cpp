@@ -3,6 +3,7 @@
 IRGeneratorPanel::IRGeneratorPanel(GenIRAudioProcessor& p)
     : audioProcessor(p),
     keywordsTabs(juce::TabbedButtonBar::TabsAtTop),
+    nextRandomSeed(juce::Random::getSystemRandom().nextInt(1000000)),
     progress(0.0),
     progressBar(progress)
 {
@@ -111,6 +112,38 @@ IRGeneratorPanel::IRGeneratorPanel(GenIRAudioProcessor& p)
     // Disable seed control if random mode is activated
     seedTextEditor.setEnabled(!randomSeedToggle.getToggleState());
 
+    // Setup speculative generation toggle
+    speculativeToggle.setButtonText("Prefetch");
+    speculativeToggle.setTooltip("Start generating in the background while you edit, so Generate is faster");
+    speculativeToggle.setToggleState(audioProcessor.isSpeculativeGenerationEnabled(), juce::dontSendNotification);
+    speculativeToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    speculativeToggle.addListener(this);
+    addAndMakeVisible(speculativeToggle);
+
+    // Generation backend: TangoFlux servers, with or without a local procedural fallback, or local only
+    backendComboBox.addItem("TangoFlux server", 1 + (int) TangoFluxClient::BackendMode::remote);
+    backendComboBox.addItem("Server, offline draft", 1 + (int) TangoFluxClient::BackendMode::remoteWithFallback);
+    backendComboBox.addItem("Procedural (instant)", 1 + (int) TangoFluxClient::BackendMode::procedural);
+    backendComboBox.setSelectedId(1 + (int) audioProcessor.getGenerationBackend(), juce::dontSendNotification);
+    backendComboBox.addListener(this);
+    addAndMakeVisible(backendComboBox);
+
+    // Early reflections: generated by the model, or computed from the room geometry (image sources)
+    earlyReflectionsComboBox.addItem("Generated reflections", 1);
+    for (int order : { 2, 4, 6, 8, 12 })
+        earlyReflectionsComboBox.addItem("Image sources, order " + juce::String(order), 1 + order);
+    {
+        const auto earlyReflections = audioProcessor.getEarlyReflections();
+        earlyReflectionsComboBox.setSelectedId(earlyReflections.enabled ? 1 + earlyReflections.maxOrder : 1, juce::dontSendNotification);
+    }
+    earlyReflectionsComboBox.setTooltip("Replace the start of generated IRs with reflections computed from the room described by the prompt");
+    earlyReflectionsComboBox.addListener(this);
+    addAndMakeVisible(earlyReflectionsComboBox);
+
+    // Any edit of the prompt (typing, keyword buttons, examples) restarts the speculative debounce
+    promptEditor.onTextChange = [this] { requestSpeculativeGeneration(); };
+    seedTextEditor.onTextChange = [this] { requestSpeculativeGeneration(); };
+
     // Setup generation button
     generateButton.setButtonText("Generate IR");
     generateButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF4CAF50));
@@ -169,13 +202,14 @@ IRGeneratorPanel::IRGeneratorPanel(GenIRAudioProcessor& p)
     // Initialize keyword categories
     initializeKeywordsCategories();
 
-    // Start timer to update status
-    startTimer(100);
+    // Status updates are pushed by the processor; show the current state once
+    audioProcessor.getStatusChannel().addChangeListener(this);
+    updateGenerationStatus();
 }
 
 IRGeneratorPanel::~IRGeneratorPanel()
 {
-    stopTimer();
+    audioProcessor.getStatusChannel().removeChangeListener(this);
 }
 
 void IRGeneratorPanel::paint(juce::Graphics& g)
@@ -227,6 +261,8 @@ void IRGeneratorPanel::resized()
     // Seed and random seed toggle
     auto seedArea = area.removeFromTop(30);
     seedLabel.setBounds(seedArea.removeFromLeft(100));
+    speculativeToggle.setBounds(seedArea.removeFromRight(100));
+    backendComboBox.setBounds(seedArea.removeFromRight(170).reduced(5, 2));
     randomSeedToggle.setBounds(seedArea.removeFromRight(150));
     seedTextEditor.setBounds(seedArea);
 
@@ -269,6 +305,7 @@ void IRGeneratorPanel::resized()
 
     bottomArea.removeFromBottom(10);
 
+    earlyReflectionsComboBox.setBounds(bottomArea.removeFromLeft(200).withSizeKeepingCentre(200, 28));
     generateButton.setBounds(bottomArea.reduced(50, 0));
 }
 
@@ -276,12 +313,21 @@ void IRGeneratorPanel::buttonClicked(juce::Button* button)
 {
     if (button == &generateButton)
     {
-        startGeneration();
+        if (audioProcessor.isTangoFluxGenerating())
+            audioProcessor.cancelTangoFluxGeneration();
+        else
+            startGeneration();
     }
     else if (button == &randomSeedToggle)
     {
         // Enable/disable seed control based on checkbox state
         seedTextEditor.setEnabled(!randomSeedToggle.getToggleState());
+        requestSpeculativeGeneration();
+    }
+    else if (button == &speculativeToggle)
+    {
+        audioProcessor.setSpeculativeGenerationEnabled(speculativeToggle.getToggleState());
+        requestSpeculativeGeneration();
     }
     else if (button == &applyExampleButton)
     {
@@ -356,21 +402,29 @@ void IRGeneratorPanel::onKeywordButtonClicked(juce::Button* button)
 
 void IRGeneratorPanel::sliderValueChanged(juce::Slider* slider)
 {
-    // Handle slider value changes if needed
+    // Generation parameters changed: the speculative result must match them
     juce::ignoreUnused(slider);
+    requestSpeculativeGeneration();
 }
 
 void IRGeneratorPanel::comboBoxChanged(juce::ComboBox* comboBox)
 {
-    // Handle combo box changes if needed
-    juce::ignoreUnused(comboBox);
+    if (comboBox == &backendComboBox)
+    {
+        audioProcessor.setGenerationBackend((TangoFluxClient::BackendMode) (backendComboBox.getSelectedId() - 1));
+    }
+    else if (comboBox == &earlyReflectionsComboBox)
+    {
+        auto earlyReflections = audioProcessor.getEarlyReflections();
+        earlyReflections.enabled = earlyReflectionsComboBox.getSelectedId() > 1;
+        if (earlyReflections.enabled)
+            earlyReflections.maxOrder = earlyReflectionsComboBox.getSelectedId() - 1;
+        audioProcessor.setEarlyReflections(earlyReflections);
+    }
 }
 
 void IRGeneratorPanel::startGeneration()
 {
-    // Disable button during generation
-    generateButton.setEnabled(false);
-
     // Generation parameters
     juce::String prompt = promptEditor.getText();
     float duration = (float)durationSlider.getValue();
@@ -378,41 +432,67 @@ void IRGeneratorPanel::startGeneration()
     float guidanceScale = (float)guidanceSlider.getValue();
 
     // Determine which seed to use
-    int seed;
+    int seed = getGenerationSeed();
     if (randomSeedToggle.getToggleState())
     {
-        // Generate random seed
-        juce::Random random;
-        seed = random.nextInt(1000000);
-
-        // Update seed display for information
+        // Update seed display for information, and draw the seed of the next generation
         seedTextEditor.setText(juce::String(seed), false);
-    }
-    else
-    {
-        // Use user-defined seed
-        seed = seedTextEditor.getText().getIntValue();
+        nextRandomSeed = juce::Random::getSystemRandom().nextInt(1000000);
     }
 
     // Start generation
     audioProcessor.generateTangoFluxIR(prompt, duration, steps, guidanceScale, seed);
 }
 
+int IRGeneratorPanel::getGenerationSeed() const
+{
+    // Random mode uses a seed drawn in advance, user-defined mode the seed field
+    if (randomSeedToggle.getToggleState())
+        return nextRandomSeed;
+
+    return seedTextEditor.getText().getIntValue();
+}
+
+void IRGeneratorPanel::requestSpeculativeGeneration()
+{
+    // The client waits for the edits to settle before contacting the server
+    if (!speculativeToggle.getToggleState() || audioProcessor.isTangoFluxGenerating())
+        return;
+
+    audioProcessor.prefetchTangoFluxIR(promptEditor.getText(),
+        (float)durationSlider.getValue(),
+        (int)stepsSlider.getValue(),
+        (float)guidanceSlider.getValue(),
+        getGenerationSeed());
+}
+
 void IRGeneratorPanel::updateGenerationStatus()
 {
+    // One consistent snapshot; nothing to do if it hasn't changed since the last update
+    const auto status = audioProcessor.getStatusChannel().read();
+    if (status.version == lastStatusVersion)
+        return;
+
+    lastStatusVersion = status.version;
+
     // Update progress bar
-    progress = audioProcessor.getTangoFluxProgress();
-    progressBar.setVisible(audioProcessor.isTangoFluxGenerating());
+    progress = status.progress;
+    progressBar.setVisible(status.generating);
 
     // Update status label
-    statusLabel.setText(audioProcessor.getTangoFluxStatus(), juce::dontSendNotification);
+    statusLabel.setText(status.message, juce::dontSendNotification);
 
-    // Enable/disable generation button
-    generateButton.setEnabled(!audioProcessor.isTangoFluxGenerating());
+    // The generation button doubles as a Cancel button while a generation is running
+    const bool generating = status.generating;
+    generateButton.setButtonText(generating ? "Cancel" : "Generate IR");
+    generateButton.setColour(juce::TextButton::buttonColourId,
+        generating ? juce::Colour(0xFFC0392B) : juce::Colour(0xFF4CAF50));
 }
 
-void IRGeneratorPanel::timerCallback()
+void IRGeneratorPanel::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
+    // Called on the message thread after the processor published a new status
+    juce::ignoreUnused(source);
     updateGenerationStatus();
 }
 
@@ -8,7 +8,7 @@ class IRGeneratorPanel : public juce::Component,
     private juce::Button::Listener,
     private juce::Slider::Listener,
     private juce::ComboBox::Listener,
-    private juce::Timer
+    private juce::ChangeListener
 {
 public:
     IRGeneratorPanel(GenIRAudioProcessor&);
@@ -16,7 +16,6 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
-    void timerCallback() override;
 
 private:
     GenIRAudioProcessor& audioProcessor;
@@ -42,9 +41,20 @@ private:
     juce::Label seedLabel;
     juce::TextEditor seedTextEditor;
     juce::ToggleButton randomSeedToggle;
+    int nextRandomSeed; // Drawn ahead of time so speculative generations use the seed Generate will use
+
+    // Speculative generation while the prompt is being edited
+    juce::ToggleButton speculativeToggle;
+
+    // Generation backend (server, server with offline draft, procedural)
+    juce::ComboBox backendComboBox;
+
+    // Early reflections: generated, or image sources up to a given order
+    juce::ComboBox earlyReflectionsComboBox;
 
     juce::TextButton generateButton;
     double progress; // Progress bar variable
+    juce::uint32 lastStatusVersion = 0; // Version of the processor status shown by the controls
     juce::ProgressBar progressBar;
     juce::Label statusLabel;
 
@@ -62,9 +72,12 @@ private:
     void buttonClicked(juce::Button* button) override;
     void sliderValueChanged(juce::Slider* slider) override;
     void comboBoxChanged(juce::ComboBox* comboBox) override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
     // IR generation methods
     void startGeneration();
+    void requestSpeculativeGeneration();
+    int getGenerationSeed() const;
     void updateGenerationStatus();
 
     // Keyword methods
@@ -0,0 +1,663 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRAnalysis.h"
+#include "ImpulseResponse.h"
+#include "SimilarityIndex.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <poll.h>
+ #include <sys/eventfd.h>
+ #include <sys/inotify.h>
+ #include <unistd.h>
+#endif
+
+// Bibliothèque des IRs du disque (répertoire des IRs du plugin, IRs générées), partagée par
+// toutes les instances du processus (SharedResourcePointer).
+//
+// L'index est persistant (library.json dans le répertoire de l'application) : chemin,
+// empreinte du contenu, durée, fréquence d'échantillonnage, canaux, description et seed
+// quand l'IR a été générée ici, et descripteurs acoustiques (IRAnalysis), qui servent aussi à
+// trouver les IRs semblables à une autre (findSimilar). Au démarrage, il est
+// relu en arrière-plan ; seuls les fichiers nouveaux ou modifiés (date, taille) sont ensuite
+// décodés et analysés. Sous Linux, inotify signale chaque fichier ajouté, modifié ou supprimé ;
+// ailleurs, et en filet de sécurité, les racines sont reparcourues périodiquement.
+//
+// Rien n'est fait sur le thread appelant : ni le démarrage du plugin ni la consultation de
+// l'index ne dépendent de la taille de la bibliothèque. Les écouteurs (ChangeListener) sont
+// prévenus sur le thread des messages quand l'index change.
+class IRLibrary : public juce::ChangeBroadcaster,
+                  private juce::Thread
+{
+public:
+    struct Entry
+    {
+        juce::File file;
+        juce::String hash;              // SHA-256 du contenu
+        juce::int64 fileSize = 0;
+        juce::Time modificationTime;
+        juce::int64 lengthInSamples = 0;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        juce::String prompt;            // IR générée : description et seed, sinon vides
+        int seed = -1;
+        IRFeatures features;
+
+        double getDurationSeconds() const
+        {
+            return sampleRate > 0.0 ? (double) lengthInSamples / sampleRate : 0.0;
+        }
+    };
+
+    IRLibrary()
+        : juce::Thread("GenIR library indexer"),
+          indexFile(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+              .getChildFile("GenIR").getChildFile("library.json"))
+    {
+        startThread(juce::Thread::Priority::background);
+    }
+
+    ~IRLibrary() override
+    {
+        signalThreadShouldExit();
+        wake();
+        stopThread(10000);
+        closeWatches();
+        saveIfNeeded(true);
+    }
+
+    // Répertoire à indexer. wildcard : motifs séparés par des points-virgules.
+    void addRoot(const juce::File& directory, bool recursive, const juce::String& wildcard)
+    {
+        {
+            const juce::ScopedLock lock(stateLock);
+            for (auto& root : roots)
+                if (root.directory == directory)
+                    return;
+
+            roots.push_back({ directory, recursive, wildcard });
+            rootsChanged = true;
+        }
+
+        wake();
+    }
+
+    // Métadonnées d'une IR générée par le plugin ; le fichier est (ré)indexé aussitôt
+    void recordGeneration(const juce::File& file, const juce::String& prompt, int seed)
+    {
+        {
+            const juce::ScopedLock lock(stateLock);
+            generationInfo[file.getFullPathName()] = { prompt, seed };
+            pendingFiles.insert(file.getFullPathName());
+        }
+
+        wake();
+    }
+
+    // Copie de l'index, triée par chemin
+    std::vector<Entry> getEntries() const
+    {
+        const juce::ScopedLock lock(stateLock);
+        std::vector<Entry> result;
+        result.reserve(entries.size());
+
+        for (auto& entry : entries)
+            result.push_back(entry.second);
+
+        return result;
+    }
+
+    // Entrées d'un répertoire (non récursif)
+    std::vector<Entry> getEntriesIn(const juce::File& directory) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        std::vector<Entry> result;
+
+        for (auto& entry : entries)
+            if (entry.second.file.getParentDirectory() == directory)
+                result.push_back(entry.second);
+
+        return result;
+    }
+
+    bool findEntry(const juce::File& file, Entry& result) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = entries.find(file.getFullPathName());
+        if (it == entries.end())
+            return false;
+
+        result = it->second;
+        return true;
+    }
+
+    int getNumEntries() const
+    {
+        const juce::ScopedLock lock(stateLock);
+        return (int) entries.size();
+    }
+
+    struct Match
+    {
+        Entry entry;
+        float distance = 0.0f;      // distance des descripteurs centrés-réduits (0 : identiques)
+    };
+
+    // Les maxResults IRs les plus proches de features. L'IR de référence et ses copies (même
+    // fichier, même contenu) sont écartées. L'index de similarité est reconstruit au besoin
+    // quand la bibliothèque a changé.
+    std::vector<Match> findSimilar(const IRFeatures& features, int maxResults,
+                                   const juce::File& excludeFile = {}, const juce::String& excludeHash = {}) const
+    {
+        const juce::ScopedLock lock(similarityLock);
+        const TraceLog::Span span(*trace, "find similar", "library");
+
+        {
+            const juce::ScopedLock state(stateLock);
+
+            if (similarityVersion != entriesVersion)
+            {
+                similarityEntries.clear();
+                similarityEntries.reserve(entries.size());
+
+                for (auto& entry : entries)
+                    similarityEntries.push_back(entry.second);
+
+                similarityVersion = entriesVersion;
+                similarityDirty = true;
+            }
+        }
+
+        if (similarityDirty)
+        {
+            std::vector<IRFeatures> items;
+            items.reserve(similarityEntries.size());
+
+            for (auto& entry : similarityEntries)
+                items.push_back(entry.features);
+
+            similarity.build(items);
+            similarityDirty = false;
+        }
+
+        std::vector<Match> result;
+
+        for (auto& match : similarity.findNearest(features, maxResults, [&](int item)
+            {
+                const Entry& entry = similarityEntries[(size_t) item];
+                return entry.file == excludeFile || (excludeHash.isNotEmpty() && entry.hash == excludeHash);
+            }))
+            result.push_back({ similarityEntries[(size_t) match.item], match.distance });
+
+        return result;
+    }
+
+    // L'index persistant a été relu (avant, getEntries() peut être incomplet)
+    bool isLoaded() const
+    {
+        return loaded.load();
+    }
+
+private:
+    struct Root
+    {
+        juce::File directory;
+        bool recursive = false;
+        juce::String wildcard;
+
+        bool matches(const juce::File& file) const
+        {
+            if (!(recursive ? file.isAChildOf(directory) : file.getParentDirectory() == directory))
+                return false;
+
+            juce::StringArray patterns;
+            patterns.addTokens(wildcard, ";", "");
+
+            for (auto& pattern : patterns)
+                if (file.getFileName().matchesWildcard(pattern.trim(), true))
+                    return true;
+
+            return false;
+        }
+    };
+
+    struct GenerationInfo
+    {
+        juce::String prompt;
+        int seed = -1;
+    };
+
+    static constexpr int fullRescanIntervalMs = 60000;
+    static constexpr int saveDelayMs = 2000;
+    static constexpr int indexVersion = 2;   // un index plus ancien est reconstruit (nouveaux descripteurs)
+
+    //==============================================================================
+    void run() override
+    {
+        load();
+
+        double lastFullScanMs = 0.0;
+
+        while (!threadShouldExit())
+        {
+            bool fullScan = false;
+
+            {
+                const juce::ScopedLock lock(stateLock);
+                fullScan = rootsChanged;
+                rootsChanged = false;
+            }
+
+            const double now = juce::Time::getMillisecondCounterHiRes();
+            if (fullScan || now - lastFullScanMs >= fullRescanIntervalMs)
+            {
+                updateWatches();
+                scanRoots();
+                lastFullScanMs = now;
+            }
+
+            processPendingFiles();
+            saveIfNeeded(false);
+
+            waitForChanges(500);
+        }
+    }
+
+    // Parcours complet des racines : fichiers nouveaux, modifiés ou disparus. Seuls les
+    // fichiers dont la date ou la taille a changé sont relus.
+    void scanRoots()
+    {
+        std::vector<Root> currentRoots;
+        {
+            const juce::ScopedLock lock(stateLock);
+            currentRoots = roots;
+        }
+
+        const TraceLog::Span span(*trace, "library scan", "library");
+        std::set<juce::String> seen;
+
+        for (auto& root : currentRoots)
+        {
+            for (const auto& item : juce::RangedDirectoryIterator(root.directory, root.recursive, root.wildcard,
+                                                                  juce::File::findFiles))
+            {
+                if (threadShouldExit())
+                    return;
+
+                const juce::String path = item.getFile().getFullPathName();
+                seen.insert(path);
+
+                const juce::ScopedLock lock(stateLock);
+                auto it = entries.find(path);
+                if (it == entries.end() || it->second.fileSize != item.getFileSize()
+                    || it->second.modificationTime != item.getModificationTime())
+                    pendingFiles.insert(path);
+            }
+        }
+
+        // Fichiers disparus des racines
+        const juce::ScopedLock lock(stateLock);
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            const bool underRoot = std::any_of(currentRoots.begin(), currentRoots.end(),
+                [&](const Root& root) { return root.matches(it->second.file); });
+
+            if (underRoot && seen.count(it->first) == 0)
+            {
+                it = entries.erase(it);
+                markChanged();
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // Indexe les fichiers signalés, un par un, sans tenir le verrou pendant le décodage
+    void processPendingFiles()
+    {
+        while (!threadShouldExit())
+        {
+            juce::String path;
+
+            {
+                const juce::ScopedLock lock(stateLock);
+                if (pendingFiles.empty())
+                    return;
+
+                path = *pendingFiles.begin();
+                pendingFiles.erase(pendingFiles.begin());
+            }
+
+            const juce::File file(path);
+
+            if (!file.existsAsFile())
+            {
+                const juce::ScopedLock lock(stateLock);
+                if (entries.erase(path) > 0)
+                    markChanged();
+                continue;
+            }
+
+            Entry entry;
+            if (!analyseFile(file, entry))
+                continue;
+
+            const juce::ScopedLock lock(stateLock);
+
+            auto info = generationInfo.find(path);
+            if (info != generationInfo.end())
+            {
+                entry.prompt = info->second.prompt;
+                entry.seed = info->second.seed;
+                generationInfo.erase(info);
+            }
+            else if (auto previous = entries.find(path); entry.prompt.isEmpty() && previous != entries.end())
+            {
+                entry.prompt = previous->second.prompt;
+                entry.seed = previous->second.seed;
+            }
+
+            entries[path] = entry;
+            markChanged();
+        }
+    }
+
+    // Décode et analyse un fichier. Un conteneur .genir apporte son analyse et sa recette.
+    bool analyseFile(const juce::File& file, Entry& entry)
+    {
+        const TraceLog::Span span(*trace, "library index", "library", file.getFileName());
+
+        ImpulseResponse ir;
+        if (!ir.loadFromFile(file))
+            return false;
+
+        entry.file = file;
+        entry.hash = juce::SHA256(file).toHexString();
+        entry.fileSize = file.getSize();
+        entry.modificationTime = file.getLastModificationTime();
+        entry.lengthInSamples = ir.samples.getNumSamples();
+        entry.sampleRate = ir.sampleRate;
+        entry.numChannels = ir.samples.getNumChannels();
+        entry.features = ir.hasAnalysis ? ir.analysis : IRAnalysis::analyse(ir.samples, ir.sampleRate);
+
+        if (ir.hasRecipe)
+        {
+            entry.prompt = ir.recipe.prompt;
+            entry.seed = ir.recipe.seed;
+        }
+
+        return true;
+    }
+
+    // Sous stateLock
+    void markChanged()
+    {
+        dirty = true;
+        ++entriesVersion;
+        lastChangeMs = juce::Time::getMillisecondCounterHiRes();
+        sendChangeMessage();
+    }
+
+    //==============================================================================
+    // Index persistant
+    void load()
+    {
+        const juce::var index = juce::JSON::parse(indexFile);
+
+        if ((int) index.getProperty("version", 0) == indexVersion)
+        {
+            if (auto* list = index["entries"].getArray())
+            {
+                const juce::ScopedLock lock(stateLock);
+
+                for (auto& item : *list)
+                {
+                    Entry entry;
+                    entry.file = juce::File(item["path"].toString());
+                    entry.hash = item["hash"].toString();
+                    entry.fileSize = (juce::int64) item["size"];
+                    entry.modificationTime = juce::Time((juce::int64) item["modified"]);
+                    entry.lengthInSamples = (juce::int64) item["length"];
+                    entry.sampleRate = item["sampleRate"];
+                    entry.numChannels = item["channels"];
+                    entry.prompt = item["prompt"].toString();
+                    entry.seed = item.getProperty("seed", -1);
+                    entry.features = IRFeatures::fromVar(item["features"]);
+
+                    entries[entry.file.getFullPathName()] = entry;
+                }
+            }
+        }
+
+        loaded = true;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            ++entriesVersion;
+        }
+
+        sendChangeMessage();
+    }
+
+    // Écrit l'index quand il n'a plus changé depuis saveDelayMs (ou tout de suite si force)
+    void saveIfNeeded(bool force)
+    {
+        juce::Array<juce::var> list;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            if (!dirty || (!force && juce::Time::getMillisecondCounterHiRes() - lastChangeMs < saveDelayMs))
+                return;
+
+            dirty = false;
+
+            for (auto& item : entries)
+            {
+                const Entry& entry = item.second;
+                auto* object = new juce::DynamicObject();
+                object->setProperty("path", entry.file.getFullPathName());
+                object->setProperty("hash", entry.hash);
+                object->setProperty("size", entry.fileSize);
+                object->setProperty("modified", entry.modificationTime.toMilliseconds());
+                object->setProperty("length", entry.lengthInSamples);
+                object->setProperty("sampleRate", entry.sampleRate);
+                object->setProperty("channels", entry.numChannels);
+                object->setProperty("prompt", entry.prompt);
+                object->setProperty("seed", entry.seed);
+                object->setProperty("features", entry.features.toVar());
+                list.add(juce::var(object));
+            }
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("version", indexVersion);
+        root->setProperty("entries", list);
+
+        // Fichier temporaire renommé : un autre processus ne lit jamais un index à moitié écrit
+        indexFile.getParentDirectory().createDirectory();
+        const juce::File partial = indexFile.getSiblingFile(indexFile.getFileName() + ".part");
+
+        if (!partial.replaceWithText(juce::JSON::toString(juce::var(root), true)) || !partial.moveFileTo(indexFile))
+            partial.deleteFile();
+    }
+
+    //==============================================================================
+    // Notifications du système de fichiers
+#if JUCE_LINUX
+    void updateWatches()
+    {
+        if (inotifyFd < 0)
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (inotifyFd < 0)
+            return;
+
+        std::vector<Root> currentRoots;
+        {
+            const juce::ScopedLock lock(stateLock);
+            currentRoots = roots;
+        }
+
+        for (auto& root : currentRoots)
+        {
+            std::vector<juce::File> directories { root.directory };
+
+            if (root.recursive)
+                for (const auto& item : juce::RangedDirectoryIterator(root.directory, true, "*", juce::File::findDirectories))
+                    directories.push_back(item.getFile());
+
+            for (auto& directory : directories)
+            {
+                const int wd = inotify_add_watch(inotifyFd, directory.getFullPathName().toRawUTF8(),
+                                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE);
+                if (wd >= 0)
+                    watches[wd] = directory;
+            }
+        }
+    }
+
+    // Réveille le thread. poll() n'entend pas notify() : l'eventfd est dans son ensemble, et
+    // son compteur garde un réveil arrivé avant l'attente.
+    void wake()
+    {
+        notify();
+
+        if (wakeFd >= 0)
+        {
+            const eventfd_t one = 1;
+            eventfd_write(wakeFd, one);
+        }
+    }
+
+    // Attend un évènement du système de fichiers, un réveil (wake) ou timeoutMs
+    void waitForChanges(int timeoutMs)
+    {
+        if (inotifyFd < 0 && wakeFd < 0)
+        {
+            wait(timeoutMs);
+            return;
+        }
+
+        // Un descripteur négatif est ignoré par poll()
+        pollfd descriptors[] { { inotifyFd, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+        if (poll(descriptors, 2, timeoutMs) <= 0)
+            return;
+
+        if ((descriptors[1].revents & POLLIN) != 0)
+        {
+            eventfd_t count = 0;
+            eventfd_read(wakeFd, &count);
+        }
+
+        if ((descriptors[0].revents & POLLIN) == 0)
+            return;
+
+        alignas(inotify_event) char buffer[8192];
+        bool newDirectory = false;
+
+        for (;;)
+        {
+            const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += (ssize_t) sizeof(inotify_event) + event->len;
+
+                auto watch = watches.find(event->wd);
+                if (watch == watches.end() || event->len == 0)
+                    continue;
+
+                const juce::File file = watch->second.getChildFile(juce::String::fromUTF8(event->name));
+
+                if ((event->mask & IN_ISDIR) != 0)
+                {
+                    newDirectory = newDirectory || (event->mask & IN_CREATE) != 0;
+                    continue;
+                }
+
+                // Un fichier en cours d'écriture n'est indexé qu'à sa fermeture
+                if ((event->mask & IN_CREATE) != 0)
+                    continue;
+
+                const juce::ScopedLock lock(stateLock);
+                if (std::any_of(roots.begin(), roots.end(), [&](const Root& root) { return root.matches(file); }))
+                    pendingFiles.insert(file.getFullPathName());
+            }
+        }
+
+        // Nouveau sous-répertoire d'une racine récursive : le surveiller et le parcourir
+        if (newDirectory)
+        {
+            const juce::ScopedLock lock(stateLock);
+            rootsChanged = true;
+        }
+    }
+
+    void closeWatches()
+    {
+        if (inotifyFd >= 0)
+            close(inotifyFd);
+
+        if (wakeFd >= 0)
+            close(wakeFd);
+
+        inotifyFd = -1;
+        wakeFd = -1;
+        watches.clear();
+    }
+
+    int inotifyFd = -1;
+    int wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);   // créé avant le démarrage du thread
+    std::map<int, juce::File> watches;
+#else
+    void updateWatches() {}
+
+    void wake()
+    {
+        notify();
+    }
+
+    void waitForChanges(int timeoutMs)
+    {
+        wait(timeoutMs);
+    }
+
+    void closeWatches() {}
+#endif
+
+    const juce::File indexFile;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    mutable juce::CriticalSection stateLock;
+    std::vector<Root> roots;
+    bool rootsChanged = false;
+    std::map<juce::String, Entry> entries;              // par chemin complet
+    std::set<juce::String> pendingFiles;                // à (ré)indexer
+    std::map<juce::String, GenerationInfo> generationInfo;
+    bool dirty = false;
+    juce::uint64 entriesVersion = 0;
+    double lastChangeMs = 0.0;
+    std::atomic<bool> loaded { false };
+
+    // Index de similarité et entrées correspondantes, reconstruits à la demande
+    mutable juce::CriticalSection similarityLock;
+    mutable SimilarityIndex similarity;
+    mutable std::vector<Entry> similarityEntries;
+    mutable juce::uint64 similarityVersion = ~(juce::uint64) 0;
+    mutable bool similarityDirty = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRLibrary)
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ImpulseResponse.h"
+#include "TraceLog.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+
+// Pool de threads partagé par toutes les instances du processus (SharedResourcePointer) pour
+// les chargements d'IR hors du thread de l'interface : restauration d'état, décodage et
+// préparation. À l'ouverture d'un projet, les instances chargent ainsi leurs IRs en parallèle
+// sur quelques threads, au lieu d'un thread par instance ou du thread de l'interface.
+//
+// Les IRs décodées sont partagées par empreinte de contenu tant qu'une instance les utilise :
+// des instances qui restaurent la même IR ne la décodent qu'une fois.
+class IRLoadPool
+{
+public:
+    IRLoadPool()
+        : pool(juce::jmax(1, juce::SystemStats::getNumCpus() / 2))
+    {
+    }
+
+    ~IRLoadPool()
+    {
+        pool.removeAllJobs(true, 5000);
+    }
+
+    // Tâche d'une instance, annulable avec removeJobs(owner)
+    void addJob(const void* owner, std::function<void()> job)
+    {
+        pool.addJob(new OwnedJob(owner, std::move(job)), true);
+    }
+
+    // Retire les tâches en attente d'une instance et attend la fin de celles en cours
+    void removeJobs(const void* owner)
+    {
+        OwnerSelector selector(owner);
+        pool.removeAllJobs(false, 10000, &selector);
+    }
+
+    // IR décodée de ce contenu : partagée si une instance l'utilise déjà ou la décode en ce
+    // moment (l'appel attend alors la fin de ce décodage). nullptr si le fichier est illisible.
+    std::shared_ptr<const ImpulseResponse> decode(const juce::File& file, const juce::String& hash)
+    {
+        std::shared_ptr<juce::WaitableEvent> done;
+
+        for (;;)
+        {
+            std::shared_ptr<juce::WaitableEvent> running;
+
+            {
+                const juce::ScopedLock lock(cacheLock);
+
+                auto cached = decoded.find(hash);
+                if (cached != decoded.end())
+                    if (auto ir = cached->second.lock())
+                        return ir;
+
+                auto it = inFlight.find(hash);
+                if (it == inFlight.end())
+                {
+                    done = std::make_shared<juce::WaitableEvent>(true);
+                    inFlight[hash] = done;
+                    break;
+                }
+
+                running = it->second;
+            }
+
+            running->wait();
+        }
+
+        auto ir = std::make_shared<ImpulseResponse>();
+        const juce::int64 startUs = TraceLog::nowUs();
+        const bool ok = ir->loadFromFile(file);
+        trace->record("decode", "dsp", startUs, TraceLog::nowUs(), file.getFileName());
+
+        std::shared_ptr<const ImpulseResponse> result;
+        if (ok)
+            result = std::move(ir);
+
+        {
+            const juce::ScopedLock lock(cacheLock);
+
+            for (auto it = decoded.begin(); it != decoded.end();)
+            {
+                if (it->second.expired())
+                    it = decoded.erase(it);
+                else
+                    ++it;
+            }
+
+            if (result != nullptr)
+                decoded[hash] = result;
+
+            inFlight.erase(hash);
+        }
+
+        done->signal();
+        return result;
+    }
+
+private:
+    class OwnedJob : public juce::ThreadPoolJob
+    {
+    public:
+        OwnedJob(const void* o, std::function<void()> j)
+            : juce::ThreadPoolJob("GenIR IR load"), owner(o), job(std::move(j))
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            job();
+            return jobHasFinished;
+        }
+
+        const void* const owner;
+
+    private:
+        std::function<void()> job;
+    };
+
+    struct OwnerSelector : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnerSelector(const void* o) : owner(o) {}
+
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            auto* owned = dynamic_cast<OwnedJob*>(job);
+            return owned != nullptr && owned->owner == owner;
+        }
+
+        const void* owner;
+    };
+
+    juce::ThreadPool pool;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    juce::CriticalSection cacheLock;
+    std::map<juce::String, std::weak_ptr<const ImpulseResponse>> decoded;       // par empreinte
+    std::map<juce::String, std::shared_ptr<juce::WaitableEvent>> inFlight;     // décodages en cours
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRLoadPool)
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ImpulseResponse.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Vue d'ensemble d'une IR pour l'affichage : pyramide min/max de la forme d'onde et pyramide de
+// spectrogrammes (STFT), calculées une fois hors du thread de l'interface.
+//
+// Chaque niveau de pyramide regroupe deux éléments du niveau précédent. Pour afficher une plage
+// quelconque, on prend le niveau dont la résolution est juste en dessous de celle d'un pixel :
+// quelques éléments par pixel à combiner, quel que soit le zoom et la longueur de l'IR.
+struct IROverview
+{
+    static constexpr int baseBucketSize = 8;        // échantillons par couple min/max au niveau 0
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = 256;             // échantillons par colonne au niveau 0
+    static constexpr int numBands = 128;            // bandes logarithmiques de 20 Hz à Nyquist
+    static constexpr double minFrequency = 20.0;
+    static constexpr float dynamicRangeDb = 100.0f; // 0 : dynamicRangeDb sous le maximum, 255 : maximum
+
+    int numChannels = 0;
+    juce::int64 numSamples = 0;
+    double sampleRate = 0.0;
+    float peak = 0.0f;
+
+    //==============================================================================
+    // Minimum et maximum du canal sur [start, end), à la résolution du niveau adapté à la plage
+    juce::Range<float> getRange(int channel, juce::int64 start, juce::int64 end) const
+    {
+        start = juce::jlimit((juce::int64) 0, numSamples, start);
+        end = juce::jlimit(start, numSamples, end);
+
+        if (end <= start || waveform.empty())
+            return {};
+
+        int level = 0;
+        while (level + 1 < getNumWaveformLevels() && ((juce::int64) baseBucketSize << (level + 1)) <= end - start)
+            ++level;
+
+        const auto& buckets = waveform[(size_t) (level * numChannels + channel)];
+        const juce::int64 bucketSize = (juce::int64) baseBucketSize << level;
+        const size_t first = (size_t) (start / bucketSize);
+        const size_t last = juce::jmin(buckets.size(), (size_t) ((end - 1) / bucketSize) + 1);
+
+        juce::Range<float> range = buckets[first];
+        for (size_t i = first + 1; i < last; ++i)
+            range = range.getUnionWith(buckets[i]);
+
+        return range;
+    }
+
+    int getNumWaveformLevels() const noexcept
+    {
+        return numChannels > 0 ? (int) waveform.size() / numChannels : 0;
+    }
+
+    // Niveau du spectrogramme dont une colonne couvre au plus samplesPerPixel échantillons
+    int getSpectrogramLevel(double samplesPerPixel) const noexcept
+    {
+        int level = 0;
+        while (level + 1 < (int) spectrogram.size() && (double) (hopSize << (level + 1)) <= samplesPerPixel)
+            ++level;
+        return level;
+    }
+
+    int getNumFrames(int level) const noexcept
+    {
+        return (int) (spectrogram[(size_t) level].size() / numBands);
+    }
+
+    // numBands niveaux (0-255) d'une colonne, de la bande la plus grave à la plus aiguë
+    const juce::uint8* getColumn(int level, int frame) const noexcept
+    {
+        return spectrogram[(size_t) level].data() + (size_t) frame * numBands;
+    }
+
+    // Fréquence basse de la bande (Hz), pour graduer l'axe
+    double getBandFrequency(int band) const noexcept
+    {
+        return minFrequency * std::pow(sampleRate * 0.5 / minFrequency, (double) band / numBands);
+    }
+
+    //==============================================================================
+    // Calcul complet. shouldStop est consulté entre les colonnes ; nullptr si abandonné.
+    static std::shared_ptr<IROverview> compute(const ImpulseResponse& ir, const std::function<bool()>& shouldStop)
+    {
+        if (!ir.isValid())
+            return nullptr;
+
+        auto overview = std::make_shared<IROverview>();
+        overview->numChannels = ir.samples.getNumChannels();
+        overview->numSamples = ir.samples.getNumSamples();
+        overview->sampleRate = ir.sampleRate;
+
+        overview->computeWaveform(ir.samples);
+        if (!overview->computeSpectrogram(ir.samples, shouldStop))
+            return nullptr;
+
+        return overview;
+    }
+
+private:
+    void computeWaveform(const juce::AudioBuffer<float>& samples)
+    {
+        const juce::int64 numBuckets0 = (numSamples + baseBucketSize - 1) / baseBucketSize;
+        int numLevels = 1;
+        while ((numBuckets0 >> numLevels) > 0)
+            ++numLevels;
+
+        waveform.assign((size_t) (numLevels * numChannels), {});
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = samples.getReadPointer(ch);
+            auto& base = waveform[(size_t) ch];
+            base.resize((size_t) numBuckets0);
+
+            for (juce::int64 b = 0; b < numBuckets0; ++b)
+            {
+                const juce::int64 start = b * baseBucketSize;
+                const int count = (int) juce::jmin((juce::int64) baseBucketSize, numSamples - start);
+                base[(size_t) b] = juce::FloatVectorOperations::findMinAndMax(data + start, count);
+                peak = juce::jmax(peak, -base[(size_t) b].getStart(), base[(size_t) b].getEnd());
+            }
+
+            for (int level = 1; level < numLevels; ++level)
+            {
+                const auto& below = waveform[(size_t) ((level - 1) * numChannels + ch)];
+                auto& above = waveform[(size_t) (level * numChannels + ch)];
+                above.resize((below.size() + 1) / 2);
+
+                for (size_t i = 0; i < above.size(); ++i)
+                    above[i] = 2 * i + 1 < below.size() ? below[2 * i].getUnionWith(below[2 * i + 1]) : below[2 * i];
+            }
+        }
+    }
+
+    // Spectrogramme de la somme des canaux, en dB sous son maximum
+    bool computeSpectrogram(const juce::AudioBuffer<float>& samples, const std::function<bool()>& shouldStop)
+    {
+        const int numFrames = (int) ((numSamples + hopSize - 1) / hopSize);
+        std::vector<float> levels((size_t) numFrames * numBands, 0.0f);
+
+        juce::dsp::FFT fft(fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+        std::vector<float> data((size_t) (2 * fftSize));
+
+        // Bandes : premier et dernier bin de chaque bande, au moins un bin chacune
+        std::array<int, numBands + 1> edges {};
+        const double binWidth = sampleRate / fftSize;
+        for (int band = 0; band <= numBands; ++band)
+            edges[(size_t) band] = juce::jlimit(1, fftSize / 2, (int) std::round(getBandFrequency(band) / binWidth));
+
+        float maximum = 0.0f;
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            if (shouldStop != nullptr && (frame & 63) == 0 && shouldStop())
+                return false;
+
+            std::fill(data.begin(), data.end(), 0.0f);
+            const juce::int64 start = (juce::int64) frame * hopSize;
+            const int count = (int) juce::jmin((juce::int64) fftSize, numSamples - start);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::add(data.data(), samples.getReadPointer(ch) + start, count);
+
+            window.multiplyWithWindowingTable(data.data(), (size_t) fftSize);
+            fft.performFrequencyOnlyForwardTransform(data.data());
+
+            float* column = levels.data() + (size_t) frame * numBands;
+            for (int band = 0; band < numBands; ++band)
+            {
+                const int first = edges[(size_t) band];
+                const int last = juce::jmax(first + 1, edges[(size_t) band + 1]);
+                column[band] = juce::FloatVectorOperations::findMaximum(data.data() + first, last - first);
+                maximum = juce::jmax(maximum, column[band]);
+            }
+        }
+
+        // Niveau 0 quantifié, puis niveaux supérieurs par maximum de deux colonnes voisines
+        std::vector<juce::uint8> base(levels.size());
+        const float reference = maximum > 0.0f ? maximum : 1.0f;
+
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            const float db = juce::Decibels::gainToDecibels(levels[i] / reference, -dynamicRangeDb);
+            base[i] = (juce::uint8) juce::jlimit(0, 255, juce::roundToInt((db + dynamicRangeDb) * 255.0f / dynamicRangeDb));
+        }
+
+        spectrogram.clear();
+        spectrogram.push_back(std::move(base));
+
+        while (spectrogram.back().size() > (size_t) numBands)
+        {
+            const auto& below = spectrogram.back();
+            const size_t framesBelow = below.size() / numBands;
+            std::vector<juce::uint8> above(((framesBelow + 1) / 2) * numBands);
+
+            for (size_t frame = 0; frame < framesBelow; ++frame)
+                for (int band = 0; band < numBands; ++band)
+                {
+                    auto& target = above[(frame / 2) * numBands + (size_t) band];
+                    target = juce::jmax(target, below[frame * numBands + (size_t) band]);
+                }
+
+            spectrogram.push_back(std::move(above));
+        }
+
+        return true;
+    }
+
+    std::vector<std::vector<juce::Range<float>>> waveform;   // [niveau * numChannels + canal]
+    std::vector<std::vector<juce::uint8>> spectrogram;       // [niveau], colonnes de numBands valeurs
+};
+
+// Vues d'ensemble des IRs en cours d'affichage, partagées par tous les éditeurs du processus
+// (SharedResourcePointer) et calculées sur un thread de fond.
+//
+// Une vue d'ensemble est rattachée à l'IR dont elle est issue (même objet ImpulseResponse,
+// partagé par la convolution et les chargements) : elle est gardée tant que l'IR existe, puis
+// oubliée. Des éditeurs ouverts sur la même IR n'en calculent qu'une.
+class IROverviewCache : public juce::ChangeBroadcaster
+{
+public:
+    IROverviewCache()
+        : pool(1)
+    {
+    }
+
+    ~IROverviewCache() override
+    {
+        {
+            const juce::ScopedLock lock(cacheLock);
+            entries.clear();
+        }
+
+        pool.removeAllJobs(true, 5000);
+    }
+
+    // Vue d'ensemble de l'IR si elle est prête, sinon nullptr : son calcul est lancé s'il ne
+    // l'est pas déjà, et un message de changement (asynchrone) annonce sa fin
+    std::shared_ptr<const IROverview> get(const std::shared_ptr<const ImpulseResponse>& ir)
+    {
+        if (ir == nullptr || !ir->isValid())
+            return nullptr;
+
+        const juce::ScopedLock lock(cacheLock);
+        prune();
+
+        auto it = entries.find(ir.get());
+        if (it != entries.end())
+            return it->second.overview;
+
+        entries[ir.get()] = { ir, nullptr };
+
+        std::weak_ptr<const ImpulseResponse> weak = ir;
+        pool.addJob([this, weak]
+            {
+                auto source = weak.lock();
+                if (source == nullptr)
+                    return;
+
+                const juce::int64 startUs = TraceLog::nowUs();
+
+                // Abandon si plus personne d'autre que ce calcul n'utilise l'IR
+                auto overview = IROverview::compute(*source, [&source] { return source.use_count() <= 1; });
+                trace->record("overview", "ui", startUs, TraceLog::nowUs(), source->source.getFileName());
+
+                if (overview == nullptr)
+                    return;
+
+                {
+                    const juce::ScopedLock lock(cacheLock);
+                    auto entry = entries.find(source.get());
+                    if (entry == entries.end())
+                        return;
+
+                    entry->second.overview = std::move(overview);
+                }
+
+                sendChangeMessage();
+            });
+
+        return nullptr;
+    }
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<const ImpulseResponse> ir;
+        std::shared_ptr<const IROverview> overview;
+    };
+
+    // Sous cacheLock : une IR libérée emporte sa vue d'ensemble (son adresse peut être réutilisée)
+    void prune()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.ir.expired())
+                it = entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    juce::ThreadPool pool;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    juce::CriticalSection cacheLock;
+    std::map<const ImpulseResponse*, Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IROverviewCache)
+};
@@ -0,0 +1,675 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceLog.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+
+// Stockage des IRs générées, partagé par toutes les instances du processus (SharedResourcePointer).
+//
+// Chaque IR est rangée sous l'empreinte SHA-256 de son contenu (<empreinte>.<ext>) : deux
+// générations identiques n'occupent qu'un fichier. La taille totale est bornée (1 Go par
+// défaut) ; au-delà, les IRs utilisées le moins récemment sont supprimées, sauf celles qu'une
+// session ouverte référence encore (Pin). La liste des IRs est tenue en mémoire et dans un
+// index (store.json) : ni l'ajout ni la recherche ne parcourent le répertoire. L'index garde
+// aussi l'ancien chemin de chaque fichier rangé, pour retrouver l'IR d'une session enregistrée
+// avant son rangement (resolve).
+//
+// Le répertoire est partagé par tous les processus de la machine (hôtes qui isolent les
+// plugins, démon GenIR). Chaque processus publie ses Pins dans un fichier de Pins/, relu par le
+// compactage des autres ; compactage et écriture de l'index se font sous un verrou
+// inter-processus, et l'index est fusionné avec celui des autres processus au lieu d'être écrasé.
+//
+// Un thread compacte le stockage en arrière-plan : éviction, fichiers partiels abandonnés,
+// et import des anciens GenIR_<date>.wav qui s'accumulaient dans le répertoire temporaire.
+class IRStore : private juce::Thread
+{
+public:
+    // Référence d'une session à une IR du stockage : tant qu'elle existe, l'IR n'est pas supprimée
+    class Pin
+    {
+    public:
+        Pin() = default;
+
+        Pin(Pin&& other) noexcept
+            : store(other.store), hash(std::move(other.hash))
+        {
+            other.store = nullptr;
+        }
+
+        Pin& operator=(Pin&& other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                store = other.store;
+                hash = std::move(other.hash);
+                other.store = nullptr;
+            }
+            return *this;
+        }
+
+        ~Pin()
+        {
+            release();
+        }
+
+        bool isPinned() const noexcept
+        {
+            return store != nullptr;
+        }
+
+    private:
+        friend class IRStore;
+
+        Pin(IRStore& s, const juce::String& h)
+            : store(&s), hash(h)
+        {
+        }
+
+        void release()
+        {
+            if (store != nullptr)
+                store->unpin(hash);
+            store = nullptr;
+        }
+
+        IRStore* store = nullptr;
+        juce::String hash;
+
+        JUCE_DECLARE_NON_COPYABLE(Pin)
+    };
+
+    IRStore()
+        : juce::Thread("GenIR store compaction"),
+          legacyDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("GenIR")),
+          storeDirectory(legacyDirectory.getChildFile("Store")),
+          indexFile(storeDirectory.getChildFile("store.json")),
+          pinDirectory(storeDirectory.getChildFile("Pins")),
+          pinFile(pinDirectory.getChildFile(juce::Uuid().toString() + ".pins"))
+    {
+        storeDirectory.createDirectory();
+        pinDirectory.createDirectory();
+        load();
+        startThread(juce::Thread::Priority::background);
+    }
+
+    ~IRStore() override
+    {
+        stopThread(10000);
+        save();
+        pinFile.deleteFile();
+    }
+
+    juce::File getDirectory() const
+    {
+        return storeDirectory;
+    }
+
+    // Range un fichier dans le stockage et retourne son nouvel emplacement. Le fichier source
+    // est déplacé (ou supprimé si un contenu identique est déjà rangé). En cas d'échec, le
+    // fichier source est retourné tel quel.
+    juce::File add(const juce::File& source)
+    {
+        if (!source.existsAsFile())
+            return source;
+
+        if (source.getParentDirectory() == storeDirectory)
+            return source;
+
+        const juce::String hash = juce::SHA256(source).toHexString();
+        const juce::String extension = source.getFileExtension();
+        const juce::File stored = storeDirectory.getChildFile(hash + extension);
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = items.find(hash);
+
+            if (it != items.end() && stored.existsAsFile())
+            {
+                // Contenu déjà rangé : seul l'usage est mis à jour
+                it->second.lastAccessMs = juce::Time::currentTimeMillis();
+                aliases[source.getFullPathName()] = hash;
+                dirty = true;
+                source.deleteFile();
+                return stored;
+            }
+        }
+
+        if (!source.moveFileTo(stored) && !(source.copyFileTo(stored) && source.deleteFile()))
+            return source;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            aliases[source.getFullPathName()] = hash;
+            auto& item = items[hash];
+            item.extension = extension;
+            item.size = stored.getSize();
+            item.lastAccessMs = juce::Time::currentTimeMillis();
+            dirty = true;
+        }
+
+        notify();
+        return stored;
+    }
+
+    // Range une copie d'un fichier, qui reste en place, et retourne la copie rangée (File() en cas
+    // d'échec). Le cache des générations (GenerationCache) y range ses entrées : une IR générée
+    // n'est gardée qu'une fois, sous la limite de taille du stockage.
+    juce::File addCopy(const juce::File& source)
+    {
+        if (!source.existsAsFile())
+            return {};
+
+        const juce::String hash = juce::SHA256(source).toHexString();
+        const juce::String extension = source.getFileExtension();
+        const juce::File stored = storeDirectory.getChildFile(hash + extension);
+
+        if (!stored.existsAsFile())
+        {
+            // Copie partielle à un nom propre à cet appel, puis renommage : aucun processus ne lit
+            // une IR à moitié écrite
+            const juce::File partial = stored.getSiblingFile(stored.getFileName() + "."
+                                                             + juce::Uuid().toString().substring(0, 8) + ".part");
+
+            if (!source.copyFileTo(partial) || !partial.moveFileTo(stored))
+            {
+                partial.deleteFile();
+                return {};
+            }
+        }
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto& item = items[hash];
+            item.extension = extension;
+            item.size = stored.getSize();
+            item.lastAccessMs = juce::Time::currentTimeMillis();
+            dirty = true;
+        }
+
+        notify();
+        return stored;
+    }
+
+    // Une IR du stockage vient d'être utilisée : elle passe après les autres pour l'éviction
+    void touch(const juce::File& file)
+    {
+        const juce::String hash = getHash(file);
+        const juce::ScopedLock lock(stateLock);
+        auto it = items.find(hash);
+
+        if (it != items.end())
+        {
+            it->second.lastAccessMs = juce::Time::currentTimeMillis();
+            dirty = true;
+        }
+    }
+
+    // Empêche la suppression d'une IR du stockage tant que le Pin retourné existe.
+    // Un fichier hors du stockage donne un Pin vide.
+    Pin pin(const juce::File& file)
+    {
+        const juce::String hash = getHash(file);
+        if (hash.isEmpty())
+            return {};
+
+        bool firstPin = false;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = items.find(hash);
+            if (it == items.end())
+                return {};
+
+            firstPin = ++it->second.pinCount == 1;
+            it->second.lastAccessMs = juce::Time::currentTimeMillis();
+            dirty = true;
+        }
+
+        // Publié avant le retour : le compactage des autres processus ne la supprime plus
+        if (firstPin)
+            writePinFile();
+
+        return Pin(*this, hash);
+    }
+
+    // Emplacement actuel d'un fichier rangé sous un autre nom ; le fichier lui-même sinon
+    juce::File resolve(const juce::File& file) const
+    {
+        if (file.existsAsFile())
+            return file;
+
+        const juce::ScopedLock lock(stateLock);
+        auto alias = aliases.find(file.getFullPathName());
+        if (alias == aliases.end())
+            return file;
+
+        auto it = items.find(alias->second);
+        return it != items.end() ? storeDirectory.getChildFile(it->first + it->second.extension) : file;
+    }
+
+    // Empreinte d'un fichier du stockage, d'après son nom ; vide pour un fichier d'ailleurs
+    juce::String getHash(const juce::File& file) const
+    {
+        if (file.getParentDirectory() != storeDirectory)
+            return {};
+
+        const juce::String name = file.getFileNameWithoutExtension();
+        return name.length() == 64 && name.containsOnly("0123456789abcdef") ? name : juce::String();
+    }
+
+    // Fichier rangé sous cette empreinte, ou File() s'il n'y en a pas
+    juce::File find(const juce::String& hash) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = items.find(hash);
+        return it != items.end() ? storeDirectory.getChildFile(it->first + it->second.extension) : juce::File();
+    }
+
+    bool contains(const juce::File& file) const
+    {
+        const juce::String hash = getHash(file);
+        const juce::ScopedLock lock(stateLock);
+        return hash.isNotEmpty() && items.find(hash) != items.end();
+    }
+
+    void setMaximumSize(juce::int64 bytes)
+    {
+        maximumSize = juce::jmax((juce::int64) 0, bytes);
+        maximumSizeChanged = true;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            dirty = true;
+        }
+
+        notify();
+    }
+
+    juce::int64 getMaximumSize() const
+    {
+        return maximumSize.load();
+    }
+
+    juce::int64 getTotalSize() const
+    {
+        const juce::ScopedLock lock(stateLock);
+        juce::int64 total = 0;
+        for (auto& item : items)
+            total += item.second.size;
+        return total;
+    }
+
+private:
+    struct Item
+    {
+        juce::String extension;
+        juce::int64 size = 0;
+        juce::int64 lastAccessMs = 0;
+        int pinCount = 0;
+    };
+
+    static constexpr int compactionIntervalMs = 5 * 60 * 1000;
+    static constexpr juce::int64 stalePinAgeMs = 3 * compactionIntervalMs;   // processus arrêté sans nettoyer
+    static constexpr juce::int64 defaultMaximumSize = (juce::int64) 1024 * 1024 * 1024;
+    static constexpr juce::int64 legacyMinimumAgeMs = 60 * 60 * 1000;   // une génération en cours n'est pas touchée
+
+    // Le fichier des Pins n'est réécrit qu'au prochain compactage : d'ici là, l'IR reste protégée
+    void unpin(const juce::String& hash)
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = items.find(hash);
+        if (it != items.end() && it->second.pinCount > 0)
+            --it->second.pinCount;
+    }
+
+    //==============================================================================
+    void run() override
+    {
+        // Premier passage : réconcilier l'index avec le répertoire, importer l'ancien format
+        reconcile();
+        importLegacyFiles();
+
+        while (!threadShouldExit())
+        {
+            // Réécrit à chaque passage : la date du fichier montre aux autres processus que celui-ci vit
+            writePinFile();
+            compact();
+            save();
+            wait(compactionIntervalMs);
+        }
+    }
+
+    // Empreintes référencées par les sessions de ce processus, lues par le compactage des autres
+    void writePinFile()
+    {
+        const juce::ScopedLock fileLock(pinFileLock);
+        juce::StringArray hashes;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            for (auto& item : items)
+                if (item.second.pinCount > 0)
+                    hashes.add(item.first);
+        }
+
+        if (hashes.isEmpty())
+            pinFile.deleteFile();
+        else
+            pinFile.replaceWithText(hashes.joinIntoString("\n"));
+    }
+
+    // Empreintes référencées par les autres processus. Le fichier d'un processus qui ne l'a plus
+    // réécrit depuis stalePinAgeMs (arrêté sans nettoyer) ne compte plus et est supprimé.
+    std::set<juce::String> readOtherPins() const
+    {
+        std::set<juce::String> pinned;
+        const juce::int64 now = juce::Time::currentTimeMillis();
+
+        for (const auto& entry : juce::RangedDirectoryIterator(pinDirectory, false, "*.pins", juce::File::findFiles))
+        {
+            const juce::File file = entry.getFile();
+            if (file == pinFile)
+                continue;
+
+            if (now - entry.getModificationTime().toMilliseconds() > stalePinAgeMs)
+            {
+                file.deleteFile();
+                continue;
+            }
+
+            juce::StringArray hashes;
+            hashes.addLines(file.loadFileAsString());
+
+            for (auto& hash : hashes)
+                if (hash.trim().isNotEmpty())
+                    pinned.insert(hash.trim());
+        }
+
+        return pinned;
+    }
+
+    // Supprime les IRs les moins récemment utilisées et non référencées jusqu'à revenir sous la limite
+    void compact()
+    {
+        const TraceLog::Span span(*trace, "store compaction", "library");
+        const juce::int64 limit = maximumSize.load();
+
+        // Un seul processus compacte à la fois, d'après les Pins de tous
+        const juce::InterProcessLock::ScopedLockType directory(directoryLock);
+        if (!directory.isLocked())
+            return;
+
+        const std::set<juce::String> otherPins = readOtherPins();
+
+        for (;;)
+        {
+            juce::File victim;
+
+            {
+                const juce::ScopedLock lock(stateLock);
+
+                juce::int64 total = 0;
+                for (auto& item : items)
+                    total += item.second.size;
+
+                if (total <= limit)
+                    return;
+
+                auto oldest = items.end();
+                for (auto it = items.begin(); it != items.end(); ++it)
+                    if (it->second.pinCount == 0 && otherPins.count(it->first) == 0
+                        && (oldest == items.end() || it->second.lastAccessMs < oldest->second.lastAccessMs))
+                        oldest = it;
+
+                // Tout est référencé : la limite est dépassée tant que les sessions les gardent
+                if (oldest == items.end())
+                    return;
+
+                victim = storeDirectory.getChildFile(oldest->first + oldest->second.extension);
+                removeAliases(oldest->first);
+                items.erase(oldest);
+                dirty = true;
+            }
+
+            victim.deleteFile();
+        }
+    }
+
+    // Fichiers du répertoire absents de l'index (autre processus, index perdu) et entrées
+    // dont le fichier a disparu ; copies partielles abandonnées
+    void reconcile()
+    {
+        const juce::InterProcessLock::ScopedLockType directory(directoryLock);
+        if (!directory.isLocked())
+            return;
+
+        std::map<juce::String, Item> found;
+        const juce::int64 now = juce::Time::currentTimeMillis();
+
+        for (const auto& entry : juce::RangedDirectoryIterator(storeDirectory, false, "*", juce::File::findFiles))
+        {
+            const juce::File file = entry.getFile();
+
+            if (file.getFileExtension() == ".part")
+            {
+                // Seulement une copie de contenu (<empreinte>.<ext>...part) assez ancienne pour ne
+                // plus être en cours : l'index qu'un autre processus écrit n'en est pas une
+                if (isContentPartial(file) && now - entry.getModificationTime().toMilliseconds() >= legacyMinimumAgeMs)
+                    file.deleteFile();
+                continue;
+            }
+
+            const juce::String hash = getHash(file);
+            if (hash.isEmpty())
+                continue;
+
+            Item item;
+            item.extension = file.getFileExtension();
+            item.size = entry.getFileSize();
+            item.lastAccessMs = entry.getModificationTime().toMilliseconds();
+            found[hash] = item;
+        }
+
+        const juce::ScopedLock lock(stateLock);
+
+        for (auto& item : found)
+        {
+            auto it = items.find(item.first);
+            if (it == items.end())
+                items[item.first] = item.second;
+            else
+                it->second.size = item.second.size;
+        }
+
+        for (auto it = items.begin(); it != items.end();)
+        {
+            if (found.count(it->first) == 0)
+            {
+                removeAliases(it->first);
+                it = items.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        dirty = true;
+    }
+
+    // Les GenIR_<date>.wav d'avant le stockage, assez anciens pour ne plus être en cours d'écriture
+    void importLegacyFiles()
+    {
+        const juce::int64 now = juce::Time::currentTimeMillis();
+
+        for (const auto& entry : juce::RangedDirectoryIterator(legacyDirectory, false, "GenIR_*", juce::File::findFiles))
+        {
+            if (threadShouldExit())
+                return;
+
+            if (now - entry.getModificationTime().toMilliseconds() >= legacyMinimumAgeMs)
+                add(entry.getFile());
+        }
+    }
+
+    static bool isContentPartial(const juce::File& file)
+    {
+        const juce::String name = file.getFileName();
+        return name.length() > 64 && name[64] == '.' && name.substring(0, 64).containsOnly("0123456789abcdef");
+    }
+
+    void removeAliases(const juce::String& hash)
+    {
+        for (auto it = aliases.begin(); it != aliases.end();)
+        {
+            if (it->second == hash)
+                it = aliases.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    //==============================================================================
+    struct Index
+    {
+        std::map<juce::String, Item> items;
+        std::map<juce::String, juce::String> aliases;
+        juce::int64 maximumSize = defaultMaximumSize;
+    };
+
+    Index readIndex() const
+    {
+        Index index;
+        const juce::var root = juce::JSON::parse(indexFile);
+        index.maximumSize = (juce::int64) root.getProperty("maximumSize", defaultMaximumSize);
+
+        if (auto* list = root["items"].getArray())
+        {
+            for (auto& value : *list)
+            {
+                Item item;
+                item.extension = value["extension"].toString();
+                item.size = (juce::int64) value["size"];
+                item.lastAccessMs = (juce::int64) value["lastAccess"];
+                index.items[value["hash"].toString()] = item;
+            }
+        }
+
+        if (auto* names = root["aliases"].getDynamicObject())
+            for (auto& alias : names->getProperties())
+                index.aliases[alias.name.toString()] = alias.value.toString();
+
+        return index;
+    }
+
+    void load()
+    {
+        Index index = readIndex();
+        maximumSize = index.maximumSize;
+
+        const juce::ScopedLock lock(stateLock);
+        items = std::move(index.items);
+        aliases = std::move(index.aliases);
+    }
+
+    // L'index écrit entre-temps par les autres processus est fusionné, pas écrasé : leurs ajouts
+    // sont gardés, et une entrée dont le fichier a disparu (éviction ailleurs) est retirée
+    void save()
+    {
+        {
+            const juce::ScopedLock lock(stateLock);
+            if (!dirty)
+                return;
+        }
+
+        const juce::InterProcessLock::ScopedLockType directory(directoryLock);
+        if (!directory.isLocked())
+            return;
+
+        const Index stored = readIndex();
+
+        // Limite changée ici depuis la dernière écriture : elle l'emporte sur celle du fichier
+        if (!maximumSizeChanged.exchange(false))
+            maximumSize = stored.maximumSize;
+
+        juce::Array<juce::var> list;
+        auto* names = new juce::DynamicObject();
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            dirty = false;
+
+            for (auto& item : stored.items)
+            {
+                auto it = items.find(item.first);
+                if (it == items.end())
+                    items[item.first] = item.second;
+                else
+                    it->second.lastAccessMs = juce::jmax(it->second.lastAccessMs, item.second.lastAccessMs);
+            }
+
+            for (auto it = items.begin(); it != items.end();)
+            {
+                if (storeDirectory.getChildFile(it->first + it->second.extension).existsAsFile())
+                {
+                    ++it;
+                    continue;
+                }
+
+                removeAliases(it->first);
+                it = items.erase(it);
+            }
+
+            for (auto& alias : stored.aliases)
+                if (items.count(alias.second) > 0)
+                    aliases.emplace(alias.first, alias.second);
+
+            for (auto& item : items)
+            {
+                auto* object = new juce::DynamicObject();
+                object->setProperty("hash", item.first);
+                object->setProperty("extension", item.second.extension);
+                object->setProperty("size", item.second.size);
+                object->setProperty("lastAccess", item.second.lastAccessMs);
+                list.add(juce::var(object));
+            }
+
+            for (auto& alias : aliases)
+                names->setProperty(alias.first, alias.second);
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("maximumSize", maximumSize.load());
+        root->setProperty("items", list);
+        root->setProperty("aliases", juce::var(names));
+
+        const juce::File partial = indexFile.getSiblingFile(indexFile.getFileName() + ".part");
+        if (!partial.replaceWithText(juce::JSON::toString(juce::var(root), true)) || !partial.moveFileTo(indexFile))
+            partial.deleteFile();
+    }
+
+    const juce::File legacyDirectory;
+    const juce::File storeDirectory;
+    const juce::File indexFile;
+    const juce::File pinDirectory;
+    const juce::File pinFile;   // Pins de ce processus
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    // Compactage, réconciliation et écriture de l'index, entre processus. Pris seulement par le
+    // thread de compactage (et le destructeur, après son arrêt).
+    juce::InterProcessLock directoryLock { "GenIR_Store" };
+    juce::CriticalSection pinFileLock;
+
+    mutable juce::CriticalSection stateLock;
+    std::map<juce::String, Item> items;             // par empreinte
+    std::map<juce::String, juce::String> aliases;   // ancien chemin -> empreinte
+    bool dirty = false;
+    std::atomic<juce::int64> maximumSize { defaultMaximumSize };
+    std::atomic<bool> maximumSizeChanged { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRStore)
+};
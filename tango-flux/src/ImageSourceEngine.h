@@ -0,0 +1,440 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ImpulseResponse.h"
+#include "ProceduralIRSynth.h"
+#include "TraceLog.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+// Salle parallélépipédique pour le calcul des premières réflexions : dimensions, matériau de
+// chacune des six parois, positions de la source et de l'auditeur. Axes : x sur la longueur,
+// y sur la largeur, z sur la hauteur ; l'origine est un coin au sol.
+struct RoomGeometry
+{
+    enum Wall { left, right, front, back, floor, ceiling, numWalls };   // x = 0, x = L, y = 0, y = W, z = 0, z = H
+
+    double length = 11.0, width = 8.6, height = 5.3;   // m
+    std::array<juce::String, numWalls> wallMaterials;   // vide : absorption de wallAbsorption
+    std::array<RoomModel::Bands, numWalls> wallAbsorption {};
+    std::array<double, 3> source {};
+    std::array<double, 3> listener {};
+    double earSpacing = 0.18;                            // m, écart des deux canaux
+
+    RoomGeometry()
+    {
+        for (auto& bands : wallAbsorption)
+            bands = RoomModel().absorption;
+
+        placeSourceAndListener();
+    }
+
+    // Matériau d'une paroi ; un nom inconnu garde l'absorption précédente
+    void setWallMaterial(Wall wall, const juce::String& material)
+    {
+        RoomModel::Bands bands;
+        if (RoomModel::findMaterial(material.toLowerCase(), bands))
+        {
+            wallMaterials[(size_t) wall] = material.toLowerCase();
+            wallAbsorption[(size_t) wall] = bands;
+        }
+    }
+
+    // Source et auditeur aux positions habituelles d'une prise de son : à un tiers et deux
+    // tiers de la longueur, à hauteur d'oreille, légèrement décalés du plan médian
+    void placeSourceAndListener()
+    {
+        source = { length * 0.65, width * 0.4, juce::jmin(1.7, height * 0.5) };
+        listener = { length * 0.35, width * 0.5, juce::jmin(1.5, height * 0.45) };
+    }
+
+    // Géométrie décrite par les mots-clés : dimensions et absorption moyenne du modèle de
+    // salle, et matériau du sol s'il est nommé (« wooden floor », « marble floor »).
+    // Un lieu extérieur n'a qu'un sol : les autres parois absorbent tout.
+    static RoomGeometry fromPrompt(const juce::String& prompt)
+    {
+        const RoomModel room = RoomModel::fromPrompt(prompt);
+
+        RoomGeometry geometry;
+        geometry.length = room.length;
+        geometry.width = room.width;
+        geometry.height = room.height;
+
+        for (auto& bands : geometry.wallAbsorption)
+            bands = room.absorption;
+
+        juce::StringArray words;
+        words.addTokens(prompt.toLowerCase(), " \t\r\n,.;:!?()\"'", "");
+        words.removeEmptyStrings();
+
+        for (int i = 1; i < words.size(); ++i)
+            if (words[i] == "floor")
+                geometry.setWallMaterial(floor, words[i - 1] == "wooden" ? juce::String("wood") : words[i - 1]);
+
+        if (room.outdoor)
+        {
+            RoomModel::Bands open;
+            open.fill(1.0);
+
+            for (int wall = 0; wall < numWalls; ++wall)
+                if (wall != floor)
+                    geometry.wallAbsorption[(size_t) wall] = open;
+
+            // Assez grand pour que les parois absentes ne comptent pas
+            geometry.length = geometry.width = 100.0;
+            geometry.height = 50.0;
+        }
+
+        geometry.placeSourceAndListener();
+        return geometry;
+    }
+};
+
+// Premières réflexions calculées d'une instance du plugin, appliquées à chaque IR générée
+struct EarlyReflectionSettings
+{
+    bool enabled = false;
+    int maxOrder = 6;
+    bool geometryFromPrompt = true;     // sinon, geometry (dimensions et matériaux donnés)
+    RoomGeometry geometry;
+
+    juce::ValueTree toValueTree() const
+    {
+        juce::StringArray materials;
+        for (auto& material : geometry.wallMaterials)
+            materials.add(material);
+
+        juce::ValueTree tree("EarlyReflections");
+        tree.setProperty("enabled", enabled, nullptr);
+        tree.setProperty("maxOrder", maxOrder, nullptr);
+        tree.setProperty("geometryFromPrompt", geometryFromPrompt, nullptr);
+        tree.setProperty("length", geometry.length, nullptr);
+        tree.setProperty("width", geometry.width, nullptr);
+        tree.setProperty("height", geometry.height, nullptr);
+        tree.setProperty("walls", materials.joinIntoString(","), nullptr);
+        return tree;
+    }
+
+    static EarlyReflectionSettings fromValueTree(const juce::ValueTree& tree)
+    {
+        EarlyReflectionSettings settings;
+        if (!tree.isValid())
+            return settings;
+
+        settings.enabled = tree.getProperty("enabled", false);
+        settings.maxOrder = tree.getProperty("maxOrder", 6);
+        settings.geometryFromPrompt = tree.getProperty("geometryFromPrompt", true);
+        settings.geometry.length = juce::jmax(1.0, (double) tree.getProperty("length", 11.0));
+        settings.geometry.width = juce::jmax(1.0, (double) tree.getProperty("width", 8.6));
+        settings.geometry.height = juce::jmax(1.0, (double) tree.getProperty("height", 5.3));
+
+        juce::StringArray materials;
+        materials.addTokens(tree.getProperty("walls").toString(), ",", "");
+
+        for (int wall = 0; wall < juce::jmin((int) RoomGeometry::numWalls, materials.size()); ++wall)
+            settings.geometry.setWallMaterial((RoomGeometry::Wall) wall, materials[wall]);
+
+        settings.geometry.placeSourceAndListener();
+        return settings;
+    }
+};
+
+// Premières réflexions par la méthode des sources images (Allen et Berkley) : chaque réflexion
+// jusqu'à l'ordre demandé est une image de la source par rapport aux parois, atténuée dans
+// chaque bande d'octave par les parois traversées et par la distance. Le calcul est réparti
+// sur tous les cœurs ; les réflexions de chaque bande sont ensuite filtrées dans leur octave.
+//
+// Partagé par toutes les instances du processus (SharedResourcePointer) pour n'avoir qu'un
+// pool de threads ; render() peut être appelé depuis plusieurs threads à la fois.
+class ImageSourceEngine
+{
+public:
+    static constexpr int maxSupportedOrder = 20;
+
+    ImageSourceEngine()
+        : pool(juce::jmax(1, juce::SystemStats::getNumCpus()))
+    {
+    }
+
+    ~ImageSourceEngine()
+    {
+        pool.removeAllJobs(true, 5000);
+    }
+
+    // Réflexions stéréo (sans le son direct) jusqu'à maxOrder, sur lengthSeconds. Le temps 0
+    // est l'arrivée du son direct, dont l'amplitude vaut 1.
+    juce::AudioBuffer<float> render(const RoomGeometry& geometry, int maxOrder, double sampleRate, double lengthSeconds)
+    {
+        const TraceLog::Span span(*trace, "image sources", "dsp", "order " + juce::String(maxOrder));
+
+        const int order = juce::jlimit(1, maxSupportedOrder, maxOrder);
+        const int numSamples = juce::jmax(1, juce::roundToInt(lengthSeconds * sampleRate));
+
+        // Une tâche par indice d'image sur la longueur : de -order à order
+        const int numTasks = 2 * order + 1;
+        std::vector<Accumulator> accumulators((size_t) numTasks, Accumulator(numSamples));
+
+        std::atomic<int> remaining { numTasks };
+        juce::WaitableEvent done;
+
+        for (int task = 0; task < numTasks; ++task)
+        {
+            pool.addJob([&, task]
+                {
+                    accumulateImages(geometry, order, task - order, sampleRate, accumulators[(size_t) task]);
+
+                    if (--remaining == 0)
+                        done.signal();
+                });
+        }
+
+        done.wait();
+
+        // Somme des tâches, puis chaque bande dans son octave
+        juce::AudioBuffer<float> output(2, numSamples);
+        output.clear();
+
+        std::vector<float> band((size_t) numSamples);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            for (int b = 0; b < RoomModel::numBands; ++b)
+            {
+                std::fill(band.begin(), band.end(), 0.0f);
+
+                for (auto& accumulator : accumulators)
+                {
+                    const float* source = accumulator.get(ch, b);
+                    for (int i = 0; i < numSamples; ++i)
+                        band[(size_t) i] += source[i];
+                }
+
+                juce::IIRFilter filter;
+                filter.setCoefficients(makeBandFilter(b, sampleRate));
+                filter.processSamples(band.data(), numSamples);
+
+                output.addFrom(ch, 0, band.data(), numSamples);
+            }
+        }
+
+        return output;
+    }
+
+    // Remplace les premières réflexions de ir par celles de la salle décrite par settings
+    // (ou par prompt). Sans effet si les réflexions calculées sont désactivées.
+    void apply(ImpulseResponse& ir, const EarlyReflectionSettings& settings, const juce::String& prompt)
+    {
+        if (!settings.enabled || !ir.isValid())
+            return;
+
+        RoomGeometry geometry = settings.geometry;
+        double mixingTime = 0.0;
+
+        if (settings.geometryFromPrompt)
+        {
+            geometry = RoomGeometry::fromPrompt(prompt);
+            mixingTime = RoomModel::fromPrompt(prompt).getMixingTime();
+        }
+        else
+        {
+            const double volume = geometry.length * geometry.width * geometry.height;
+            mixingTime = juce::jlimit(0.005, 0.15, std::sqrt(volume) * 0.001);
+        }
+
+        splice(ir, render(geometry, settings.maxOrder, ir.sampleRate, mixingTime), mixingTime);
+    }
+
+    // Remplace le début de target (ses premières réflexions, souvent floues dans une IR générée)
+    // par early, rendu par render(). Le son direct de target est conservé ; early est aligné
+    // sur lui et mis à son niveau, puis s'efface au profit de la queue de target entre 1 ms
+    // après le son direct et mixingTime.
+    static void splice(ImpulseResponse& target, const juce::AudioBuffer<float>& early, double mixingTime)
+    {
+        auto& samples = target.samples;
+        const int numSamples = samples.getNumSamples();
+        const int numChannels = samples.getNumChannels();
+
+        if (numSamples == 0 || numChannels == 0)
+            return;
+
+        // Son direct : le pic des 100 premières millisecondes
+        const int searchLength = juce::jmin(numSamples, (int) (0.1 * target.sampleRate));
+        int directIndex = 0;
+        float directLevel = 0.0f;
+
+        for (int i = 0; i < searchLength; ++i)
+        {
+            float level = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                level += std::abs(samples.getSample(ch, i));
+
+            if (level > directLevel)
+            {
+                directLevel = level;
+                directIndex = i;
+            }
+        }
+
+        directLevel /= (float) numChannels;
+        if (directLevel <= 0.0f)
+            return;
+
+        const int start = directIndex + juce::jmax(1, (int) (0.001 * target.sampleRate));
+        const int end = juce::jmax(start + 1, directIndex + (int) (mixingTime * target.sampleRate));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* output = samples.getWritePointer(ch);
+            const float* reflections = early.getReadPointer(ch % early.getNumChannels());
+
+            for (int i = start; i < juce::jmin(end, numSamples); ++i)
+            {
+                // Fondu en cosinus : la queue générée monte pendant que les réflexions s'effacent
+                const float fade = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (float) (i - start) / (float) (end - start));
+                const int e = i - directIndex;
+                const float reflection = e < early.getNumSamples() ? reflections[e] * directLevel : 0.0f;
+
+                output[i] = output[i] * fade + reflection * (1.0f - fade);
+            }
+        }
+
+        // Les spectres préparés ailleurs ne correspondent plus
+        target.prepared.clear();
+    }
+
+private:
+    // Réflexions d'une tâche, séparées par canal et par bande
+    struct Accumulator
+    {
+        explicit Accumulator(int length)
+            : numSamples(length), data((size_t) (2 * RoomModel::numBands * length), 0.0f)
+        {
+        }
+
+        float* get(int channel, int band)
+        {
+            return data.data() + (size_t) ((channel * RoomModel::numBands + band) * numSamples);
+        }
+
+        void add(int channel, int band, double position, double gain)
+        {
+            // Retard fractionnaire : interpolation linéaire entre les deux échantillons voisins
+            const int index = (int) position;
+            if (index < 0 || index + 1 >= numSamples)
+                return;
+
+            const double fraction = position - index;
+            float* target = get(channel, band);
+            target[index] += (float) (gain * (1.0 - fraction));
+            target[index + 1] += (float) (gain * fraction);
+        }
+
+        int numSamples;
+        std::vector<float> data;
+    };
+
+    // Toutes les images d'indice nx sur la longueur. Sur chaque axe, l'image (n, q) est en
+    // (1 - 2q) s + 2nL et a traversé |n - q| fois la paroi en 0 et |n| fois la paroi en L.
+    static void accumulateImages(const RoomGeometry& geometry, int order, int nx, double sampleRate, Accumulator& accumulator)
+    {
+        const double dims[3] = { geometry.length, geometry.width, geometry.height };
+        const double c = RoomModel::speedOfSound;
+
+        // Réflectance en amplitude de chaque paroi, par bande
+        std::array<RoomModel::Bands, RoomGeometry::numWalls> reflectance;
+        for (int wall = 0; wall < RoomGeometry::numWalls; ++wall)
+            for (int b = 0; b < RoomModel::numBands; ++b)
+                reflectance[(size_t) wall][(size_t) b] = std::sqrt(juce::jlimit(0.0, 1.0, 1.0 - geometry.wallAbsorption[(size_t) wall][(size_t) b]));
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            std::array<double, 3> listener = geometry.listener;
+            listener[1] += (ch == 0 ? -0.5 : 0.5) * geometry.earSpacing;
+
+            const double directDistance = juce::jmax(0.1, distance(geometry.source, listener));
+
+            for (int qx = 0; qx < 2; ++qx)
+            {
+                const int hitsX = std::abs(nx - qx) + std::abs(nx);
+                if (hitsX > order)
+                    continue;
+
+                const double x = (1 - 2 * qx) * geometry.source[0] + 2.0 * nx * dims[0];
+
+                for (int ny = -order; ny <= order; ++ny)
+                {
+                    for (int qy = 0; qy < 2; ++qy)
+                    {
+                        const int hitsY = std::abs(ny - qy) + std::abs(ny);
+                        if (hitsX + hitsY > order)
+                            continue;
+
+                        const double y = (1 - 2 * qy) * geometry.source[1] + 2.0 * ny * dims[1];
+
+                        for (int nz = -order; nz <= order; ++nz)
+                        {
+                            for (int qz = 0; qz < 2; ++qz)
+                            {
+                                const int hitsZ = std::abs(nz - qz) + std::abs(nz);
+                                const int totalHits = hitsX + hitsY + hitsZ;
+
+                                // Le son direct est dans la queue générée
+                                if (totalHits == 0 || totalHits > order)
+                                    continue;
+
+                                const double z = (1 - 2 * qz) * geometry.source[2] + 2.0 * nz * dims[2];
+                                const double d = distance({ x, y, z }, listener);
+                                const double position = (d - directDistance) / c * sampleRate;
+
+                                if (position >= accumulator.numSamples)
+                                    continue;
+
+                                const int hits[RoomGeometry::numWalls] = { std::abs(nx - qx), std::abs(nx),
+                                                                           std::abs(ny - qy), std::abs(ny),
+                                                                           std::abs(nz - qz), std::abs(nz) };
+
+                                for (int b = 0; b < RoomModel::numBands; ++b)
+                                {
+                                    double gain = directDistance / d;
+                                    for (int wall = 0; wall < RoomGeometry::numWalls; ++wall)
+                                        if (hits[wall] > 0)
+                                            gain *= std::pow(reflectance[(size_t) wall][(size_t) b], hits[wall]);
+
+                                    accumulator.add(ch, b, position, gain);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Bande extrême : passe-bas ou passe-haut, pour que la somme des bandes couvre tout le spectre
+    static juce::IIRCoefficients makeBandFilter(int band, double sampleRate)
+    {
+        const double frequency = juce::jmin(RoomModel::bandFrequencies[(size_t) band], sampleRate * 0.45);
+
+        if (band == 0)
+            return juce::IIRCoefficients::makeLowPass(sampleRate, frequency * 1.41);
+
+        if (band == RoomModel::numBands - 1)
+            return juce::IIRCoefficients::makeHighPass(sampleRate, frequency / 1.41);
+
+        return juce::IIRCoefficients::makeBandPass(sampleRate, frequency, 1.41);
+    }
+
+    static double distance(const std::array<double, 3>& a, const std::array<double, 3>& b)
+    {
+        const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    juce::ThreadPool pool;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImageSourceEngine)
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GenIRFile.h"
+#include "PreparedIR.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// IR décodée en mémoire, prête à être installée dans la convolution.
+// Le décodage (WAV, FLAC, Ogg...) se fait sur le thread qui a obtenu le fichier,
+// jamais sur le thread de l'interface ni sur le thread audio.
+//
+// Un conteneur .genir (GenIRFile) n'est pas décodé : il est projeté en mémoire et samples fait
+// référence à ses pages, en lecture seule. Une copie de l'IR a ses propres échantillons.
+struct ImpulseResponse
+{
+    juce::AudioBuffer<float> samples;
+    double sampleRate = 0.0;
+    juce::File source;
+
+    // Spectres partitionnés de cette IR, s'ils ont déjà été calculés ailleurs (démon GenIR,
+    // conteneur .genir), un par configuration. La convolution utilise directement celui qui
+    // correspond à la sienne.
+    std::vector<std::shared_ptr<const PreparedIR>> prepared;
+
+    // Recette et analyse lues dans un conteneur .genir
+    bool hasRecipe = false;
+    GenIRRecipe recipe;
+    bool hasAnalysis = false;
+    IRFeatures analysis;
+
+    // Fichier projeté auquel samples fait référence (conteneur .genir), nullptr sinon
+    std::shared_ptr<const juce::MemoryMappedFile> mapping;
+
+    bool isValid() const noexcept
+    {
+        return samples.getNumSamples() > 0 && sampleRate > 0.0;
+    }
+
+    // Spectres complets préparés pour cette configuration, nullptr s'il n'y en a pas
+    std::shared_ptr<const PreparedIR> findPrepared(double targetSampleRate, int blockSize,
+                                                   SpectrumPrecision precision = SpectrumPrecision::float32) const
+    {
+        for (auto& spectra : prepared)
+            if (spectra != nullptr && spectra->complete && spectra->tailPrecision == precision
+                && spectra->sampleRate == targetSampleRate && spectra->blockSize == blockSize)
+                return spectra;
+
+        return nullptr;
+    }
+
+    // Décode un fichier audio dans la mémoire de l'IR, ou projette un conteneur .genir.
+    // Retourne false si le format est inconnu ou le fichier vide.
+    bool loadFromFile(const juce::File& file)
+    {
+        if (GenIRFile::isContainer(file))
+        {
+            GenIRFile::MappedContents contents;
+            if (!GenIRFile::read(file, contents))
+                return false;
+
+            samples = std::move(contents.samples);
+            sampleRate = contents.sampleRate;
+            prepared = std::move(contents.spectra);
+            hasRecipe = contents.hasRecipe;
+            recipe = contents.recipe;
+            hasAnalysis = contents.hasAnalysis;
+            analysis = contents.analysis;
+            mapping = std::move(contents.mapping);
+            source = file;
+            return true;
+        }
+
+        // Plus rien d'un conteneur projeté : setSize() doit allouer la mémoire des échantillons
+        samples = juce::AudioBuffer<float>();
+        mapping.reset();
+        prepared.clear();
+        hasRecipe = hasAnalysis = false;
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+            return false;
+
+        const int numSamples = (int) reader->lengthInSamples;
+        samples.setSize((int) reader->numChannels, numSamples);
+
+        if (!reader->read(&samples, 0, numSamples, 0, true, true))
+            return false;
+
+        sampleRate = reader->sampleRate;
+        source = file;
+        return true;
+    }
+
+    // Extension correspondant au contenu réel d'un fichier audio (d'après son en-tête),
+    // ou defaultExtension si le format n'est pas reconnu
+    static juce::String detectFileExtension(const juce::File& file, const juce::String& defaultExtension)
+    {
+        juce::FileInputStream in(file);
+        char magic[4] = {};
+
+        if (!in.openedOk() || in.read(magic, 4) != 4)
+            return defaultExtension;
+
+        if (std::memcmp(magic, "RIFF", 4) == 0)  return ".wav";
+        if (std::memcmp(magic, "fLaC", 4) == 0)  return ".flac";
+        if (std::memcmp(magic, "OggS", 4) == 0)  return ".ogg";
+        if (std::memcmp(magic, "GNIR", 4) == 0)  return GenIRFile::fileExtension;
+
+        return defaultExtension;
+    }
+};
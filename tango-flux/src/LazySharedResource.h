@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// juce::SharedResourcePointer créé au premier accès plutôt qu'à la construction de l'objet qui
+// le contient. Les ressources partagées du plugin (threads, index sur disque) ne démarrent ainsi
+// qu'une fois utilisées : un hôte qui ne fait qu'instancier le plugin (scan) ne les paie pas.
+// L'accès est sûr depuis plusieurs threads ; il ne doit pas se faire depuis le thread audio.
+template <typename SharedObject>
+class LazySharedResource
+{
+public:
+    LazySharedResource() = default;
+
+    SharedObject& get() const
+    {
+        std::call_once(once, [this]
+            {
+                pointer = std::make_unique<juce::SharedResourcePointer<SharedObject>>();
+                created = true;
+            });
+
+        return **pointer;
+    }
+
+    SharedObject* operator->() const { return &get(); }
+    SharedObject& operator*() const { return get(); }
+
+    // Vrai si la ressource a déjà été créée (ne la crée pas)
+    bool isCreated() const noexcept
+    {
+        return created.load();
+    }
+
+private:
+    mutable std::once_flag once;
+    mutable std::unique_ptr<juce::SharedResourcePointer<SharedObject>> pointer;
+    mutable std::atomic<bool> created { false };
+
+    JUCE_DECLARE_NON_COPYABLE(LazySharedResource)
+};
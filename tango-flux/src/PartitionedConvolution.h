@@ -0,0 +1,1203 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfFloat.h"
+#include "ImpulseResponse.h"
+#include "PreparedIR.h"
+#include "ProgressiveStream.h"
+#include "TraceLog.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Remplit un PreparedIR à partir d'échantillons reçus par morceaux : rééchantillonnage vers
+// la fréquence de traitement, découpage en partitions, FFT, puis publication au thread audio.
+class IRPartitioner
+{
+public:
+    IRPartitioner(PreparedIR& destination, double sourceSampleRate)
+        : target(destination),
+          ratio(sourceSampleRate / destination.sampleRate),
+          fft(juce::roundToInt(std::log2((double) destination.fftSize))),
+          pending((size_t) destination.numChannels),
+          interpolators((size_t) destination.numChannels),
+          block(destination.numChannels, destination.blockSize),
+          fftData((size_t) (2 * destination.fftSize), true),
+          energy((size_t) destination.numChannels, 0.0),
+          minimumProvisionalSamples(juce::roundToInt(destination.sampleRate * provisionalSeconds))
+    {
+        block.clear();
+    }
+
+    // Nombre de partitions couvrant numSourceSamples échantillons à la fréquence source
+    static int getNumPartitions(juce::int64 numSourceSamples, double sourceSampleRate,
+                                double targetSampleRate, int blockSize)
+    {
+        const double resampled = std::ceil((double) numSourceSamples * targetSampleRate / sourceSampleRate);
+        return juce::jmax(1, (int) std::ceil((resampled + 8.0) / (double) blockSize));
+    }
+
+    // Ajoute numSamples échantillons de chaque canal de source (à la fréquence source).
+    // Une source mono alimente tous les canaux de l'IR.
+    void append(const juce::AudioBuffer<float>& source, int numSamples)
+    {
+        if (numSamples <= 0 || source.getNumChannels() == 0)
+            return;
+
+        const int numChannels = target.numChannels;
+
+        if (ratio == 1.0)
+        {
+            const float* channels[2] = {};
+            for (int ch = 0; ch < numChannels; ++ch)
+                channels[ch] = source.getReadPointer(juce::jmin(ch, source.getNumChannels() - 1));
+
+            pushSamples(channels, numSamples);
+            return;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* input = source.getReadPointer(juce::jmin(ch, source.getNumChannels() - 1));
+            pending[(size_t) ch].insert(pending[(size_t) ch].end(), input, input + numSamples);
+        }
+
+        // Garder quelques échantillons d'avance pour l'interpolateur
+        const int available = (int) pending[0].size();
+        resample(juce::jmax(0, (int) std::floor((available - 8) / ratio)));
+    }
+
+    // Fin de l'IR : dernière partition complétée par des zéros, normalisation définitive
+    void finish()
+    {
+        if (ratio != 1.0 && !pending[0].empty())
+            resample((int) std::ceil((double) pending[0].size() / ratio));
+
+        if (fill > 0)
+            transformBlock();
+
+        finished = true;
+        publish();
+        target.complete = true;
+    }
+
+    bool hasOverflowed() const noexcept
+    {
+        return overflowed;
+    }
+
+    // Temps passé à rééchantillonner et à transformer les partitions, pour le journal des étapes
+    juce::int64 getResampleMicroseconds() const noexcept { return resampleUs; }
+    juce::int64 getTransformMicroseconds() const noexcept { return transformUs; }
+
+private:
+    static constexpr double provisionalSeconds = 0.05;
+
+    void resample(int numOut)
+    {
+        if (numOut <= 0)
+            return;
+
+        const juce::int64 startUs = TraceLog::nowUs();
+        resampled.setSize(target.numChannels, numOut, false, false, true);
+        const int available = (int) pending[0].size();
+
+        for (int ch = 0; ch < target.numChannels; ++ch)
+        {
+            auto& input = pending[(size_t) ch];
+            const int used = interpolators[(size_t) ch].process(ratio, input.data(), resampled.getWritePointer(ch),
+                                                                numOut, available, 0);
+            input.erase(input.begin(), input.begin() + juce::jmin(used, (int) input.size()));
+        }
+
+        resampleUs += TraceLog::nowUs() - startUs;
+
+        const float* channels[2] = {};
+        for (int ch = 0; ch < target.numChannels; ++ch)
+            channels[ch] = resampled.getReadPointer(ch);
+
+        pushSamples(channels, numOut);
+    }
+
+    void pushSamples(const float* const* channels, int numSamples)
+    {
+        int done = 0;
+
+        while (done < numSamples)
+        {
+            const int count = juce::jmin(numSamples - done, target.blockSize - fill);
+
+            for (int ch = 0; ch < target.numChannels; ++ch)
+            {
+                const float* input = channels[ch] + done;
+                block.copyFrom(ch, fill, input, count);
+
+                double sum = 0.0;
+                for (int i = 0; i < count; ++i)
+                    sum += (double) input[i] * (double) input[i];
+                energy[(size_t) ch] += sum;
+            }
+
+            fill += count;
+            done += count;
+
+            if (fill == target.blockSize)
+                transformBlock();
+        }
+    }
+
+    void transformBlock()
+    {
+        if (written >= target.capacity)
+        {
+            // Plus long qu'annoncé : la fin est ignorée
+            overflowed = true;
+        }
+        else
+        {
+            const juce::int64 startUs = TraceLog::nowUs();
+
+            for (int ch = 0; ch < target.numChannels; ++ch)
+            {
+                float* data = fftData.getData();
+                juce::FloatVectorOperations::clear(data, 2 * target.fftSize);
+                juce::FloatVectorOperations::copy(data, block.getReadPointer(ch), target.blockSize);
+                fft.performRealOnlyForwardTransform(data, true);
+
+                target.storePartition(ch, written, data);
+            }
+
+            transformUs += TraceLog::nowUs() - startUs;
+            ++written;
+            publish();
+        }
+
+        block.clear();
+        fill = 0;
+    }
+
+    // Rend les nouvelles partitions visibles au thread audio. La normalisation n'est
+    // connue qu'à la fin : en attendant, le gain est calculé sur l'énergie déjà reçue,
+    // après un minimum de provisionalSeconds pour ne pas amplifier un début silencieux.
+    void publish()
+    {
+        if (!finished && written * target.blockSize < minimumProvisionalSamples)
+            return;
+
+        double maximumEnergy = 0.0;
+        for (auto e : energy)
+            maximumEnergy = juce::jmax(maximumEnergy, e);
+
+        const float gain = maximumEnergy > 0.0 ? (float) (1.0 / std::sqrt(maximumEnergy)) : 1.0f;
+
+        // L'énergie ne fait que croître : le gain publié ne remonte jamais
+        target.gain = published ? juce::jmin(target.gain.load(), gain) : gain;
+        target.numReady.store(juce::jmin(written, target.capacity), std::memory_order_release);
+        published = true;
+    }
+
+    PreparedIR& target;
+    const double ratio;
+    juce::dsp::FFT fft;
+
+    std::vector<std::vector<float>> pending;
+    std::vector<juce::LagrangeInterpolator> interpolators;
+    juce::AudioBuffer<float> resampled;
+
+    juce::AudioBuffer<float> block;
+    juce::HeapBlock<float> fftData;
+    int fill = 0;
+    int written = 0;
+
+    std::vector<double> energy;
+    const int minimumProvisionalSamples;
+    bool published = false;
+    bool finished = false;
+    bool overflowed = false;
+
+    juce::int64 resampleUs = 0;
+    juce::int64 transformUs = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRPartitioner)
+};
+
+// Convolution partitionnée uniforme sans latence, dont l'IR peut être installée
+// progressivement. Remplace juce::dsp::Convolution dans la chaîne de traitement :
+// même algorithme (overlap-add, blocs partiels transformés à chaque appel, historique
+// fréquentiel de l'entrée), mais les partitions d'une IR en cours de téléchargement sont
+// utilisées dès qu'elles sont prêtes.
+// Les IRs sont préparées hors du thread audio, puis échangées avec un fondu de 50 ms.
+// Pendant une restauration (muteUntilLoaded), la sortie est muette et la prochaine IR arrive en
+// fondu depuis le silence.
+class PartitionedConvolution
+{
+public:
+    PartitionedConvolution() = default;
+
+    ~PartitionedConvolution()
+    {
+        {
+            const juce::ScopedLock lock(loadLock);
+            ++latestRequest;
+
+            if (progressiveBuffer != nullptr)
+                progressiveBuffer->abort();
+        }
+
+        if (loader != nullptr)
+            loader->removeAllJobs(true, 5000);
+    }
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        std::shared_ptr<const ImpulseResponse> ir;
+        int request = 0;
+        SpectrumPrecision precision = SpectrumPrecision::float32;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            sampleRate = spec.sampleRate;
+            numChannels = juce::jlimit(1, maxChannels, (int) spec.numChannels);
+            blockSize = juce::jlimit(128, 2048, juce::nextPowerOfTwo((int) spec.maximumBlockSize));
+            ir = source;
+            request = latestRequest;
+            precision = tailPrecision;
+        }
+
+        dryBuffer.setSize(numChannels, (int) spec.maximumBlockSize);
+        fadeBuffer.setSize(numChannels, (int) spec.maximumBlockSize);
+        fadeLength = juce::jmax(1, juce::roundToInt(spec.sampleRate * fadeSeconds));
+
+        // Le thread audio est arrêté pendant prepare() : repartir d'un état vide
+        std::unique_ptr<Runner> released[3];
+        {
+            const juce::SpinLock::ScopedLockType lock(swapLock);
+            released[0] = std::move(current);
+            released[1] = std::move(previous);
+            released[2] = std::move(pending);
+            fading = false;
+            fadeFromSilence = false;
+        }
+
+        releaseRetired();
+
+        // Reconstruire l'IR courante pour la nouvelle configuration, sans fondu
+        if (ir != nullptr)
+            queueRunner(buildRunner(*ir, spec.sampleRate, blockSize, precision), request, false);
+    }
+
+    void reset()
+    {
+        const juce::SpinLock::ScopedLockType lock(swapLock);
+
+        if (current != nullptr)
+            current->reset();
+
+        if (previous != nullptr)
+            retire(std::move(previous));
+
+        fading = false;
+        fadeFromSilence = false;
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        auto&& input = context.getInputBlock();
+        auto&& output = context.getOutputBlock();
+
+        const int numSamples = (int) output.getNumSamples();
+        const int channels = juce::jmin((int) output.getNumChannels(), numChannels);
+
+        if (context.isBypassed || numSamples == 0)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                output.copyFrom(input);
+            return;
+        }
+
+        // Copie de l'entrée : le contexte est en général traité en place
+        const float* dry[maxChannels] = {};
+        float* wet[maxChannels] = {};
+        float* faded[maxChannels] = {};
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const int inputChannel = juce::jmin(ch, (int) input.getNumChannels() - 1);
+            dryBuffer.copyFrom(ch, 0, input.getChannelPointer((size_t) inputChannel), numSamples);
+            dry[ch] = dryBuffer.getReadPointer(ch);
+            wet[ch] = output.getChannelPointer((size_t) ch);
+            faded[ch] = fadeBuffer.getWritePointer(ch);
+        }
+
+        takePendingRunner();
+
+        // IR en cours de restauration : rien plutôt que l'ancienne IR ou le signal direct
+        if (muted)
+        {
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::clear(wet[ch], numSamples);
+            return;
+        }
+
+        // Sans IR, la convolution laisse passer le signal (impulsion unité), comme juce::dsp::Convolution
+        if (current == nullptr)
+        {
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::copy(wet[ch], dry[ch], numSamples);
+            return;
+        }
+
+        current->process(dry, wet, channels, numSamples);
+
+        if (!fading)
+            return;
+
+        // Fondu de l'ancienne IR (ou du signal direct, ou du silence après une restauration) vers la nouvelle
+        if (previous != nullptr)
+            previous->process(dry, faded, channels, numSamples);
+        else if (fadeFromSilence)
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::clear(faded[ch], numSamples);
+        else
+            for (int ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::copy(faded[ch], dry[ch], numSamples);
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float g = juce::jmin(1.0f, (float) (fadePosition + i) / (float) fadeLength);
+                wet[ch][i] = wet[ch][i] * g + faded[ch][i] * (1.0f - g);
+            }
+        }
+
+        fadePosition += numSamples;
+
+        if (fadePosition >= fadeLength)
+        {
+            // Sinon, nouvel essai au bloc suivant (gain déjà à 1)
+            const juce::SpinLock::ScopedTryLockType lock(swapLock);
+
+            if (lock.isLocked())
+            {
+                fading = false;
+                fadeFromSilence = false;
+                retire(std::move(previous));
+            }
+        }
+    }
+
+    //==============================================================================
+    // Décode le fichier sur le thread de chargement puis installe l'IR
+    void loadImpulseResponse(const juce::File& file)
+    {
+        const int request = startRequest();
+
+        getLoader().addJob([this, file, request]
+            {
+                auto ir = std::make_shared<ImpulseResponse>();
+                const juce::int64 startUs = TraceLog::nowUs();
+                const bool decoded = ir->loadFromFile(file);
+                trace->record("decode", "dsp", startUs, TraceLog::nowUs(), file.getFileName());
+
+                if (decoded)
+                    install(std::move(ir), request);
+                else
+                    DBG("Cannot decode IR: " + file.getFullPathName());
+            });
+    }
+
+    // Coupe la sortie jusqu'à la prochaine IR installée (ou unmute()), qui arrive alors en fondu
+    // depuis le silence. Les chargements en cours sont abandonnés.
+    void muteUntilLoaded()
+    {
+        std::unique_ptr<Runner> dropped;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            ++latestRequest;
+
+            const juce::SpinLock::ScopedLockType swap(swapLock);
+            dropped = std::move(pending);
+            muteRequested = true;
+        }
+    }
+
+    // Fin de la coupure sans nouvelle IR : l'IR courante revient en fondu
+    void unmute()
+    {
+        const juce::SpinLock::ScopedLockType swap(swapLock);
+        muteRequested = false;
+    }
+
+    // Installe une IR déjà décodée. La préparation (FFT des partitions) se fait sur le thread appelant.
+    void loadImpulseResponse(std::shared_ptr<const ImpulseResponse> ir)
+    {
+        if (ir != nullptr && ir->isValid())
+            install(std::move(ir), startRequest());
+    }
+
+    // Début d'un téléchargement : les partitions sont décodées et installées au fur et à mesure
+    // que les octets arrivent. L'IR complète doit ensuite être passée à finishProgressiveLoad().
+    void beginProgressiveLoad(std::shared_ptr<ProgressiveBuffer> buffer)
+    {
+        int request = 0;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+
+            if (progressiveBuffer != nullptr)
+                progressiveBuffer->abort();
+
+            request = ++latestRequest;
+            progressiveBuffer = buffer;
+            progressiveRequest = request;
+            progressiveState = ProgressiveState::running;
+            finalImpulseResponse.reset();
+        }
+
+        // Les étapes du décodage se rattachent à la génération qui télécharge l'IR
+        const juce::uint32 generation = TraceLog::getCurrentGeneration();
+
+        getLoader().addJob([this, buffer, request, generation]
+            {
+                const TraceLog::ScopedGeneration traced(generation);
+                const bool installed = decodeProgressively(buffer, request);
+                finishProgressiveJob(request, installed);
+            });
+    }
+
+    // IR complète d'un téléchargement progressif. Si ses partitions sont déjà toutes
+    // installées, elle est seulement conservée (pour un changement de fréquence d'échantillonnage) ;
+    // sinon elle est installée normalement.
+    void finishProgressiveLoad(std::shared_ptr<const ImpulseResponse> ir)
+    {
+        {
+            const juce::ScopedLock lock(loadLock);
+
+            if (progressiveRequest == latestRequest)
+            {
+                if (progressiveState == ProgressiveState::running)
+                {
+                    finalImpulseResponse = ir;
+                    return;
+                }
+
+                if (progressiveState == ProgressiveState::succeeded)
+                {
+                    source = ir;
+                    progressiveState = ProgressiveState::none;
+                    return;
+                }
+            }
+
+            progressiveState = ProgressiveState::none;
+        }
+
+        loadImpulseResponse(std::move(ir));
+    }
+
+    // Taille des partitions pour la configuration courante (0 avant prepare())
+    int getPartitionSize() const
+    {
+        const juce::ScopedLock lock(loadLock);
+        return blockSize;
+    }
+
+    // IR source de la convolution (fréquence d'origine), nullptr si aucune
+    std::shared_ptr<const ImpulseResponse> getImpulseResponse() const
+    {
+        const juce::ScopedLock lock(loadLock);
+        return source;
+    }
+
+    // Précision des spectres de la queue (les spectres float32 préparés ailleurs sont convertis
+    // à l'installation). L'IR courante est préparée de nouveau, puis échangée avec un fondu.
+    void setTailPrecision(SpectrumPrecision precision)
+    {
+        std::shared_ptr<const ImpulseResponse> ir;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            if (tailPrecision == precision)
+                return;
+
+            tailPrecision = precision;
+            ir = source;
+        }
+
+        if (ir == nullptr)
+            return;
+
+        const int request = startRequest();
+        getLoader().addJob([this, ir, request] { install(ir, request); });
+    }
+
+    SpectrumPrecision getTailPrecision() const
+    {
+        const juce::ScopedLock lock(loadLock);
+        return tailPrecision;
+    }
+
+private:
+    static constexpr int maxChannels = 2;
+    static constexpr double fadeSeconds = 0.05;
+    static constexpr int progressiveChunkSize = 4096;
+
+    enum class ProgressiveState { none, running, succeeded, failed };
+
+    //==============================================================================
+    // État de convolution d'une IR : historique fréquentiel de l'entrée et recouvrement
+    // de chaque canal traité. Tout est alloué à la construction, hors du thread audio.
+    class Runner
+    {
+    public:
+        Runner(std::shared_ptr<const PreparedIR> prepared, int channels)
+            : ir(std::move(prepared)),
+              numChannels(channels),
+              fft(juce::roundToInt(std::log2((double) ir->fftSize)))
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& state = states[(size_t) ch];
+                state.input.allocate((size_t) ir->fftSize, true);
+                state.history.allocate((size_t) ir->capacity * (size_t) (2 * ir->numBins), true);
+                state.accumulator.allocate((size_t) (2 * ir->numBins), true);
+                state.spectrum.allocate((size_t) (2 * ir->numBins), true);
+                state.overlap.allocate((size_t) ir->blockSize, true);
+                state.fftData.allocate((size_t) (2 * ir->fftSize), true);
+            }
+
+            smoothedGain.reset(ir->sampleRate, 0.05);
+            smoothedGain.setCurrentAndTargetValue(ir->gain.load());
+        }
+
+        const PreparedIR& getPreparedIR() const noexcept
+        {
+            return *ir;
+        }
+
+        // Remise au thread audio, pour mesurer le délai de l'échange dans le journal des étapes
+        juce::int64 queuedAtUs = 0;
+        juce::uint32 generation = 0;
+
+        // Chaînage des Runners retirés (voir retire())
+        std::unique_ptr<Runner> nextRetired;
+
+        void reset() noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& state = states[(size_t) ch];
+                juce::FloatVectorOperations::clear(state.input.getData(), ir->fftSize);
+                juce::FloatVectorOperations::clear(state.history.getData(), ir->capacity * 2 * ir->numBins);
+                juce::FloatVectorOperations::clear(state.overlap.getData(), ir->blockSize);
+                state.inputPosition = 0;
+                state.currentSegment = 0;
+            }
+        }
+
+        void process(const float* const* input, float* const* output, int channels, int numSamples) noexcept
+        {
+            const int ready = juce::jmin(ir->numReady.load(std::memory_order_acquire), ir->capacity);
+            channels = juce::jmin(channels, numChannels);
+
+            for (int ch = 0; ch < channels; ++ch)
+                processChannel(states[(size_t) ch], juce::jmin(ch, ir->numChannels - 1), ready,
+                               input[ch], output[ch], numSamples);
+
+            // Normalisation lissée : elle évolue tant que l'IR arrive
+            smoothedGain.setTargetValue(ir->gain.load());
+            const float startGain = smoothedGain.getCurrentValue();
+            const float endGain = smoothedGain.skip(numSamples);
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                if (startGain == endGain)
+                {
+                    juce::FloatVectorOperations::multiply(output[ch], startGain, numSamples);
+                }
+                else
+                {
+                    const float step = (endGain - startGain) / (float) numSamples;
+                    for (int i = 0; i < numSamples; ++i)
+                        output[ch][i] *= startGain + step * (float) i;
+                }
+            }
+        }
+
+    private:
+        struct ChannelState
+        {
+            juce::HeapBlock<float> input;        // bloc d'entrée en cours, complété par des zéros (fftSize)
+            juce::HeapBlock<float> history;      // spectres des capacity derniers blocs d'entrée
+            juce::HeapBlock<float> accumulator;  // contribution des blocs précédents
+            juce::HeapBlock<float> spectrum;
+            juce::HeapBlock<float> overlap;
+            juce::HeapBlock<float> fftData;
+            int inputPosition = 0;
+            int currentSegment = 0;
+        };
+
+        // acc += x * h, spectres au format réels puis imaginaires
+        static void multiplyAccumulate(const float* x, const float* h, float* acc, int numBins) noexcept
+        {
+            const float* xr = x;
+            const float* xi = x + numBins;
+            const float* hr = h;
+            const float* hi = h + numBins;
+            float* ar = acc;
+            float* ai = acc + numBins;
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+
+        // acc += x * h * scale, pour une partition de la queue stockée sur 16 bits : h est élargi
+        // en float32 dans les registres, par paquets de 4 (SSE2, NEON)
+        static void multiplyAccumulate(const float* x, const juce::uint16* h, float scale,
+                                       SpectrumPrecision precision, float* acc, int numBins) noexcept
+        {
+            const float* xr = x;
+            const float* xi = x + numBins;
+            const juce::uint16* hr = h;
+            const juce::uint16* hi = h + numBins;
+            float* ar = acc;
+            float* ai = acc + numBins;
+            int k = 0;
+
+           #if GENIR_HALF_SSE2
+            const __m128 s = _mm_set1_ps(scale);
+
+            for (; k + 4 <= numBins; k += 4)
+            {
+                const __m128 vhr = _mm_mul_ps(HalfFloat::toFloat4(hr + k, precision), s);
+                const __m128 vhi = _mm_mul_ps(HalfFloat::toFloat4(hi + k, precision), s);
+                const __m128 vxr = _mm_loadu_ps(xr + k);
+                const __m128 vxi = _mm_loadu_ps(xi + k);
+
+                _mm_storeu_ps(ar + k, _mm_add_ps(_mm_loadu_ps(ar + k), _mm_sub_ps(_mm_mul_ps(vxr, vhr), _mm_mul_ps(vxi, vhi))));
+                _mm_storeu_ps(ai + k, _mm_add_ps(_mm_loadu_ps(ai + k), _mm_add_ps(_mm_mul_ps(vxr, vhi), _mm_mul_ps(vxi, vhr))));
+            }
+           #elif GENIR_HALF_NEON
+            for (; k + 4 <= numBins; k += 4)
+            {
+                const float32x4_t vhr = vmulq_n_f32(HalfFloat::toFloat4(hr + k, precision), scale);
+                const float32x4_t vhi = vmulq_n_f32(HalfFloat::toFloat4(hi + k, precision), scale);
+                const float32x4_t vxr = vld1q_f32(xr + k);
+                const float32x4_t vxi = vld1q_f32(xi + k);
+
+                vst1q_f32(ar + k, vmlsq_f32(vmlaq_f32(vld1q_f32(ar + k), vxr, vhr), vxi, vhi));
+                vst1q_f32(ai + k, vmlaq_f32(vmlaq_f32(vld1q_f32(ai + k), vxr, vhi), vxi, vhr));
+            }
+           #endif
+
+            for (; k < numBins; ++k)
+            {
+                const float hrk = HalfFloat::toFloat(hr[k], precision) * scale;
+                const float hik = HalfFloat::toFloat(hi[k], precision) * scale;
+                ar[k] += xr[k] * hrk - xi[k] * hik;
+                ai[k] += xr[k] * hik + xi[k] * hrk;
+            }
+        }
+
+        void processChannel(ChannelState& state, int irChannel, int ready,
+                            const float* input, float* output, int numSamples) noexcept
+        {
+            const int blockSize = ir->blockSize;
+            const int fftSize = ir->fftSize;
+            const int numBins = ir->numBins;
+            const int stride = 2 * numBins;
+            float* fftData = state.fftData.getData();
+            int done = 0;
+
+            while (done < numSamples)
+            {
+                const bool blockStart = state.inputPosition == 0;
+                const int count = juce::jmin(numSamples - done, blockSize - state.inputPosition);
+
+                juce::FloatVectorOperations::copy(state.input.getData() + state.inputPosition, input + done, count);
+
+                // Spectre du bloc d'entrée courant, même incomplet : pas de latence
+                float* segment = state.history.getData() + (size_t) state.currentSegment * (size_t) stride;
+                juce::FloatVectorOperations::copy(fftData, state.input.getData(), fftSize);
+                juce::FloatVectorOperations::clear(fftData + fftSize, fftSize);
+                fft.performRealOnlyForwardTransform(fftData, true);
+
+                for (int k = 0; k < numBins; ++k)
+                {
+                    segment[k] = fftData[2 * k];
+                    segment[numBins + k] = fftData[2 * k + 1];
+                }
+
+                // Contribution des blocs d'entrée précédents, calculée une fois par bloc
+                if (blockStart)
+                {
+                    juce::FloatVectorOperations::clear(state.accumulator.getData(), stride);
+                    int index = state.currentSegment;
+
+                    for (int partition = 1; partition < ready; ++partition)
+                    {
+                        if (++index >= ir->capacity)
+                            index = 0;
+
+                        const float* x = state.history.getData() + (size_t) index * (size_t) stride;
+
+                        if (ir->isFullPrecision(partition))
+                            multiplyAccumulate(x, ir->getPartition(irChannel, partition),
+                                               state.accumulator.getData(), numBins);
+                        else
+                            multiplyAccumulate(x, ir->getCompactPartition(irChannel, partition),
+                                               ir->getCompactScale(irChannel, partition), ir->tailPrecision,
+                                               state.accumulator.getData(), numBins);
+                    }
+                }
+
+                float* spectrum = state.spectrum.getData();
+                juce::FloatVectorOperations::copy(spectrum, state.accumulator.getData(), stride);
+
+                if (ready > 0)
+                    multiplyAccumulate(segment, ir->getPartition(irChannel, 0), spectrum, numBins);
+
+                // Spectre hermitien complet pour la transformée inverse
+                for (int k = 0; k < numBins; ++k)
+                {
+                    fftData[2 * k] = spectrum[k];
+                    fftData[2 * k + 1] = spectrum[numBins + k];
+                }
+
+                for (int k = numBins; k < fftSize; ++k)
+                {
+                    fftData[2 * k] = spectrum[fftSize - k];
+                    fftData[2 * k + 1] = -spectrum[numBins + fftSize - k];
+                }
+
+                fft.performRealOnlyInverseTransform(fftData);
+
+                juce::FloatVectorOperations::add(output + done, fftData + state.inputPosition,
+                                                 state.overlap.getData() + state.inputPosition, count);
+
+                state.inputPosition += count;
+
+                if (state.inputPosition == blockSize)
+                {
+                    // Bloc complet : sa seconde moitié recouvre le bloc suivant
+                    juce::FloatVectorOperations::clear(state.input.getData(), blockSize);
+                    juce::FloatVectorOperations::copy(state.overlap.getData(), fftData + blockSize, blockSize);
+                    state.inputPosition = 0;
+                    state.currentSegment = state.currentSegment > 0 ? state.currentSegment - 1 : ir->capacity - 1;
+                }
+
+                done += count;
+            }
+        }
+
+        std::shared_ptr<const PreparedIR> ir;
+        const int numChannels;
+        juce::dsp::FFT fft;
+        std::array<ChannelState, maxChannels> states;
+        juce::SmoothedValue<float> smoothedGain;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Runner)
+    };
+
+    //==============================================================================
+    // Nouvelle demande de chargement : un téléchargement progressif en cours devient obsolète
+    int startRequest()
+    {
+        const juce::ScopedLock lock(loadLock);
+
+        if (progressiveBuffer != nullptr)
+            progressiveBuffer->abort();
+
+        return ++latestRequest;
+    }
+
+    // Prépare entièrement une IR décodée pour une configuration donnée
+    std::unique_ptr<Runner> buildRunner(const ImpulseResponse& ir, double targetSampleRate, int partitionSize,
+                                        SpectrumPrecision precision) const
+    {
+        const juce::int64 startUs = TraceLog::nowUs();
+
+        // Spectres déjà préparés pour cette configuration (démon GenIR, conteneur .genir) : aucune FFT à refaire
+        if (auto prepared = ir.findPrepared(targetSampleRate, partitionSize, precision))
+        {
+            trace->record("partition FFT", "dsp", startUs, TraceLog::nowUs(), "prepared ahead of time");
+            return std::make_unique<Runner>(std::move(prepared), numChannels);
+        }
+
+        // Spectres float32 alors que la queue est demandée sur 16 bits : conversion, toujours sans FFT
+        if (precision != SpectrumPrecision::float32)
+        {
+            if (auto prepared = ir.findPrepared(targetSampleRate, partitionSize))
+            {
+                auto converted = PreparedIR::withTailPrecision(*prepared, precision);
+                trace->record("partition FFT", "dsp", startUs, TraceLog::nowUs(), "converted from prepared spectra");
+                return std::make_unique<Runner>(std::move(converted), numChannels);
+            }
+        }
+
+        const int irChannels = juce::jmin(maxChannels, ir.samples.getNumChannels());
+        const int numPartitions = IRPartitioner::getNumPartitions(ir.samples.getNumSamples(), ir.sampleRate,
+                                                                  targetSampleRate, partitionSize);
+
+        auto prepared = std::make_shared<PreparedIR>(irChannels, partitionSize, numPartitions, targetSampleRate, precision);
+
+        IRPartitioner partitioner(*prepared, ir.sampleRate);
+        partitioner.append(ir.samples, ir.samples.getNumSamples());
+        partitioner.finish();
+
+        recordPartitioning(partitioner, startUs, ir.sampleRate, targetSampleRate, numPartitions);
+        return std::make_unique<Runner>(std::move(prepared), numChannels);
+    }
+
+    // Le rééchantillonnage et les FFT sont entrelacés : leurs durées cumulées sont notées
+    // comme deux étapes consécutives à partir de startUs
+    void recordPartitioning(const IRPartitioner& partitioner, juce::int64 startUs,
+                            double sourceSampleRate, double targetSampleRate, int numPartitions) const
+    {
+        const juce::int64 resampleEndUs = startUs + partitioner.getResampleMicroseconds();
+
+        if (sourceSampleRate != targetSampleRate)
+            trace->record("resample", "dsp", startUs, resampleEndUs,
+                juce::String(juce::roundToInt(sourceSampleRate)) + " -> " + juce::String(juce::roundToInt(targetSampleRate)) + " Hz");
+
+        trace->record("partition FFT", "dsp", resampleEndUs, resampleEndUs + partitioner.getTransformMicroseconds(),
+            juce::String(numPartitions) + " partitions");
+    }
+
+    // Conserve l'IR source et installe sa version préparée pour la configuration courante
+    void install(std::shared_ptr<const ImpulseResponse> ir, int request)
+    {
+        double targetSampleRate = 0.0;
+        int partitionSize = 0;
+        SpectrumPrecision precision = SpectrumPrecision::float32;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            if (request != latestRequest)
+                return;
+
+            source = ir;
+            targetSampleRate = sampleRate;
+            partitionSize = blockSize;
+            precision = tailPrecision;
+        }
+
+        // Pas encore de configuration : prepare() construira l'IR
+        if (targetSampleRate <= 0.0)
+            return;
+
+        queueRunner(buildRunner(*ir, targetSampleRate, partitionSize, precision), request, true);
+    }
+
+    // Remet un Runner au thread audio, sauf si une demande plus récente ou un changement
+    // de configuration l'a rendu obsolète. Retourne true s'il a été accepté.
+    bool queueRunner(std::unique_ptr<Runner> runner, int request, bool fade)
+    {
+        std::unique_ptr<Runner> replaced;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            const auto& prepared = runner->getPreparedIR();
+
+            if (request != latestRequest || prepared.sampleRate != sampleRate || prepared.blockSize != blockSize)
+                return false;
+
+            runner->queuedAtUs = TraceLog::nowUs();
+            runner->generation = TraceLog::getCurrentGeneration();
+
+            const juce::SpinLock::ScopedLockType swap(swapLock);
+            replaced = std::move(pending);
+            pending = std::move(runner);
+            pendingFades = fade;
+        }
+
+        releaseRetired();
+
+        // Libérer l'IR remplacée une fois son fondu terminé, sans occuper le thread de chargement
+        retiredRelease.schedule();
+
+        return true;
+    }
+
+    // Thread audio : prend le Runner en attente sans jamais bloquer ni libérer de mémoire
+    void takePendingRunner() noexcept
+    {
+        const juce::SpinLock::ScopedTryLockType lock(swapLock);
+
+        if (!lock.isLocked())
+            return;
+
+        if (pending == nullptr)
+        {
+            // Fin d'une coupure sans nouvelle IR : fondu du silence vers l'IR courante
+            if (muted && !muteRequested)
+            {
+                muted = false;
+                retire(std::move(previous));
+                fading = true;
+                fadeFromSilence = true;
+                fadePosition = 0;
+            }
+            else
+            {
+                muted = muteRequested;
+            }
+
+            return;
+        }
+
+        if (muted || muteRequested)
+        {
+            // Première IR après une coupure : fondu depuis le silence
+            retire(std::move(current));
+            retire(std::move(previous));
+            current = std::move(pending);
+            muted = false;
+            muteRequested = false;
+            fading = true;
+            fadeFromSilence = true;
+            fadePosition = 0;
+        }
+        else if (!pendingFades)
+        {
+            retire(std::move(current));
+            retire(std::move(previous));
+            current = std::move(pending);
+            fading = false;
+            fadeFromSilence = false;
+        }
+        else
+        {
+            // Un fondu en cours est abandonné au profit du nouveau
+            retire(std::move(previous));
+            previous = std::move(current);
+            current = std::move(pending);
+            fading = true;
+            fadeFromSilence = false;
+            fadePosition = 0;
+        }
+
+        // Sans verrou ni allocation
+        trace->record("engine swap", "audio", current->queuedAtUs, TraceLog::nowUs(), nullptr, current->generation);
+    }
+
+    // Sous swapLock (thread audio) : met un Runner de côté pour releaseRetired(), en tête de la
+    // chaîne des Runners retirés. Seulement des déplacements de pointeurs : ni allocation ni
+    // libération, quel que soit le nombre d'échanges depuis le dernier nettoyage.
+    void retire(std::unique_ptr<Runner> runner) noexcept
+    {
+        if (runner == nullptr)
+            return;
+
+        runner->nextRetired = std::move(retired);
+        retired = std::move(runner);
+    }
+
+    // Hors du thread audio : libère les Runners retirés. Retourne true si un Runner reste à
+    // retirer plus tard (en attente d'installation ou en fin de fondu).
+    bool releaseRetired()
+    {
+        std::unique_ptr<Runner> released;
+        bool outstanding = false;
+
+        {
+            const juce::SpinLock::ScopedLockType lock(swapLock);
+            released = std::move(retired);
+            outstanding = pending != nullptr || previous != nullptr;
+        }
+
+        while (released != nullptr)
+            released = std::move(released->nextRetired);
+
+        return outstanding;
+    }
+
+    // Libère les Runners retirés après les fondus, sur le thread des messages. Relancé à chaque
+    // installation, arrêté quand plus aucun Runner n'attend d'être retiré.
+    class RetiredRunnerRelease : private juce::Timer
+    {
+    public:
+        explicit RetiredRunnerRelease(PartitionedConvolution& c)
+            : owner(c)
+        {
+        }
+
+        ~RetiredRunnerRelease() override
+        {
+            stopTimer();
+        }
+
+        void schedule()
+        {
+            startTimer(juce::roundToInt(fadeSeconds * 1000.0) + 100);
+        }
+
+    private:
+        void timerCallback() override
+        {
+            if (!owner.releaseRetired())
+                stopTimer();
+        }
+
+        PartitionedConvolution& owner;
+    };
+
+    //==============================================================================
+    // Thread de chargement : décode le flux au fil du téléchargement et publie les partitions.
+    // Retourne true si toute l'IR a été installée ainsi.
+    bool decodeProgressively(const std::shared_ptr<ProgressiveBuffer>& buffer, int request)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        // Le lecteur attend l'en-tête (WAV, FLAC...) puis lit les échantillons à mesure qu'ils arrivent
+        std::unique_ptr<juce::AudioFormatReader> reader(
+            formatManager.createReaderFor(std::make_unique<ProgressiveInputStream>(buffer)));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0 || buffer->isAborted())
+            return false;
+
+        double targetSampleRate = 0.0;
+        int partitionSize = 0;
+        SpectrumPrecision precision = SpectrumPrecision::float32;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            if (request != latestRequest)
+                return false;
+
+            targetSampleRate = sampleRate;
+            partitionSize = blockSize;
+            precision = tailPrecision;
+        }
+
+        if (targetSampleRate <= 0.0)
+            return false;
+
+        const int irChannels = juce::jmin(maxChannels, (int) reader->numChannels);
+        const int numPartitions = IRPartitioner::getNumPartitions(reader->lengthInSamples, reader->sampleRate,
+                                                                  targetSampleRate, partitionSize);
+
+        auto prepared = std::make_shared<PreparedIR>(irChannels, partitionSize, numPartitions, targetSampleRate, precision);
+        IRPartitioner partitioner(*prepared, reader->sampleRate);
+        const juce::int64 startUs = TraceLog::nowUs();
+
+        juce::AudioBuffer<float> chunk((int) reader->numChannels, progressiveChunkSize);
+        bool queued = false;
+
+        for (juce::int64 position = 0; position < reader->lengthInSamples; position += progressiveChunkSize)
+        {
+            const int count = (int) juce::jmin((juce::int64) progressiveChunkSize, reader->lengthInSamples - position);
+
+            if (!reader->read(&chunk, 0, count, position, true, true) || buffer->isAborted())
+                return false;
+
+            partitioner.append(chunk, count);
+
+            // Installer l'IR dès que ses premières partitions sont publiées
+            if (!queued && prepared->numReady.load() > 0)
+            {
+                if (!queueRunner(std::make_unique<Runner>(prepared, numChannels), request, true))
+                    return false;
+                queued = true;
+            }
+        }
+
+        partitioner.finish();
+        recordPartitioning(partitioner, startUs, reader->sampleRate, targetSampleRate, numPartitions);
+
+        if (!queued)
+            return queueRunner(std::make_unique<Runner>(prepared, numChannels), request, true);
+
+        return true;
+    }
+
+    void finishProgressiveJob(int request, bool installed)
+    {
+        std::shared_ptr<const ImpulseResponse> final;
+
+        {
+            const juce::ScopedLock lock(loadLock);
+            if (request != progressiveRequest)
+                return;
+
+            progressiveState = installed ? ProgressiveState::succeeded : ProgressiveState::failed;
+            progressiveBuffer.reset();
+            final = std::move(finalImpulseResponse);
+
+            // L'IR complète est déjà arrivée : le chargement progressif est terminé
+            if (final != nullptr)
+                progressiveState = ProgressiveState::none;
+
+            if (installed && final != nullptr)
+            {
+                // Déjà installée partition par partition : seulement la conserver
+                source = final;
+                return;
+            }
+        }
+
+        // Échec du décodage progressif : l'IR complète, si elle est déjà là, est installée normalement
+        if (final != nullptr)
+            install(std::move(final), request);
+    }
+
+    // Thread de chargement, démarré au premier usage : une instance construite pour un scan
+    // de plugins n'en crée pas
+    juce::ThreadPool& getLoader()
+    {
+        std::call_once(loaderCreated, [this] { loader = std::make_unique<juce::ThreadPool>(1); });
+        return *loader;
+    }
+
+    //==============================================================================
+    // Configuration et chargements, protégés par loadLock (jamais pris par le thread audio)
+    juce::CriticalSection loadLock;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    int numChannels = maxChannels;
+    SpectrumPrecision tailPrecision = SpectrumPrecision::float32;
+    int latestRequest = 0;
+    std::shared_ptr<const ImpulseResponse> source;
+
+    std::shared_ptr<ProgressiveBuffer> progressiveBuffer;
+    int progressiveRequest = -1;
+    ProgressiveState progressiveState = ProgressiveState::none;
+    std::shared_ptr<const ImpulseResponse> finalImpulseResponse;
+
+    // Échange avec le thread audio
+    juce::SpinLock swapLock;
+    std::unique_ptr<Runner> pending;
+    bool pendingFades = true;
+    std::unique_ptr<Runner> retired;   // chaîne par Runner::nextRetired
+    bool muteRequested = false;
+
+    // État du thread audio
+    std::unique_ptr<Runner> current;
+    std::unique_ptr<Runner> previous;
+    bool fading = false;
+    bool fadeFromSilence = false;
+    bool muted = false;
+    int fadePosition = 0;
+    int fadeLength = 1;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<float> fadeBuffer;
+
+    juce::SharedResourcePointer<TraceLog> trace;   // journal des étapes, partagé par le processus
+    std::unique_ptr<juce::ThreadPool> loader;   // créé au premier chargement
+    std::once_flag loaderCreated;
+    RetiredRunnerRelease retiredRelease { *this };   // arrêté en premier à la destruction
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolution)
+};
@@ -5,6 +5,8 @@
 GenIRAudioProcessorEditor::GenIRAudioProcessorEditor(GenIRAudioProcessor& p)
     : AudioProcessorEditor(&p),
     audioProcessor(p),
+    irDisplay(p),
+    nextRandomSeed(juce::Random::getSystemRandom().nextInt(1000000)),
     progress(0.0),
     progressBar(progress),
     keywordsTabs(juce::TabbedButtonBar::TabsAtTop),
@@ -28,8 +30,8 @@ GenIRAudioProcessorEditor::GenIRAudioProcessorEditor(GenIRAudioProcessor& p)
     // Set initial visibility
     switchToPanel(0);
 
-    // Configure timer
-    startTimer(100);
+    // Status updates are pushed by the processor; show the current state once
+    audioProcessor.getStatusChannel().addChangeListener(this);
 
     // Check if an IR is already loaded
     juce::String currentIR = audioProcessor.getCurrentIRFileName();
@@ -37,6 +39,8 @@ GenIRAudioProcessorEditor::GenIRAudioProcessorEditor(GenIRAudioProcessor& p)
     {
         currentIRLabel.setText(currentIR, juce::dontSendNotification);
     }
+
+    updateGenerationStatus();
 }
 
 void GenIRAudioProcessorEditor::setupNavigationButtons()
@@ -148,6 +152,40 @@ void GenIRAudioProcessorEditor::setupMainControls()
     irCombo.addListener(this);
     mainControlsPanel.addAndMakeVisible(irCombo);
 
+    // Storage precision of the IR tail spectra: 16-bit formats halve the IR memory
+    tailPrecisionCombo.addItem("Tail: float32", 1 + (int) SpectrumPrecision::float32);
+    tailPrecisionCombo.addItem("Tail: float16", 1 + (int) SpectrumPrecision::float16);
+    tailPrecisionCombo.addItem("Tail: bfloat16", 1 + (int) SpectrumPrecision::bfloat16);
+    tailPrecisionCombo.setTooltip("Store the IR tail (after 100 ms) in 16 bits: half the memory, the head stays in full precision");
+    tailPrecisionCombo.setSelectedId(1 + (int) audioProcessor.getTailPrecision(), juce::dontSendNotification);
+    tailPrecisionCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF444444));
+    tailPrecisionCombo.setColour(juce::ComboBox::textColourId, juce::Colours::white);
+    tailPrecisionCombo.addListener(this);
+    mainControlsPanel.addAndMakeVisible(tailPrecisionCombo);
+
+    // Size cap of the generated IR store, shared by every host on the machine.
+    // A cap set by hand in store.json that is not in the list is shown as an extra entry.
+    const juce::int64 storeSize = audioProcessor.getIRStoreMaximumSize();
+    for (int i = 0; i < (int) storeSizeChoicesMB.size(); ++i)
+        storeSizeCombo.addItem("Store: " + formatStoreSize(storeSizeChoicesMB[(size_t) i] * 1024 * 1024), i + 1);
+    storeSizeCombo.setTooltip("Disk space kept for generated IRs; the least recently used ones are deleted beyond it");
+    storeSizeCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xFF444444));
+    storeSizeCombo.setColour(juce::ComboBox::textColourId, juce::Colours::white);
+
+    const auto choice = std::find(storeSizeChoicesMB.begin(), storeSizeChoicesMB.end(), storeSize / (1024 * 1024));
+    if (choice != storeSizeChoicesMB.end() && storeSize % (1024 * 1024) == 0)
+    {
+        storeSizeCombo.setSelectedId(1 + (int) (choice - storeSizeChoicesMB.begin()), juce::dontSendNotification);
+    }
+    else
+    {
+        storeSizeCombo.addItem("Store: " + formatStoreSize(storeSize), customStoreSizeId);
+        storeSizeCombo.setSelectedId(customStoreSizeId, juce::dontSendNotification);
+    }
+
+    storeSizeCombo.addListener(this);
+    mainControlsPanel.addAndMakeVisible(storeSizeCombo);
+
     // Add IR loading button
     loadIRButton.setButtonText("Browse for IR...");
     loadIRButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF444444));
@@ -155,11 +193,36 @@ void GenIRAudioProcessorEditor::setupMainControls()
     loadIRButton.addListener(this);
     mainControlsPanel.addAndMakeVisible(loadIRButton);
 
+    // Library IRs that sound like the current one (reverb times, clarity, decay shape)
+    findSimilarButton.setButtonText("Find Similar");
+    findSimilarButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF444444));
+    findSimilarButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    findSimilarButton.addListener(this);
+    mainControlsPanel.addAndMakeVisible(findSimilarButton);
+
+    // Export of the loaded IR (including .genir containers) as a 32-bit float WAV
+    exportWavButton.setButtonText("Export WAV...");
+    exportWavButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF444444));
+    exportWavButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    exportWavButton.addListener(this);
+    mainControlsPanel.addAndMakeVisible(exportWavButton);
+
+    // Save the IR itself in the project, so it opens on machines without the file
+    embedIRToggle.setButtonText("Embed in project");
+    embedIRToggle.setTooltip("Store the IR (losslessly compressed) in the plugin state; instances sharing an IR store it once");
+    embedIRToggle.setToggleState(audioProcessor.isEmbedIRInStateEnabled(), juce::dontSendNotification);
+    embedIRToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    embedIRToggle.addListener(this);
+    mainControlsPanel.addAndMakeVisible(embedIRToggle);
+
     // Current IR display label
     currentIRLabel.setText("No custom IR loaded", juce::dontSendNotification);
     currentIRLabel.setJustificationType(juce::Justification::left);
     currentIRLabel.setColour(juce::Label::textColourId, juce::Colours::white);
     mainControlsPanel.addAndMakeVisible(currentIRLabel);
+
+    // Waveform and spectrogram of the loaded IR
+    mainControlsPanel.addAndMakeVisible(irDisplay);
 }
 
 void GenIRAudioProcessorEditor::setupIRGeneratorPanel()
@@ -182,6 +245,12 @@ void GenIRAudioProcessorEditor::setupIRGeneratorPanel()
     connectButton.addListener(this);
     irGeneratorPanel.addAndMakeVisible(connectButton);
 
+    exportTraceButton.setButtonText("Export Trace...");
+    exportTraceButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF444444));
+    exportTraceButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    exportTraceButton.addListener(this);
+    irGeneratorPanel.addAndMakeVisible(exportTraceButton);
+
     // Prompt controls
     promptLabel.setText("Description:", juce::dontSendNotification);
     promptLabel.setJustificationType(juce::Justification::right);
@@ -291,6 +360,41 @@ void GenIRAudioProcessorEditor::setupIRGeneratorPanel()
     // Disable seed control if random mode is activated
     seedTextEditor.setEnabled(!randomSeedToggle.getToggleState());
 
+    // Speculative generation toggle
+    speculativeToggle.setButtonText("Prefetch");
+    speculativeToggle.setTooltip("Start generating in the background while you edit, so Generate is faster");
+    speculativeToggle.setToggleState(audioProcessor.isSpeculativeGenerationEnabled(), juce::dontSendNotification);
+    speculativeToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    speculativeToggle.addListener(this);
+    irGeneratorPanel.addAndMakeVisible(speculativeToggle);
+
+    // Generation backend: TangoFlux servers, with or without a local procedural fallback, or local only
+    backendComboBox.addItem("TangoFlux server", 1 + (int) TangoFluxClient::BackendMode::remote);
+    backendComboBox.addItem("Server, offline draft", 1 + (int) TangoFluxClient::BackendMode::remoteWithFallback);
+    backendComboBox.addItem("Procedural (instant)", 1 + (int) TangoFluxClient::BackendMode::procedural);
+    backendComboBox.setSelectedId(1 + (int) audioProcessor.getGenerationBackend(), juce::dontSendNotification);
+    backendComboBox.addListener(this);
+    irGeneratorPanel.addAndMakeVisible(backendComboBox);
+
+    // Early reflections: generated by the model, or computed from the room geometry (image sources)
+    earlyReflectionsComboBox.addItem("Generated reflections", 1);
+    for (int order : { 2, 4, 6, 8, 12 })
+        earlyReflectionsComboBox.addItem("Image sources, order " + juce::String(order), 1 + order);
+    {
+        const auto earlyReflections = audioProcessor.getEarlyReflections();
+        earlyReflectionsComboBox.setSelectedId(earlyReflections.enabled ? 1 + earlyReflections.maxOrder : 1, juce::dontSendNotification);
+    }
+    earlyReflectionsComboBox.setTooltip("Replace the start of generated IRs with reflections computed from the room described by the prompt");
+    earlyReflectionsComboBox.addListener(this);
+    irGeneratorPanel.addAndMakeVisible(earlyReflectionsComboBox);
+
+    // Any edit of the generation parameters restarts the speculative debounce
+    promptEditor.onTextChange = [this] { requestSpeculativeGeneration(); };
+    seedTextEditor.onTextChange = [this] { requestSpeculativeGeneration(); };
+    durationSlider.onValueChange = [this] { requestSpeculativeGeneration(); };
+    stepsSlider.onValueChange = [this] { requestSpeculativeGeneration(); };
+    guidanceSlider.onValueChange = [this] { requestSpeculativeGeneration(); };
+
     // Generate button
     generateButton.setButtonText("Generate IR");
     generateButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF4CAF50));
@@ -463,9 +567,6 @@ void GenIRAudioProcessorEditor::onKeywordButtonClicked(juce::Button* button)
 
 void GenIRAudioProcessorEditor::startGeneration()
 {
-    // Disable button during generation
-    generateButton.setEnabled(false);
-
     // Generation parameters
     juce::String prompt = promptEditor.getText();
     float duration = (float)durationSlider.getValue();
@@ -473,42 +574,105 @@ void GenIRAudioProcessorEditor::startGeneration()
     float guidanceScale = (float)guidanceSlider.getValue();
 
     // Determine which seed to use
-    int seed;
+    int seed = getGenerationSeed();
     if (randomSeedToggle.getToggleState())
     {
-        // Generate random seed
-        juce::Random random;
-        seed = random.nextInt(1000000);
-
-        // Update seed display for information
+        // Update seed display for information, and draw the seed of the next generation
         seedTextEditor.setText(juce::String(seed), false);
-    }
-    else
-    {
-        // Use user-defined seed
-        seed = seedTextEditor.getText().getIntValue();
+        nextRandomSeed = juce::Random::getSystemRandom().nextInt(1000000);
     }
 
     // Start generation
     audioProcessor.generateTangoFluxIR(prompt, duration, steps, guidanceScale, seed);
 }
 
+int GenIRAudioProcessorEditor::getGenerationSeed() const
+{
+    // Random mode uses a seed drawn in advance, user-defined mode the seed field
+    if (randomSeedToggle.getToggleState())
+        return nextRandomSeed;
+
+    return seedTextEditor.getText().getIntValue();
+}
+
+void GenIRAudioProcessorEditor::showSimilarIRs()
+{
+    const auto matches = audioProcessor.findSimilarIRs(12);
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Similar IRs in the library");
+
+    if (matches.empty())
+        menu.addItem(1, "No similar IR indexed yet", false);
+
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        const auto& entry = matches[i].entry;
+        juce::String text = entry.prompt.isNotEmpty() ? entry.prompt : entry.file.getFileNameWithoutExtension();
+        text << "  (RT60 " << juce::String(entry.features.rt60, 1) << " s, C80 "
+             << juce::String(entry.features.c80, 1) << " dB)";
+        menu.addItem((int) i + 1, text);
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&findSimilarButton),
+        [this, matches](int result)
+        {
+            if (result <= 0 || result > (int) matches.size())
+                return;
+
+            const juce::File file = matches[(size_t) result - 1].entry.file;
+            audioProcessor.loadImpulseResponseFromFile(file);
+            currentIRLabel.setText(file.getFileName(), juce::dontSendNotification);
+            irCombo.setSelectedId(5, juce::dontSendNotification); // Select "Custom IR"
+        });
+}
+
+void GenIRAudioProcessorEditor::requestSpeculativeGeneration()
+{
+    // The client waits for the edits to settle before contacting the server
+    if (!speculativeToggle.getToggleState() || audioProcessor.isTangoFluxGenerating())
+        return;
+
+    audioProcessor.prefetchTangoFluxIR(promptEditor.getText(),
+        (float)durationSlider.getValue(),
+        (int)stepsSlider.getValue(),
+        (float)guidanceSlider.getValue(),
+        getGenerationSeed());
+}
+
 void GenIRAudioProcessorEditor::updateGenerationStatus()
 {
+    // One consistent snapshot; nothing to do if it hasn't changed since the last update
+    const auto status = audioProcessor.getStatusChannel().read();
+    if (status.version == lastStatusVersion)
+        return;
+
+    lastStatusVersion = status.version;
+
+    // Update IR label if needed
+    if (status.irName.isNotEmpty() && status.irName != currentIRLabel.getText())
+    {
+        currentIRLabel.setText(status.irName, juce::dontSendNotification);
+        irCombo.setSelectedId(5, juce::dontSendNotification); // Select "Custom IR"
+    }
+
     // Update progress bar
-    progress = audioProcessor.getTangoFluxProgress();
-    progressBar.setVisible(audioProcessor.isTangoFluxGenerating());
+    progress = status.progress;
+    progressBar.setVisible(status.generating);
 
     // Update status label
-    statusLabel.setText(audioProcessor.getTangoFluxStatus(), juce::dontSendNotification);
+    statusLabel.setText(status.message, juce::dontSendNotification);
 
-    // Enable/disable generation button
-    generateButton.setEnabled(!audioProcessor.isTangoFluxGenerating());
+    // The generation button doubles as a Cancel button while a generation is running
+    const bool generating = status.generating;
+    generateButton.setButtonText(generating ? "Cancel" : "Generate IR");
+    generateButton.setColour(juce::TextButton::buttonColourId,
+        generating ? juce::Colour(0xFFC0392B) : juce::Colour(0xFF4CAF50));
 }
 
 GenIRAudioProcessorEditor::~GenIRAudioProcessorEditor()
 {
-    stopTimer();
+    audioProcessor.getStatusChannel().removeChangeListener(this);
 }
 
 void GenIRAudioProcessorEditor::paint(juce::Graphics& g)
@@ -544,8 +708,14 @@ void GenIRAudioProcessorEditor::resized()
 
     // IR controls at top
     auto irArea = mainPanelArea.removeFromTop(60);
-    irCombo.setBounds(irArea.removeFromTop(30).removeFromLeft(200));
+    auto irTopRow = irArea.removeFromTop(30);
+    irCombo.setBounds(irTopRow.removeFromLeft(200));
+    tailPrecisionCombo.setBounds(irTopRow.removeFromRight(160));
+    storeSizeCombo.setBounds(irTopRow.removeFromRight(150).withTrimmedRight(10));
     loadIRButton.setBounds(irArea.removeFromLeft(150));
+    findSimilarButton.setBounds(irArea.removeFromLeft(110).withTrimmedLeft(10));
+    exportWavButton.setBounds(irArea.removeFromLeft(110).withTrimmedLeft(10));
+    embedIRToggle.setBounds(irArea.removeFromLeft(150).withTrimmedLeft(10));
     currentIRLabel.setBounds(irArea);
 
     // Layout of potentiometers in a row with spacing
@@ -580,6 +750,9 @@ void GenIRAudioProcessorEditor::resized()
     dampingSlider.setBounds(x, y + pad, knobWidth, knobHeight);
     dampingLabel.setBounds(x, y + knobHeight + pad, knobWidth, labelHeight);
 
+    // IR display below the knobs
+    irDisplay.setBounds(mainPanelArea.withTrimmedTop(pad + knobHeight + labelHeight + 15));
+
     // IR Generator Panel Layout
     auto genArea = irGeneratorPanel.getLocalBounds().reduced(10);
 
@@ -588,6 +761,7 @@ void GenIRAudioProcessorEditor::resized()
     serverLabel.setBounds(serverArea.removeFromLeft(100));
     serverUrlEdit.setBounds(serverArea.removeFromLeft(250));
     connectButton.setBounds(serverArea.removeFromLeft(100));
+    exportTraceButton.setBounds(serverArea.removeFromRight(110));
 
     genArea.removeFromTop(10);
 
@@ -628,6 +802,8 @@ void GenIRAudioProcessorEditor::resized()
     // Seed
     auto seedArea = genArea.removeFromTop(30);
     seedLabel.setBounds(seedArea.removeFromLeft(100));
+    speculativeToggle.setBounds(seedArea.removeFromRight(100));
+    backendComboBox.setBounds(seedArea.removeFromRight(170).reduced(5, 2));
     randomSeedToggle.setBounds(seedArea.removeFromRight(150));
     seedTextEditor.setBounds(seedArea);
 
@@ -672,6 +848,8 @@ void GenIRAudioProcessorEditor::resized()
 
     bottomArea.removeFromBottom(15);
 
+    earlyReflectionsComboBox.setBounds(bottomArea.removeFromLeft(200).withSizeKeepingCentre(200, 28));
+
     // Bouton Generate - agrandi et mieux positionné
     generateButton.setBounds(bottomArea.reduced(40, 0));
     generateButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF4CAF50));
@@ -695,6 +873,28 @@ void GenIRAudioProcessorEditor::comboBoxChanged(juce::ComboBox* comboBoxThatHasC
     {
         // Do nothing here, handled by apply button
     }
+    else if (comboBoxThatHasChanged == &tailPrecisionCombo)
+    {
+        audioProcessor.setTailPrecision((SpectrumPrecision) (tailPrecisionCombo.getSelectedId() - 1));
+    }
+    else if (comboBoxThatHasChanged == &storeSizeCombo)
+    {
+        const int index = storeSizeCombo.getSelectedId() - 1;
+        if (index >= 0 && index < (int) storeSizeChoicesMB.size())
+            audioProcessor.setIRStoreMaximumSize(storeSizeChoicesMB[(size_t) index] * 1024 * 1024);
+    }
+    else if (comboBoxThatHasChanged == &backendComboBox)
+    {
+        audioProcessor.setGenerationBackend((TangoFluxClient::BackendMode) (backendComboBox.getSelectedId() - 1));
+    }
+    else if (comboBoxThatHasChanged == &earlyReflectionsComboBox)
+    {
+        auto earlyReflections = audioProcessor.getEarlyReflections();
+        earlyReflections.enabled = earlyReflectionsComboBox.getSelectedId() > 1;
+        if (earlyReflections.enabled)
+            earlyReflections.maxOrder = earlyReflectionsComboBox.getSelectedId() - 1;
+        audioProcessor.setEarlyReflections(earlyReflections);
+    }
 }
 
 void GenIRAudioProcessorEditor::buttonClicked(juce::Button* button)
@@ -715,7 +915,7 @@ void GenIRAudioProcessorEditor::buttonClicked(juce::Button* button)
         fileChooser = std::make_unique<juce::FileChooser>(
             "Please select an impulse response file...",
             juce::File::getSpecialLocation(juce::File::userHomeDirectory),
-            "*.wav;*.aif;*.aiff"
+            "*.wav;*.aif;*.aiff;*.flac;*.ogg;*.genir"
         );
 
         auto folderChooserFlags =
@@ -737,6 +937,76 @@ void GenIRAudioProcessorEditor::buttonClicked(juce::Button* button)
                 }
             });
     }
+    else if (button == &findSimilarButton)
+    {
+        showSimilarIRs();
+    }
+    else if (button == &embedIRToggle)
+    {
+        audioProcessor.setEmbedIRInState(embedIRToggle.getToggleState());
+    }
+    else if (button == &exportWavButton)
+    {
+        const juce::File loaded = audioProcessor.getLoadedIRFile();
+        if (loaded == juce::File())
+        {
+            statusLabel.setText("No IR loaded", juce::dontSendNotification);
+            return;
+        }
+
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Export IR as WAV...",
+            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                .getChildFile(loaded.getFileNameWithoutExtension() + ".wav"),
+            "*.wav"
+        );
+
+        auto saveFlags =
+            juce::FileBrowserComponent::saveMode |
+            juce::FileBrowserComponent::canSelectFiles |
+            juce::FileBrowserComponent::warnAboutOverwriting;
+
+        fileChooser->launchAsync(saveFlags, [this](const juce::FileChooser& chooser)
+            {
+                auto file = chooser.getResult();
+
+                if (file == juce::File())
+                    return;
+
+                const juce::File wavFile = file.withFileExtension(".wav");
+                const bool exported = audioProcessor.exportLoadedIRAsWav(wavFile);
+                statusLabel.setText(exported ? "IR exported: " + wavFile.getFileName()
+                                             : juce::String("Error: cannot export the IR"),
+                                    juce::dontSendNotification);
+            });
+    }
+    else if (button == &exportTraceButton)
+    {
+        // Save the generation trace, to open in chrome://tracing or Perfetto
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Export generation trace...",
+            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("GenIR_trace.json"),
+            "*.json"
+        );
+
+        auto saveFlags =
+            juce::FileBrowserComponent::saveMode |
+            juce::FileBrowserComponent::canSelectFiles |
+            juce::FileBrowserComponent::warnAboutOverwriting;
+
+        fileChooser->launchAsync(saveFlags, [this](const juce::FileChooser& chooser)
+            {
+                auto file = chooser.getResult();
+
+                if (file == juce::File())
+                    return;
+
+                const bool exported = audioProcessor.exportGenerationTrace(file.withFileExtension(".json"));
+                statusLabel.setText(exported ? "Trace exported: " + file.withFileExtension(".json").getFileName()
+                                             : juce::String("Error: cannot write the trace"),
+                                    juce::dontSendNotification);
+            });
+    }
     else if (button == &connectButton)
     {
         // Handle server connection
@@ -755,12 +1025,21 @@ void GenIRAudioProcessorEditor::buttonClicked(juce::Button* button)
     }
     else if (button == &generateButton)
     {
-        startGeneration();
+        if (audioProcessor.isTangoFluxGenerating())
+            audioProcessor.cancelTangoFluxGeneration();
+        else
+            startGeneration();
     }
     else if (button == &randomSeedToggle)
     {
         // Enable/disable seed control based on checkbox state
         seedTextEditor.setEnabled(!randomSeedToggle.getToggleState());
+        requestSpeculativeGeneration();
+    }
+    else if (button == &speculativeToggle)
+    {
+        audioProcessor.setSpeculativeGenerationEnabled(speculativeToggle.getToggleState());
+        requestSpeculativeGeneration();
     }
     else if (button == &applyExampleButton)
     {
@@ -796,16 +1075,9 @@ void GenIRAudioProcessorEditor::buttonClicked(juce::Button* button)
     }
 }
 
-void GenIRAudioProcessorEditor::timerCallback()
+void GenIRAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
-    // Update IR label if needed
-    juce::String currentIR = audioProcessor.getCurrentIRFileName();
-    if (currentIR.isNotEmpty() && currentIR != currentIRLabel.getText())
-    {
-        currentIRLabel.setText(currentIR, juce::dontSendNotification);
-        irCombo.setSelectedId(5, juce::dontSendNotification); // Select "Custom IR"
-    }
-
-    // Update generation status if needed
+    // Called on the message thread after the processor published a new status
+    juce::ignoreUnused(source);
     updateGenerationStatus();
 }
\ No newline at end of file
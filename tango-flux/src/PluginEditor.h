@@ -2,6 +2,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "IRDisplay.h"
+
+#include <algorithm>
+#include <array>
 
 // Classes de panneaux personnalisés avec arrière-plan
 class ColorPanel : public juce::Component
@@ -25,7 +29,7 @@ private:
 class GenIRAudioProcessorEditor : public juce::AudioProcessorEditor,
     private juce::ComboBox::Listener,
     private juce::Button::Listener,
-    private juce::Timer
+    private juce::ChangeListener
 {
 public:
     GenIRAudioProcessorEditor(GenIRAudioProcessor&);
@@ -33,7 +37,6 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
-    void timerCallback() override;
 
 private:
     GenIRAudioProcessor& audioProcessor;
@@ -62,7 +65,23 @@ private:
     // IR selection controls
     juce::ComboBox irCombo;
     juce::TextButton loadIRButton;
+    juce::TextButton findSimilarButton;
+    juce::TextButton exportWavButton;
+    juce::ToggleButton embedIRToggle;
+    juce::ComboBox tailPrecisionCombo;
+    juce::ComboBox storeSizeCombo;
+
+    // Store size caps offered in storeSizeCombo, in MB
+    static constexpr std::array<juce::int64, 6> storeSizeChoicesMB { 256, 512, 1024, 2048, 4096, 8192 };
+    static constexpr int customStoreSizeId = 100;
+    static juce::String formatStoreSize(juce::int64 bytes)
+    {
+        return bytes >= (juce::int64) 1024 * 1024 * 1024 && bytes % ((juce::int64) 1024 * 1024 * 1024) == 0
+            ? juce::String(bytes / ((juce::int64) 1024 * 1024 * 1024)) + " GB"
+            : juce::String(bytes / (1024 * 1024)) + " MB";
+    }
     juce::Label currentIRLabel;
+    IRDisplay irDisplay;
 
     // File chooser
     std::unique_ptr<juce::FileChooser> fileChooser;
@@ -71,6 +90,7 @@ private:
     juce::Label serverLabel;
     juce::TextEditor serverUrlEdit;
     juce::TextButton connectButton;
+    juce::TextButton exportTraceButton;
 
     // Generator UI components
     juce::Label promptLabel;
@@ -84,10 +104,15 @@ private:
     juce::Label seedLabel;
     juce::TextEditor seedTextEditor;
     juce::ToggleButton randomSeedToggle;
+    int nextRandomSeed; // Drawn ahead of time so speculative generations use the seed Generate will use
+    juce::ToggleButton speculativeToggle;
+    juce::ComboBox backendComboBox;
+    juce::ComboBox earlyReflectionsComboBox;
     juce::TextButton generateButton;
     juce::ProgressBar progressBar;
     juce::Label statusLabel;
     double progress;
+    juce::uint32 lastStatusVersion = 0; // Version of the processor status shown by the controls
 
     // Examples
     juce::Label examplesLabel;
@@ -111,11 +136,15 @@ private:
     void addKeywordsToTab(juce::Component* tab, const juce::Array<juce::String>& keywords);
     void onKeywordButtonClicked(juce::Button* button);
     void startGeneration();
+    void requestSpeculativeGeneration();
+    void showSimilarIRs();
+    int getGenerationSeed() const;
     void updateGenerationStatus();
 
     // Listener methods
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
     void buttonClicked(juce::Button* button) override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
     // Structure for example properties
     struct SpaceProperties {
@@ -10,38 +10,12 @@ GenIRAudioProcessor::GenIRAudioProcessor()
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
-    ),
+    )
 #endif
-    progressValue(0.0f), // Renomme de generationProgress
-    isGenerating(false)
 {
-    // Creer le repertoire des IRs si necessaire
-    createDefaultIRDirectories();
-
-    // Initialiser le client TangoFlux
-    tangoFluxClient = std::make_unique<TangoFluxClient>();
-    tangoFluxClient->addListener(this);
-
-    // Initialiser les IRs par defaut
-    initializeDefaultIRs();
-
-    // Configurer la convolution avec l'IR par defaut
-    auto& convolution = processorChain.get<convIndex>();
-    if (lastLoadedIRFile.existsAsFile())
-    {
-        convolution.loadImpulseResponse(
-            lastLoadedIRFile,
-            juce::dsp::Convolution::Stereo::yes,
-            juce::dsp::Convolution::Trim::no,
-            0
-        );
-
-        DBG("Loaded default IR: " + lastLoadedIRFile.getFileName());
-    }
-    else
-    {
-        DBG("No default IR found.");
-    }
+    // Rien d'autre que des reglages en memoire : l'hote construit le plugin pour le scanner ou
+    // ouvrir un projet. Repertoires, index et IR au premier prepareToPlay ou a la premiere
+    // restauration d'etat ; client TangoFlux et reseau a la premiere generation.
 
     // Initialiser le dry/wet mixer
     auto& mixer = processorChain.get<mixerIndex>();
@@ -54,34 +28,115 @@ GenIRAudioProcessor::GenIRAudioProcessor()
 
 GenIRAudioProcessor::~GenIRAudioProcessor()
 {
-    tangoFluxClient->removeListener(this);
+    // Les taches de restauration encore a venir n'installent plus rien
+    ++restoreGeneration;
+
+    // Une tache en cours peut encore attendre les donnees d'une autre instance (whenAvailable) ;
+    // une fois l'attente retiree, aucun rappel n'ajoute de tache : un dernier retrait suffit
+    if (irLoadPool.isCreated())
+        irLoadPool->removeJobs(this);
+
+    if (embeddedIRs.isCreated())
+        embeddedIRs->removeInstance(this);
+
+    // Apres le retrait de l'ecouteur, aucune generation terminee n'ajoute plus de tache
+    if (tangoFluxClient != nullptr)
+        tangoFluxClient->removeListener(this);
+
+    if (irLoadPool.isCreated())
+        irLoadPool->removeJobs(this);
 }
 
 void GenIRAudioProcessor::createDefaultIRDirectories()
 {
-    // Repertoire pour les IRs par defaut (a cote du plugin)
-    juce::File pluginFile = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
-    currentIRDirectory = pluginFile.getParentDirectory().getChildFile("IRs");
+    // Une seule fois, au premier usage (prepareToPlay, restauration, chargement ou generation)
+    std::call_once(directoriesCreated, [this]
+        {
+            // Repertoire pour les IRs par defaut (a cote du plugin)
+            juce::File pluginFile = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
+            currentIRDirectory = pluginFile.getParentDirectory().getChildFile("IRs");
+
+            if (!currentIRDirectory.exists())
+                currentIRDirectory.createDirectory();
 
-    if (!currentIRDirectory.exists())
-        currentIRDirectory.createDirectory();
+            // Repertoire temporaire pour les IRs generees par TangoFlux
+            // Utilise le dossier temporaire de l'utilisateur courant
+            tempIRDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("GenIR");
 
-    // Repertoire temporaire pour les IRs generees par TangoFlux
-    // Utilise le dossier temporaire de l'utilisateur courant
-    tempIRDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("GenIR");
+            if (!tempIRDirectory.exists())
+                tempIRDirectory.createDirectory();
 
-    if (!tempIRDirectory.exists())
-        tempIRDirectory.createDirectory();
+            DBG("IR directory: " + currentIRDirectory.getFullPathName());
+            DBG("Temp IR directory: " + tempIRDirectory.getFullPathName());
 
-    DBG("IR directory: " + currentIRDirectory.getFullPathName());
-    DBG("Temp IR directory: " + tempIRDirectory.getFullPathName());
+            // Indexer les IRs en arriere-plan : ces repertoires ne sont pas parcourus ici
+            irLibrary->addRoot(currentIRDirectory, true, "*.wav;*.flac;*.ogg;*.aif;*.aiff;*.genir");
+            irLibrary->addRoot(irStore->getDirectory(), false, "*.wav;*.flac;*.ogg;*.genir");
+        });
+}
+
+void GenIRAudioProcessor::loadDefaultIRIfNeeded()
+{
+    createDefaultIRDirectories();
+
+    // Une IR a deja ete choisie, restauree ou demandee : pas d'IR par defaut
+    if (irRequested.exchange(true))
+        return;
+
+    initializeDefaultIRs();
+
+    // Decodee en arriere-plan par la convolution
+    auto& convolution = processorChain.get<convIndex>();
+    const juce::File defaultIR = getLoadedIRFile();
+    if (defaultIR.existsAsFile())
+    {
+        convolution.loadImpulseResponse(defaultIR);
+
+        DBG("Loaded default IR: " + defaultIR.getFileName());
+    }
+    else
+    {
+        DBG("No default IR found.");
+    }
 }
 
 void GenIRAudioProcessor::initializeDefaultIRs()
 {
-    // Verifier s'il y a des IRs dans le repertoire des IRs
+    // IRs predefinies d'abord (quelques tests d'existence), sinon la premiere IR du repertoire
+    // deja connue de l'index : le cout ne depend pas du nombre de fichiers
     juce::Array<juce::File> irFiles;
-    currentIRDirectory.findChildFiles(irFiles, juce::File::findFiles, false, "*.wav");
+
+    for (int id = 1; id <= 4 && irFiles.isEmpty(); ++id)
+    {
+        const juce::File predefined = currentIRDirectory.getChildFile("IR" + juce::String(id) + ".wav");
+        if (predefined.existsAsFile())
+            irFiles.add(predefined);
+    }
+
+    if (irFiles.isEmpty())
+        for (auto& entry : irLibrary->getEntriesIn(currentIRDirectory))
+            irFiles.add(entry.file);
+
+    // Index pas encore relu (il l'est sur son propre thread) ou encore vide au premier lancement :
+    // premier fichier audio parmi les maxProbedFiles premieres entrees du repertoire
+    if (irFiles.isEmpty())
+    {
+        constexpr int maxProbedFiles = 64;
+        int probed = 0;
+
+        for (const auto& entry : juce::RangedDirectoryIterator(currentIRDirectory, false, "*", juce::File::findFiles))
+        {
+            const juce::File file = entry.getFile();
+            if (file.hasFileExtension("wav;flac;ogg;aif;aiff;genir"))
+            {
+                irFiles.add(file);
+                break;
+            }
+
+            if (++probed >= maxProbedFiles)
+                break;
+        }
+    }
 
     // Si aucun fichier IR n'est trouve, utiliser un IR par defaut integre dans les ressources binaires
     if (irFiles.isEmpty())
@@ -99,8 +154,8 @@ void GenIRAudioProcessor::initializeDefaultIRs()
     else
     {
         // Utiliser le premier fichier IR trouve comme IR par defaut
-        lastLoadedIRFile = irFiles[0];
-        DBG("Using default IR: " + lastLoadedIRFile.getFileName());
+        setLoadedIRFile(irFiles[0]);
+        DBG("Using default IR: " + irFiles[0].getFileName());
     }
 }
 
@@ -118,6 +173,7 @@ GenIRAudioProcessor::createParameterLayout()
 // Chargement d'IR
 void GenIRAudioProcessor::loadImpulseResponseByID(int irID)
 {
+    createDefaultIRDirectories();
     juce::File impulseFile;
 
     switch (irID)
@@ -148,16 +204,11 @@ void GenIRAudioProcessor::loadImpulseResponseByID(int irID)
     // Recuperer la convolution de notre chaine
     auto& convolution = processorChain.get<convIndex>();
 
-    // Charger le nouvel IR
-    convolution.loadImpulseResponse(
-        impulseFile,
-        juce::dsp::Convolution::Stereo::yes,
-        juce::dsp::Convolution::Trim::no,
-        0
-    );
+    // Charger le nouvel IR (decode en arriere-plan par la convolution)
+    convolution.loadImpulseResponse(impulseFile);
 
     // Stocker le fichier pour une utilisation ulterieure
-    lastLoadedIRFile = impulseFile;
+    setLoadedIRFile(impulseFile);
 
     DBG("Loaded IR: " + impulseFile.getFileName());
 }
@@ -173,34 +224,121 @@ void GenIRAudioProcessor::loadImpulseResponseFromFile(const juce::File& file)
     // Recuperer la convolution de notre chaine
     auto& convolution = processorChain.get<convIndex>();
 
-    // Charger le nouvel IR
-    convolution.loadImpulseResponse(
-        file,
-        juce::dsp::Convolution::Stereo::yes,
-        juce::dsp::Convolution::Trim::no,
-        0
-    );
+    // Charger le nouvel IR (decode en arriere-plan par la convolution)
+    convolution.loadImpulseResponse(file);
 
     // Stocker le fichier pour une utilisation ulterieure
-    lastLoadedIRFile = file;
+    setLoadedIRFile(file);
 
     DBG("Loaded custom IR: " + file.getFileName());
 }
 
+void GenIRAudioProcessor::loadImpulseResponse(const ImpulseResponse& impulseResponse)
+{
+    if (!impulseResponse.isValid())
+        return;
+
+    // L'IR est deja decodee : la convolution n'a plus qu'a la preparer (sur ce thread)
+    auto& convolution = processorChain.get<convIndex>();
+    convolution.loadImpulseResponse(std::make_shared<const ImpulseResponse>(impulseResponse));
+
+    setLoadedIRFile(impulseResponse.source);
+
+    DBG("Loaded decoded IR: " + impulseResponse.source.getFileName());
+}
+
 juce::String GenIRAudioProcessor::getCurrentIRFileName() const
 {
-    return lastLoadedIRFile.getFileName();
+    // Lu depuis le canal d'etat : sans verrou, quel que soit le thread qui a installe l'IR
+    return statusChannel.read().irName;
+}
+
+juce::File GenIRAudioProcessor::getLoadedIRFile() const
+{
+    const juce::ScopedLock lock(loadedIRLock);
+    return lastLoadedIRFile;
+}
+
+std::shared_ptr<const ImpulseResponse> GenIRAudioProcessor::getCurrentImpulseResponse() const
+{
+    return processorChain.get<convIndex>().getImpulseResponse();
+}
+
+IROverviewCache& GenIRAudioProcessor::getIROverviewCache()
+{
+    return *irOverviews;
+}
+
+bool GenIRAudioProcessor::exportLoadedIRAsWav(const juce::File& wavFile) const
+{
+    // Un conteneur .genir est seulement projete en memoire : les echantillons sont ecrits tels quels
+    ImpulseResponse impulseResponse;
+    if (!impulseResponse.loadFromFile(getLoadedIRFile()))
+        return false;
+
+    return GenIRFile::writeWav(wavFile, impulseResponse.samples, impulseResponse.sampleRate);
+}
+
+juce::File GenIRAudioProcessor::storeSplicedIR(const ImpulseResponse& spliced, const juce::File& received)
+{
+    // Conteneur .genir ecrit a cote du fichier recu. La recette est gardee ; l'analyse de la queue
+    // seule ne vaut plus, la bibliotheque la refait. Les echantillons sont lus sans copie.
+    GenIRFile::Contents contents;
+    contents.samples.setDataToReferTo(const_cast<float**>(spliced.samples.getArrayOfReadPointers()),
+                                      spliced.samples.getNumChannels(), spliced.samples.getNumSamples());
+    contents.sampleRate = spliced.sampleRate;
+    contents.hasRecipe = spliced.hasRecipe;
+    contents.recipe = spliced.recipe;
+
+    const juce::File splicedFile = received.getSiblingFile(received.getFileNameWithoutExtension() + "_early")
+                                       .withFileExtension(GenIRFile::fileExtension)
+                                       .getNonexistentSibling();
+
+    // Ecriture impossible : au moins la queue generee est rangee
+    if (!GenIRFile::write(splicedFile, contents))
+        return irStore->add(received);
+
+    // La queue seule reste disponible dans le cache des generations
+    received.deleteFile();
+    return irStore->add(splicedFile);
+}
+
+void GenIRAudioProcessor::setLoadedIRFile(const juce::File& file)
+{
+    // Une IR chargee ici remplace celle qu'une restauration en cours preparait encore
+    ++restoreGeneration;
+    irRequested = true;
+
+    {
+        const juce::ScopedLock lock(loadedIRLock);
+        lastLoadedIRFile = file;
+        loadedIRHash = irStore->getHash(file);
+    }
+
+    statusChannel.setIRName(file.getFileName());
+
+    // Une IR du stockage n'est pas supprimee tant qu'elle est installee ici. Appele depuis
+    // plusieurs threads : l'ancien Pin est echange sous le verrou et relache apres.
+    IRStore::Pin pin = irStore->pin(file);
+    {
+        const juce::ScopedLock lock(loadedIRLock);
+        std::swap(loadedIRPin, pin);
+    }
+
+    // Contenu integre a l'etat : connu d'avance pour le stockage, calcule au prochain enregistrement sinon.
+    // Une IR choisie ici remplace celle qu'une restauration attendait encore.
+    embeddedIRs->stopWaiting(this);
+    embeddedIRs->setInstanceHash(this, irStore->getHash(file));
 }
 
 // Methodes TangoFlux
 void GenIRAudioProcessor::generateTangoFluxIR(const juce::String& prompt, float duration,
     int steps, float guidanceScale, int seed)
 {
-    if (isGenerating)
+    if (isTangoFluxGenerating())
         return; // Ne pas demarrer une nouvelle generation si une est deja en cours
 
-    isGenerating = true;
-    progressValue = 0.0f; // Renomme de generationProgress
+    statusChannel.setGenerating(true, 0.0f, "Starting generation...");
 
     // Preparer les parametres
     TangoFluxClient::GenerationParams params;
@@ -210,59 +348,325 @@ void GenIRAudioProcessor::generateTangoFluxIR(const juce::String& prompt, float
     params.guidanceScale = guidanceScale;
     params.seed = seed;
 
-    // Creer un nom de fichier unique base sur l'horodatage
+    {
+        const juce::ScopedLock lock(earlyReflectionsLock);
+        lastGenerationPrompt = prompt;
+        lastGenerationSeed = seed;
+    }
+
+    // Creer un nom de fichier unique base sur l'horodatage (range dans le stockage a la fin)
+    createDefaultIRDirectories();
     juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
     juce::File outputFile = tempIRDirectory.getChildFile("GenIR_" + timestamp + ".wav");
 
-    // Demarrer la generation
-    tangoFluxClient->generateIR(params, outputFile);
+    // Demarrer la generation (le client et le reseau demarrent a la premiere)
+    getTangoFluxClient().generateIR(params, outputFile);
 }
 
 juce::String GenIRAudioProcessor::getTangoFluxStatus() const
 {
-    return tangoFluxClient->getStatusMessage();
+    return statusChannel.read().message;
 }
 
 float GenIRAudioProcessor::getTangoFluxProgress() const
 {
-    return progressValue; // Renomme de generationProgress
+    return statusChannel.read().progress;
 }
 
 bool GenIRAudioProcessor::isTangoFluxGenerating() const
 {
-    return isGenerating;
+    return statusChannel.read().generating;
+}
+
+StatusChannel& GenIRAudioProcessor::getStatusChannel()
+{
+    return statusChannel;
+}
+
+juce::StringArray GenIRAudioProcessor::getGenerationTraceLines(int maxLines) const
+{
+    return traceLog->getRecentLines(maxLines);
+}
+
+IRLibrary& GenIRAudioProcessor::getIRLibrary()
+{
+    return *irLibrary;
+}
+
+std::vector<IRLibrary::Match> GenIRAudioProcessor::findSimilarIRs(int maxResults) const
+{
+    // Descripteurs de l'IR installee : ceux de l'index si elle y est, sinon calcules ici
+    IRLibrary::Entry current;
+    IRFeatures features;
+    juce::String hash;
+    const juce::File loadedFile = getLoadedIRFile();
+
+    if (irLibrary->findEntry(loadedFile, current))
+    {
+        features = current.features;
+        hash = current.hash;
+    }
+    else if (auto ir = processorChain.get<convIndex>().getImpulseResponse())
+    {
+        features = IRAnalysis::analyse(ir->samples, ir->sampleRate);
+    }
+    else
+    {
+        return {};
+    }
+
+    return irLibrary->findSimilar(features, maxResults, loadedFile, hash);
+}
+
+bool GenIRAudioProcessor::exportGenerationTrace(const juce::File& jsonFile) const
+{
+    // Trace pour chrome://tracing ou Perfetto, et le journal lisible a cote
+    if (!traceLog->exportChromeTrace(jsonFile))
+        return false;
+
+    return jsonFile.withFileExtension(".log")
+        .replaceWithText(traceLog->getRecentLines(TraceLog::capacity).joinIntoString("\n"));
+}
+
+void GenIRAudioProcessor::cancelTangoFluxGeneration()
+{
+    // Meme chemin que la destruction du plugin : le client interrompt le transfert en cours
+    TangoFluxClient* client = nullptr;
+    {
+        const juce::ScopedLock lock(clientLock);
+        client = tangoFluxClient.get();
+    }
+
+    if (client != nullptr)
+        client->cancelGeneration();
+
+    statusChannel.setGenerating(false, 0.0f, "Generation cancelled");
+}
+
+TangoFluxClient& GenIRAudioProcessor::getTangoFluxClient()
+{
+    const juce::ScopedLock lock(clientLock);
+
+    if (tangoFluxClient == nullptr)
+    {
+        // Service partage, demon et synthese locale demarrent ici, avec les reglages gardes jusque-la
+        tangoFluxClient = std::make_unique<TangoFluxClient>();
+        tangoFluxClient->setServerUrl(tangoFluxServerUrl);
+        tangoFluxClient->setSpeculativeMode(speculativeGeneration);
+        tangoFluxClient->setBackendMode(generationBackend);
+
+        if (preparedSampleRate > 0.0)
+            tangoFluxClient->setPreparedFormat(preparedSampleRate, preparedPartitionSize);
+
+        tangoFluxClient->addListener(this);
+    }
+
+    return *tangoFluxClient;
 }
 
 void GenIRAudioProcessor::setTangoFluxServerUrl(const juce::String& url)
 {
+    const juce::ScopedLock lock(clientLock);
     tangoFluxServerUrl = url;
-    tangoFluxClient->setServerUrl(url);
+
+    if (tangoFluxClient != nullptr)
+        tangoFluxClient->setServerUrl(url);
+}
+
+void GenIRAudioProcessor::setSpeculativeGenerationEnabled(bool enabled)
+{
+    const juce::ScopedLock lock(clientLock);
+    speculativeGeneration = enabled;
+
+    if (tangoFluxClient != nullptr)
+        tangoFluxClient->setSpeculativeMode(enabled);
+}
+
+bool GenIRAudioProcessor::isSpeculativeGenerationEnabled() const
+{
+    return speculativeGeneration;
+}
+
+void GenIRAudioProcessor::setGenerationBackend(TangoFluxClient::BackendMode mode)
+{
+    // Serveurs TangoFlux, serveurs avec brouillon procedural de repli, ou synthese locale seule
+    const juce::ScopedLock lock(clientLock);
+    generationBackend = mode;
+
+    if (tangoFluxClient != nullptr)
+        tangoFluxClient->setBackendMode(mode);
+}
+
+TangoFluxClient::BackendMode GenIRAudioProcessor::getGenerationBackend() const
+{
+    return generationBackend;
+}
+
+void GenIRAudioProcessor::setEmbedIRInState(bool shouldEmbed)
+{
+    // Une instance qui n'integre pas son IR ne peut pas porter les donnees des autres
+    embedIRInState = shouldEmbed;
+    embeddedIRs->setInstanceEmbeds(this, shouldEmbed);
+}
+
+bool GenIRAudioProcessor::isEmbedIRInStateEnabled() const
+{
+    return embedIRInState;
+}
+
+void GenIRAudioProcessor::setTailPrecision(SpectrumPrecision precision)
+{
+    // L'IR installee est preparee de nouveau par la convolution, puis echangee en fondu
+    processorChain.get<convIndex>().setTailPrecision(precision);
+}
+
+SpectrumPrecision GenIRAudioProcessor::getTailPrecision() const
+{
+    return processorChain.get<convIndex>().getTailPrecision();
+}
+
+void GenIRAudioProcessor::setIRStoreMaximumSize(juce::int64 bytes)
+{
+    // Le compactage s'y conforme aussitot ; la limite est ecrite dans l'index du stockage
+    irStore->setMaximumSize(bytes);
+}
+
+juce::int64 GenIRAudioProcessor::getIRStoreMaximumSize() const
+{
+    return irStore->getMaximumSize();
+}
+
+void GenIRAudioProcessor::setEarlyReflections(const EarlyReflectionSettings& settings)
+{
+    // Prend effet a la prochaine generation
+    const juce::ScopedLock lock(earlyReflectionsLock);
+    earlyReflections = settings;
+}
+
+EarlyReflectionSettings GenIRAudioProcessor::getEarlyReflections() const
+{
+    const juce::ScopedLock lock(earlyReflectionsLock);
+    return earlyReflections;
+}
+
+void GenIRAudioProcessor::prefetchTangoFluxIR(const juce::String& prompt, float duration,
+    int steps, float guidanceScale, int seed)
+{
+    // Generation speculative des parametres en cours d'edition (ignoree hors mode speculatif)
+    TangoFluxClient::GenerationParams params;
+    params.prompt = prompt;
+    params.duration = duration;
+    params.steps = steps;
+    params.guidanceScale = guidanceScale;
+    params.seed = seed;
+
+    if (speculativeGeneration)
+        getTangoFluxClient().prefetchIR(params);
 }
 
 // Callbacks TangoFluxClient::Listener
-void GenIRAudioProcessor::generationCompleted(const juce::File& irFile)
+void GenIRAudioProcessor::generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse)
+{
+    // Appele par le thread du service, pendant que les autres demandeurs de la generation attendent
+    // leur tour : l'IR decodee (wav, flac ou ogg) est seulement copiee. Premieres reflexions,
+    // rangement et preparation se font sur le pool de chargement.
+    juce::ignoreUnused(irFile);
+    if (!impulseResponse.isValid())
+    {
+        statusChannel.setGenerating(false, 1.0f, "IR installed");
+        return;
+    }
+
+    // Une restauration ou un chargement plus recent l'emporte sur l'IR generee
+    const int generation = ++restoreGeneration;
+    auto generated = std::make_shared<const ImpulseResponse>(impulseResponse);
+
+    // Les etapes de l'installation restent rattachees a la generation dans le journal
+    const juce::uint32 traced = TraceLog::getCurrentGeneration();
+
+    irLoadPool->addJob(this, [this, generated, generation, traced]
+        {
+            const TraceLog::ScopedGeneration scope(traced);
+            installGeneratedIR(generated, generation);
+        });
+}
+
+void GenIRAudioProcessor::installGeneratedIR(std::shared_ptr<const ImpulseResponse> generated, int generation)
 {
-    // Charger l'IR genere
-    loadImpulseResponseFromFile(irFile);
-    isGenerating = false;
-    progressValue = 1.0f; // Renomme de generationProgress
+    // Thread du pool de chargement. Si ses partitions ont deja ete installees pendant le
+    // telechargement, l'IR est seulement conservee.
+    auto& convolution = processorChain.get<convIndex>();
 
-    // Option possible: copier le fichier dans le repertoire des IRs
-    // juce::File destFile = currentIRDirectory.getChildFile(irFile.getFileName());
-    // irFile.copyFileTo(destFile);
+    EarlyReflectionSettings settings;
+    juce::String prompt;
+    int seed = -1;
+    {
+        const juce::ScopedLock lock(earlyReflectionsLock);
+        settings = earlyReflections;
+        prompt = lastGenerationPrompt;
+        seed = lastGenerationSeed;
+    }
+
+    // Fichier range dans le stockage sous l'empreinte de son contenu (un doublon n'est pas garde).
+    // Une IR remplacee entre-temps est quand meme rangee : elle reste dans la bibliotheque.
+    juce::File storedFile;
+    std::shared_ptr<const ImpulseResponse> installed = generated;
+
+    if (settings.enabled && generation == restoreGeneration.load())
+    {
+        // Premieres reflexions de la salle raccordees a la queue generee (tous les coeurs).
+        // L'IR differe de celle installee pendant le telechargement : elle la remplace.
+        statusChannel.setProgress(1.0f, "Computing early reflections...");
+
+        auto spliced = std::make_shared<ImpulseResponse>(*generated);
+        imageSourceEngine->apply(*spliced, settings, prompt);
+        spliced->mapping.reset();
+
+        // C'est l'IR raccordee qui est rangee : le projet, l'etat embarque et l'export la retrouvent
+        storedFile = storeSplicedIR(*spliced, generated->source);
+        spliced->source = storedFile;
+        installed = spliced;
+    }
+    else
+    {
+        storedFile = irStore->add(generated->source);
+    }
+
+    // Description et seed conservees dans l'index de la bibliotheque
+    irLibrary->recordGeneration(storedFile, prompt, seed);
+
+    if (generation != restoreGeneration.load())
+    {
+        statusChannel.setGenerating(false, 1.0f, "IR generated (replaced by a newer IR)");
+        return;
+    }
+
+    if (installed == generated)
+        convolution.finishProgressiveLoad(installed);
+    else
+        convolution.loadImpulseResponse(installed);
+
+    setLoadedIRFile(storedFile);
+    statusChannel.setGenerating(false, 1.0f, "IR installed");
 }
 
 void GenIRAudioProcessor::generationFailed(const juce::String& errorMessage)
 {
     // Utiliser le parametre errorMessage au lieu de l'ignorer
     DBG("Generation failed: " + errorMessage);
-    isGenerating = false;
-    progressValue = 0.0f;
+    statusChannel.setGenerating(false, 0.0f, errorMessage);
+}
+
+void GenIRAudioProcessor::generationStreamStarted(std::shared_ptr<ProgressiveBuffer> buffer)
+{
+    // Les premieres partitions de l'IR sont installees des leur arrivee, la queue suit
+    processorChain.get<convIndex>().beginProgressiveLoad(buffer);
 }
 
-void GenIRAudioProcessor::generationProgress(float progressPercentage)
+void GenIRAudioProcessor::generationProgress(float progressPercentage, const juce::String& stage)
 {
-    progressValue = progressPercentage; // Renomme de generationProgress
+    // Publie depuis le thread du client ; l'editeur est prevenu par un message de changement
+    statusChannel.setProgress(progressPercentage, stage);
 }
 
 //==============================================================================
@@ -320,6 +724,19 @@ void GenIRAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 
     processorChain.prepare(spec);
 
+    // Premier prepareToPlay sans etat restaure : IR par defaut
+    loadDefaultIRIfNeeded();
+
+    // Le demon GenIR preparera les spectres des IR generees dans cette configuration
+    {
+        const juce::ScopedLock lock(clientLock);
+        preparedSampleRate = sampleRate;
+        preparedPartitionSize = processorChain.get<convIndex>().getPartitionSize();
+
+        if (tangoFluxClient != nullptr)
+            tangoFluxClient->setPreparedFormat(preparedSampleRate, preparedPartitionSize);
+    }
+
     // Definir une frequence de coupure initiale pour le filtre passe-bas depuis l'APVTS
     auto& lpfFilter = processorChain.get<lpfIndex>();
 
@@ -439,14 +856,52 @@ void GenIRAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     // Stocker les parametres
     auto state = apvts.copyState();
 
-    // Ajouter le chemin IR personnalise si un a ete charge
-    if (lastLoadedIRFile.existsAsFile())
+    // Ajouter le chemin IR personnalise si un a ete charge (emplacement actuel s'il a ete range)
+    const juce::File loadedFile = getLoadedIRFile();
+    const juce::File irFile = loadedFile == juce::File() ? juce::File() : irStore->resolve(loadedFile);
+    if (irFile.existsAsFile())
+    {
+        state.setProperty("customIRPath", irFile.getFullPathName(), nullptr);
+    }
+
+    // IR integree : l'empreinte de son contenu, et les donnees compressees si cette instance
+    // est la premiere du processus a utiliser ce contenu (les autres y font reference)
+    state.setProperty("embedIR", embedIRInState.load(), nullptr);
+    state.removeChild(state.getChildWithName("EmbeddedIR"), nullptr);
+
+    if (embedIRInState && irFile.existsAsFile())
     {
-        state.setProperty("customIRPath", lastLoadedIRFile.getFullPathName(), nullptr);
+        const juce::String hash = embeddedIRs->getHash(irFile);
+        embeddedIRs->setInstanceHash(this, hash);
+
+        juce::ValueTree embedded("EmbeddedIR");
+        embedded.setProperty("hash", hash, nullptr);
+
+        if (embeddedIRs->isOwner(this, hash))
+        {
+            if (auto blob = embeddedIRs->getBlob(irFile, hash))
+            {
+                embedded.setProperty("extension", blob->extension, nullptr);
+                embedded.setProperty("size", blob->originalSize, nullptr);
+                embedded.setProperty("data", blob->compressed.toBase64Encoding(), nullptr);
+            }
+        }
+
+        state.appendChild(embedded, nullptr);
     }
 
     // Ajouter les parametres TangoFlux
-    state.setProperty("tangoFluxURL", tangoFluxClient->getServerUrl(), nullptr);
+    {
+        const juce::ScopedLock lock(clientLock);
+        state.setProperty("tangoFluxURL", tangoFluxServerUrl, nullptr);
+    }
+    state.setProperty("speculativeGeneration", speculativeGeneration.load(), nullptr);
+    state.setProperty("generationBackend", (int) generationBackend.load(), nullptr);
+    state.setProperty("tailPrecision", (int) getTailPrecision(), nullptr);
+
+    // Premieres reflexions calculees
+    state.removeChild(state.getChildWithName("EarlyReflections"), nullptr);
+    state.appendChild(getEarlyReflections().toValueTree(), nullptr);
 
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
@@ -461,25 +916,179 @@ void GenIRAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
         juce::ValueTree newState = juce::ValueTree::fromXml(*xml);
         apvts.replaceState(newState);
 
-        // Verifier si nous avons un chemin IR personnalise a charger
-        if (newState.hasProperty("customIRPath"))
+        // IR personnalisee : fichier local ou IR integree, sinon l'IR par defaut
+        createDefaultIRDirectories();
+        setEmbedIRInState(newState.getProperty("embedIR", false));
+        restoreImpulseResponse(newState);
+        loadDefaultIRIfNeeded();
+
+        // Restaurer les parametres TangoFlux (appliques au client quand il sera cree)
+        if (newState.hasProperty("tangoFluxURL"))
         {
-            juce::String irPath = newState.getProperty("customIRPath");
-            juce::File irFile(irPath);
+            juce::String url = newState.getProperty("tangoFluxURL");
+            setTangoFluxServerUrl(url);
+        }
+
+        setSpeculativeGenerationEnabled(newState.getProperty("speculativeGeneration", false));
+
+        const int backend = newState.getProperty("generationBackend", (int) TangoFluxClient::BackendMode::remoteWithFallback);
+        setGenerationBackend((TangoFluxClient::BackendMode) juce::jlimit(0, 2, backend));
+
+        const int precision = newState.getProperty("tailPrecision", (int) SpectrumPrecision::float32);
+        setTailPrecision((SpectrumPrecision) juce::jlimit(0, 2, precision));
+
+        setEarlyReflections(EarlyReflectionSettings::fromValueTree(newState.getChildWithName("EarlyReflections")));
+    }
+}
+
+void GenIRAudioProcessor::restoreImpulseResponse(juce::ValueTree state)
+{
+    // Sur le thread de l'hote : seulement des tests d'existence. La decompression, le decodage et
+    // la preparation se font sur le pool partage par les instances.
+    const int generation = ++restoreGeneration;
+    embeddedIRs->stopWaiting(this);
+
+    // Un ancien GenIR_<date>.wav peut avoir ete range depuis dans le stockage
+    juce::File pathFile;
+    if (state.hasProperty("customIRPath"))
+        pathFile = irStore->resolve(juce::File(state.getProperty("customIRPath").toString()));
+
+    // Detachee de l'etat des parametres : les donnees ne restent pas en memoire dans chaque instance
+    const juce::ValueTree embedded = state.getChildWithName("EmbeddedIR");
+    state.removeChild(embedded, nullptr);
+    const juce::String hash = embedded.getProperty("hash").toString();
+
+    // Une restauration precedente encore en attente a pu couper la voie wet : celle-ci la
+    // remplace, c'est donc a elle de la rouvrir si elle n'a rien a charger
+    if (hash.isEmpty() && !pathFile.existsAsFile())
+    {
+        releaseRestoreMute();
+        return;
+    }
+
+    irRequested = true;
+
+    // Meme contenu deja installe (etat restaure deux fois, projet rouvert) : rien a charger
+    {
+        const juce::ScopedLock lock(loadedIRLock);
+        if (hash.isNotEmpty() ? hash == loadedIRHash : pathFile == getLoadedIRFile())
+        {
+            releaseRestoreMute();
+            return;
+        }
+    }
+
+    // Voie wet muette jusqu'a l'IR restauree, qui arrive en fondu
+    processorChain.get<convIndex>().muteUntilLoaded();
+    mutedRestore = generation;
+
+    irLoadPool->addJob(this, [this, embedded, pathFile, hash, generation]
+        {
+            if (generation != restoreGeneration.load())
+            {
+                endRestoreMute(generation);
+                return;
+            }
+
+            // Donnees portees par cet etat : gardees compressees, pour cette instance et celles qui y font reference
+            if (embedded.hasProperty("data"))
+            {
+                auto blob = std::make_shared<EmbeddedIRRegistry::Blob>();
+                blob->hash = hash;
+                blob->extension = embedded.getProperty("extension").toString();
+                blob->originalSize = (juce::int64) embedded.getProperty("size");
+
+                if (blob->compressed.fromBase64Encoding(embedded.getProperty("data").toString()))
+                    embeddedIRs->addBlob(blob);
+            }
+
+            // Copie locale d'abord (stockage, puis le chemin enregistre) ; decompression sinon
+            juce::File irFile = hash.isNotEmpty() ? irStore->find(hash) : pathFile;
+            if (!irFile.existsAsFile() && pathFile.existsAsFile() && embeddedIRs->matchesSize(hash, pathFile))
+                irFile = pathFile;
+            if (!irFile.existsAsFile())
+                irFile = embeddedIRs->materialise(hash);
 
             if (irFile.existsAsFile())
             {
-                loadImpulseResponseFromFile(irFile);
+                installRestoredIR(irFile, hash, generation);
+                return;
             }
-        }
 
-        // Restaurer les parametres TangoFlux
-        if (newState.hasProperty("tangoFluxURL"))
+            // Donnees portees par une autre instance du projet, pas encore restauree : l'IR
+            // courante reste en attendant
+            endRestoreMute(generation);
+
+            embeddedIRs->whenAvailable(this, hash, [this, hash, generation](const juce::File& file)
+                {
+                    irLoadPool->addJob(this, [this, file, hash, generation]
+                        {
+                            installRestoredIR(file, hash, generation);
+                        });
+                });
+        });
+}
+
+void GenIRAudioProcessor::installRestoredIR(const juce::File& file, const juce::String& hash, int generation)
+{
+    // Thread du pool de chargement
+    auto& convolution = processorChain.get<convIndex>();
+
+    if (generation != restoreGeneration.load() || !file.existsAsFile())
+    {
+        endRestoreMute(generation);
+        return;
+    }
+
+    const juce::String key = hash.isNotEmpty() ? hash : embeddedIRs->getHash(file);
+
+    // Meme contenu deja installe : la coupure est seulement levee
+    {
+        const juce::ScopedLock lock(loadedIRLock);
+        if (key.isNotEmpty() && key == loadedIRHash)
         {
-            juce::String url = newState.getProperty("tangoFluxURL");
-            tangoFluxClient->setServerUrl(url);
+            endRestoreMute(generation);
+            return;
         }
     }
+
+    // Decodee une fois pour toutes les instances qui restaurent ce contenu
+    auto ir = irLoadPool->decode(file, key.isNotEmpty() ? key : file.getFullPathName());
+
+    if (generation != restoreGeneration.load() || ir == nullptr)
+    {
+        if (ir == nullptr)
+            DBG("Cannot decode restored IR: " + file.getFullPathName());
+
+        endRestoreMute(generation);
+        return;
+    }
+
+    // Preparation (FFT des partitions) sur ce thread, puis fondu depuis le silence
+    convolution.loadImpulseResponse(ir);
+    setLoadedIRFile(file);
+
+    {
+        const juce::ScopedLock lock(loadedIRLock);
+        loadedIRHash = key;
+    }
+
+    embeddedIRs->setInstanceHash(this, key);
+}
+
+void GenIRAudioProcessor::endRestoreMute(int generation)
+{
+    // Seulement si la coupure est encore la sienne : une restauration plus recente qui a coupe
+    // a son tour garde la voie wet muette jusqu'a son IR
+    int expected = generation;
+    if (mutedRestore.compare_exchange_strong(expected, 0))
+        processorChain.get<convIndex>().unmute();
+}
+
+void GenIRAudioProcessor::releaseRestoreMute()
+{
+    if (mutedRestore.exchange(0) != 0)
+        processorChain.get<convIndex>().unmute();
 }
 
 void GenIRAudioProcessor::reset()
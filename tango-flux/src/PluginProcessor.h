@@ -2,6 +2,19 @@
 
 #include <JuceHeader.h>
 #include "TangoFluxClient.h"
+#include "IRLibrary.h"
+#include "IRStore.h"
+#include "EmbeddedIRRegistry.h"
+#include "IRLoadPool.h"
+#include "IROverview.h"
+#include "ImageSourceEngine.h"
+#include "LazySharedResource.h"
+#include "PartitionedConvolution.h"
+#include "StatusChannel.h"
+#include "TraceLog.h"
+
+#include <atomic>
+#include <mutex>
 
 //==============================================================================
 class GenIRAudioProcessor : public juce::AudioProcessor,
@@ -48,7 +61,17 @@ public:
     // Methodes de gestion des IRs
     void loadImpulseResponseByID(int irID);
     void loadImpulseResponseFromFile(const juce::File& file);
+    void loadImpulseResponse(const ImpulseResponse& impulseResponse);
     juce::String getCurrentIRFileName() const;
+    juce::File getLoadedIRFile() const;
+
+    // IR installee dans la convolution (nullptr si aucune) et vues d'ensemble pour l'affichage,
+    // calculees en arriere-plan et partagees par les editeurs
+    std::shared_ptr<const ImpulseResponse> getCurrentImpulseResponse() const;
+    IROverviewCache& getIROverviewCache();
+
+    // Exporte l'IR installee (fichier audio ou conteneur .genir) en WAV 32 bits flottants
+    bool exportLoadedIRAsWav(const juce::File& wavFile) const;
 
     // Methodes specifiques a TangoFlux
     void generateTangoFluxIR(const juce::String& prompt, float duration,
@@ -56,7 +79,41 @@ public:
     juce::String getTangoFluxStatus() const;
     float getTangoFluxProgress() const;
     bool isTangoFluxGenerating() const;
+    StatusChannel& getStatusChannel();
+    void cancelTangoFluxGeneration();
     void setTangoFluxServerUrl(const juce::String& url);
+    void setSpeculativeGenerationEnabled(bool enabled);
+    bool isSpeculativeGenerationEnabled() const;
+    void setGenerationBackend(TangoFluxClient::BackendMode mode);
+    TangoFluxClient::BackendMode getGenerationBackend() const;
+
+    // Premieres reflexions calculees (sources images) appliquees aux IR generees
+    void setEarlyReflections(const EarlyReflectionSettings& settings);
+    EarlyReflectionSettings getEarlyReflections() const;
+    void prefetchTangoFluxIR(const juce::String& prompt, float duration,
+        int steps, float guidanceScale, int seed);
+
+    // Journal des etapes des generations (reseau, serveur, decodage, FFT, echange du moteur)
+    juce::StringArray getGenerationTraceLines(int maxLines = 200) const;
+    bool exportGenerationTrace(const juce::File& jsonFile) const;
+
+    // Bibliotheque indexee des IRs (repertoire des IRs et IRs generees)
+    IRLibrary& getIRLibrary();
+
+    // IRs de la bibliotheque les plus proches acoustiquement de l'IR installee
+    std::vector<IRLibrary::Match> findSimilarIRs(int maxResults = 10) const;
+
+    // IR integree (compressee) a l'etat du plugin, pour des projets portables
+    void setEmbedIRInState(bool shouldEmbed);
+    bool isEmbedIRInStateEnabled() const;
+
+    // Precision des spectres de la queue de l'IR (float32, float16 ou bfloat16), la tete restant en float32
+    void setTailPrecision(SpectrumPrecision precision);
+    SpectrumPrecision getTailPrecision() const;
+
+    // Limite de taille du stockage des IRs generees, en octets, commune a toute la machine (store.json)
+    void setIRStoreMaximumSize(juce::int64 bytes);
+    juce::int64 getIRStoreMaximumSize() const;
 
     void reset() override;
 
@@ -72,9 +129,9 @@ private:
         mixerIndex  // Index 2
     };
 
-    // Convolution + IIR filter for damping + DryWet mixer
+    // Convolution (partitioned, progressive IR install) + IIR filter for damping + DryWet mixer
     juce::dsp::ProcessorChain<
-        juce::dsp::Convolution,
+        PartitionedConvolution,
         juce::dsp::IIR::Filter<float>,
         juce::dsp::DryWetMixer<float>
     > processorChain;
@@ -83,21 +140,75 @@ private:
     juce::File lastLoadedIRFile;
     juce::File currentIRDirectory;
 
-    // TangoFlux client
+    // Etat de generation (progression, etape, IR installee) publie sans verrou pour l'editeur
+    StatusChannel statusChannel;
+
+    // Journal des etapes, partage par toutes les instances du processus
+    juce::SharedResourcePointer<TraceLog> traceLog;
+
+    // TangoFlux client, cree a la premiere generation ; ses reglages sont gardes ici jusque-la
     std::unique_ptr<TangoFluxClient> tangoFluxClient;
-    juce::File tempIRDirectory;
-    float progressValue; // Renomme de generationProgress pour eviter le conflit
-    bool isGenerating;
+    juce::CriticalSection clientLock;
     juce::String tangoFluxServerUrl = "https://86d451fde387122f93.gradio.live";
+    std::atomic<bool> speculativeGeneration { false };
+    std::atomic<TangoFluxClient::BackendMode> generationBackend { TangoFluxClient::BackendMode::remoteWithFallback };
+    double preparedSampleRate = 0.0;
+    int preparedPartitionSize = 0;
+    juce::File tempIRDirectory;
+
+    // Repertoires, index et IR par defaut : au premier prepareToPlay ou a la premiere restauration,
+    // pas dans le constructeur (scan des plugins par l'hote)
+    std::once_flag directoriesCreated;
+    std::atomic<bool> irRequested { false };
+
+    // Ressources partagees par toutes les instances du processus, creees au premier usage
+    // Index des IRs du disque
+    LazySharedResource<IRLibrary> irLibrary;
+
+    // Stockage borne des IRs generees ; l'IR installee y reste tant que cette instance existe
+    LazySharedResource<IRStore> irStore;
+    IRStore::Pin loadedIRPin;
+
+    // IRs integrees a l'etat, une copie par contenu pour toutes les instances du processus
+    LazySharedResource<EmbeddedIRRegistry> embeddedIRs;
+    std::atomic<bool> embedIRInState { false };
+
+    // Restauration d'etat asynchrone sur le pool partage ; une restauration plus recente ou un
+    // chargement explicite rend les precedentes obsoletes
+    LazySharedResource<IRLoadPool> irLoadPool;
+    std::atomic<int> restoreGeneration { 0 };
+    std::atomic<int> mutedRestore { 0 };   // restauration qui a coupe la voie wet, 0 si aucune
+    mutable juce::CriticalSection loadedIRLock;
+    juce::String loadedIRHash;   // empreinte du contenu installe, si connue
+
+    // Premieres reflexions calculees : moteur partage, reglages et description de la derniere generation
+    LazySharedResource<ImageSourceEngine> imageSourceEngine;
+    EarlyReflectionSettings earlyReflections;
+    juce::String lastGenerationPrompt;
+    int lastGenerationSeed = -1;
+    mutable juce::CriticalSection earlyReflectionsLock;
+
+    // Vues d'ensemble des IRs, creees a l'ouverture du premier editeur
+    LazySharedResource<IROverviewCache> irOverviews;
 
     // Implementation des methodes de TangoFluxClient::Listener
-    void generationCompleted(const juce::File& irFile) override;
+    void generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse) override;
     void generationFailed(const juce::String& errorMessage) override;
-    void generationProgress(float progressPercentage) override;
+    void generationProgress(float progressPercentage, const juce::String& stage) override;
+    void generationStreamStarted(std::shared_ptr<ProgressiveBuffer> buffer) override;
 
     // Methodes privees
     void initializeDefaultIRs();
     void createDefaultIRDirectories();
+    void loadDefaultIRIfNeeded();
+    TangoFluxClient& getTangoFluxClient();
+    void setLoadedIRFile(const juce::File& file);
+    juce::File storeSplicedIR(const ImpulseResponse& spliced, const juce::File& received);
+    void installGeneratedIR(std::shared_ptr<const ImpulseResponse> generated, int generation);
+    void restoreImpulseResponse(juce::ValueTree state);
+    void installRestoredIR(const juce::File& file, const juce::String& hash, int generation);
+    void endRestoreMute(int generation);
+    void releaseRestoreMute();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GenIRAudioProcessor)
 };
\ No newline at end of file
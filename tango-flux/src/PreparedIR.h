@@ -0,0 +1,331 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfFloat.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+// Spectres d'une IR découpée en partitions uniformes de blockSize échantillons, pour une
+// fréquence d'échantillonnage donnée. Des partitions peuvent être ajoutées pendant que le
+// thread audio utilise les premières : seules les numReady premières sont lues.
+//
+// Les spectres sont soit alloués en mémoire, soit lus dans un fichier projeté en mémoire
+// (écrit par le démon GenIR, ou bloc d'un conteneur .genir) : plusieurs processus partagent
+// alors les mêmes pages.
+//
+// En mémoire, la queue (les partitions après fullPrecisionSeconds) peut être stockée sur 16 bits
+// (tailPrecision) : elle occupe alors deux fois moins de mémoire et de bande passante. La tête,
+// qui porte le son direct et les premières réflexions, reste en float32.
+struct PreparedIR
+{
+    PreparedIR(int channels, int partitionSize, int maximumPartitions, double rate,
+               SpectrumPrecision precision = SpectrumPrecision::float32)
+        : numChannels(channels),
+          blockSize(partitionSize),
+          fftSize(2 * partitionSize),
+          numBins(partitionSize + 1),
+          capacity(maximumPartitions),
+          sampleRate(rate),
+          tailPrecision(precision),
+          numFullPrecision(precision == SpectrumPrecision::float32
+                               ? maximumPartitions
+                               : juce::jlimit(1, maximumPartitions, (int) std::ceil(fullPrecisionSeconds * rate / partitionSize)))
+    {
+        ownedSpectra.allocate(getNumFloats(), true);
+        spectra = ownedSpectra.getData();
+
+        const size_t numCompact = (size_t) numChannels * (size_t) (capacity - numFullPrecision);
+        if (numCompact > 0)
+        {
+            compactSpectra.allocate(numCompact * (size_t) (2 * numBins), true);
+            compactScales.allocate(numCompact, true);
+        }
+    }
+
+    // Vrai si la partition est stockée en float32 (getPartition), sinon sur 16 bits (getCompactPartition)
+    bool isFullPrecision(int index) const noexcept
+    {
+        return index < numFullPrecision;
+    }
+
+    // Spectre d'une partition : numBins parties réelles suivies de numBins parties imaginaires
+    const float* getPartition(int channel, int index) const noexcept
+    {
+        jassert(isFullPrecision(index));
+        return spectra + ((size_t) channel * (size_t) numFullPrecision + (size_t) index) * (size_t) (2 * numBins);
+    }
+
+    // Spectre 16 bits d'une partition de la queue, même disposition, à multiplier par getCompactScale()
+    const juce::uint16* getCompactPartition(int channel, int index) const noexcept
+    {
+        return compactSpectra.getData() + getCompactIndex(channel, index) * (size_t) (2 * numBins);
+    }
+
+    float getCompactScale(int channel, int index) const noexcept
+    {
+        return compactScales[getCompactIndex(channel, index)];
+    }
+
+    // Range une partition à partir de la sortie de juce::dsp::FFT::performRealOnlyForwardTransform
+    // (parties réelles et imaginaires entrelacées), avant sa publication par numReady
+    void storePartition(int channel, int index, const float* transformed) noexcept
+    {
+        jassert(mapping == nullptr);   // un fichier projeté est en lecture seule
+
+        if (isFullPrecision(index))
+        {
+            float* partition = spectra + ((size_t) channel * (size_t) numFullPrecision + (size_t) index) * (size_t) (2 * numBins);
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                partition[k] = transformed[2 * k];
+                partition[numBins + k] = transformed[2 * k + 1];
+            }
+            return;
+        }
+
+        // Valeurs ramenées dans [-1, 1] : la plage réduite du float16 est utilisée au mieux
+        float peak = 0.0f;
+        for (int k = 0; k < 2 * numBins; ++k)
+            peak = juce::jmax(peak, std::abs(transformed[k]));
+
+        const float scale = peak > 0.0f ? peak : 1.0f;
+        const size_t compactIndex = getCompactIndex(channel, index);
+        juce::uint16* partition = compactSpectra.getData() + compactIndex * (size_t) (2 * numBins);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            partition[k] = HalfFloat::fromFloat(transformed[2 * k] / scale, tailPrecision);
+            partition[numBins + k] = HalfFloat::fromFloat(transformed[2 * k + 1] / scale, tailPrecision);
+        }
+
+        compactScales[compactIndex] = scale;
+    }
+
+    // Copie d'une IR complète en float32 vers une autre précision de queue, sans refaire de FFT.
+    // Les spectres partagés (démon, conteneur .genir) restent en float32 : chaque instance qui
+    // demande une queue sur 16 bits en garde sa propre copie réduite.
+    static std::shared_ptr<PreparedIR> withTailPrecision(const PreparedIR& source, SpectrumPrecision precision)
+    {
+        jassert(source.complete && source.tailPrecision == SpectrumPrecision::float32);
+
+        auto converted = std::make_shared<PreparedIR>(source.numChannels, source.blockSize, source.capacity,
+                                                      source.sampleRate, precision);
+        const int numPartitions = juce::jmin(source.numReady.load(), source.capacity);
+        juce::HeapBlock<float> interleaved((size_t) (2 * source.numBins));
+
+        for (int channel = 0; channel < source.numChannels; ++channel)
+        {
+            for (int index = 0; index < numPartitions; ++index)
+            {
+                const float* partition = source.getPartition(channel, index);
+
+                for (int k = 0; k < source.numBins; ++k)
+                {
+                    interleaved[2 * k] = partition[k];
+                    interleaved[2 * k + 1] = partition[source.numBins + k];
+                }
+
+                converted->storePartition(channel, index, interleaved.getData());
+            }
+        }
+
+        converted->numReady = numPartitions;
+        converted->gain = source.gain.load();
+        converted->complete = true;
+        return converted;
+    }
+
+    // Mémoire occupée par les spectres (hors fichier projeté)
+    size_t getMemorySize() const noexcept
+    {
+        if (isMapped())
+            return 0;
+
+        const size_t numCompact = (size_t) numChannels * (size_t) (capacity - numFullPrecision);
+        return getNumFloats() * sizeof(float)
+             + numCompact * ((size_t) (2 * numBins) * sizeof(juce::uint16) + sizeof(float));
+    }
+
+    bool isMapped() const noexcept
+    {
+        return mapping != nullptr;
+    }
+
+    //==============================================================================
+    // Écrit les spectres d'une IR complète dans un fichier, de façon atomique (fichier .part renommé)
+    bool writeToFile(const juce::File& file) const
+    {
+        if (!complete || tailPrecision != SpectrumPrecision::float32)
+            return false;
+
+        const juce::File partial = file.getSiblingFile(file.getFileName() + ".part");
+        partial.deleteFile();
+
+        {
+            juce::FileOutputStream out(partial);
+            if (!out.openedOk())
+                return false;
+
+            if (!writeTo(out))
+            {
+                out.flush();
+                partial.deleteFile();
+                return false;
+            }
+
+            out.flush();
+            if (!out.getStatus().wasOk())
+            {
+                partial.deleteFile();
+                return false;
+            }
+        }
+
+        return partial.moveFileTo(file);
+    }
+
+    // En-tête et spectres, dans le format de writeToFile(). Aussi utilisé pour les blocs de
+    // spectres des conteneurs .genir (GenIRFile).
+    bool writeTo(juce::OutputStream& out) const
+    {
+        // Les fichiers ne contiennent que des spectres float32
+        if (!complete || tailPrecision != SpectrumPrecision::float32)
+            return false;
+
+        FileHeader header;
+        std::memcpy(header.magic, "GIRS", 4);
+        header.version = fileVersion;
+        header.numChannels = numChannels;
+        header.blockSize = blockSize;
+        header.capacity = capacity;
+        header.numReady = numReady.load();
+        header.gain = gain.load();
+        header.sampleRate = sampleRate;
+
+        return out.write(&header, sizeof(header)) && out.write(spectra, getNumFloats() * sizeof(float));
+    }
+
+    // Taille écrite par writeTo()
+    size_t getSerialisedSize() const noexcept
+    {
+        return sizeof(FileHeader) + getNumFloats() * sizeof(float);
+    }
+
+    // Projette en mémoire un fichier écrit par writeToFile(). nullptr s'il est absent ou invalide.
+    static std::shared_ptr<PreparedIR> mapFile(const juce::File& file)
+    {
+        auto mapped = std::make_shared<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly, false);
+
+        if (mapped->getData() == nullptr)
+            return nullptr;
+
+        const size_t size = mapped->getSize();
+        return mapRegion(std::move(mapped), 0, size);
+    }
+
+    // Spectres écrits par writeTo() à la position offset d'un fichier déjà projeté, sans copie.
+    // La projection reste ouverte tant que le PreparedIR existe. nullptr si le bloc est invalide.
+    static std::shared_ptr<PreparedIR> mapRegion(std::shared_ptr<const juce::MemoryMappedFile> mapped,
+                                                 size_t offset, size_t size)
+    {
+        if (mapped == nullptr || mapped->getData() == nullptr || offset + size > mapped->getSize()
+            || size < sizeof(FileHeader))
+            return nullptr;
+
+        const char* data = static_cast<const char*>(mapped->getData()) + offset;
+
+        FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, "GIRS", 4) != 0 || header.version != fileVersion
+            || header.numChannels < 1 || header.numChannels > 2 || header.blockSize < 1
+            || header.capacity < 1 || header.numReady < 0 || header.numReady > header.capacity
+            || header.sampleRate <= 0.0)
+            return nullptr;
+
+        std::shared_ptr<PreparedIR> prepared(new PreparedIR(header.numChannels, header.blockSize,
+                                                            header.capacity, header.sampleRate,
+                                                            std::move(mapped), data + sizeof(FileHeader)));
+
+        if (size < prepared->getSerialisedSize())
+            return nullptr;
+
+        prepared->numReady = header.numReady;
+        prepared->gain = header.gain;
+        prepared->complete = true;
+        return prepared;
+    }
+
+    const int numChannels;
+    const int blockSize;
+    const int fftSize;
+    const int numBins;
+    const int capacity;
+    const double sampleRate;
+    const SpectrumPrecision tailPrecision;
+    const int numFullPrecision;             // partitions de tête en float32 (toutes si tailPrecision est float32)
+
+    std::atomic<int> numReady { 0 };       // partitions utilisables par le thread audio
+    std::atomic<float> gain { 1.0f };      // normalisation, provisoire tant que l'IR est incomplète
+    std::atomic<bool> complete { false };
+
+private:
+    // En-tête du fichier de spectres ; 64 octets pour garder les données alignées
+    struct FileHeader
+    {
+        char magic[4] = {};
+        juce::int32 version = 0;
+        juce::int32 numChannels = 0;
+        juce::int32 blockSize = 0;
+        juce::int32 capacity = 0;
+        juce::int32 numReady = 0;
+        float gain = 1.0f;
+        juce::int32 reserved = 0;
+        double sampleRate = 0.0;
+        char padding[24] = {};
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "Spectra file header must stay 64 bytes");
+    static constexpr juce::int32 fileVersion = 1;
+
+    PreparedIR(int channels, int partitionSize, int maximumPartitions, double rate,
+               std::shared_ptr<const juce::MemoryMappedFile> mappedFile, const char* data)
+        : numChannels(channels),
+          blockSize(partitionSize),
+          fftSize(2 * partitionSize),
+          numBins(partitionSize + 1),
+          capacity(maximumPartitions),
+          sampleRate(rate),
+          tailPrecision(SpectrumPrecision::float32),
+          numFullPrecision(maximumPartitions),
+          mapping(std::move(mappedFile))
+    {
+        // Lecture seule : getPartition() non const n'est pas utilisée sur un fichier projeté
+        spectra = reinterpret_cast<float*>(const_cast<char*>(data));
+    }
+
+    static constexpr double fullPrecisionSeconds = 0.1;
+
+    size_t getNumFloats() const noexcept
+    {
+        return (size_t) numChannels * (size_t) numFullPrecision * (size_t) (2 * numBins);
+    }
+
+    size_t getCompactIndex(int channel, int index) const noexcept
+    {
+        jassert(!isFullPrecision(index));
+        return (size_t) channel * (size_t) (capacity - numFullPrecision) + (size_t) (index - numFullPrecision);
+    }
+
+    juce::HeapBlock<float> ownedSpectra;
+    juce::HeapBlock<juce::uint16> compactSpectra;   // queue sur 16 bits
+    juce::HeapBlock<float> compactScales;           // maximum de chaque partition de la queue
+    std::shared_ptr<const juce::MemoryMappedFile> mapping;   // partagée avec le conteneur .genir éventuel
+    float* spectra = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreparedIR)
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GenerationRequest.h"
+#include "ImpulseResponse.h"
+#include "ProceduralIRSynth.h"
+#include "TraceLog.h"
+
+#include <map>
+
+// Moteur de génération local : l'IR est synthétisée à partir des mots-clés de la description
+// (ProceduralIRSynth), en quelques millisecondes et sans serveur. Sert de brouillon instantané
+// et de repli quand aucun serveur TangoFlux ne répond. Partagé par toutes les instances du
+// processus (SharedResourcePointer) ; les synthèses passent une par une sur un thread dédié.
+class ProceduralBackend : public GenerationBackend
+{
+public:
+    ProceduralBackend()
+        : pool(1),
+          scratchDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+              .getChildFile("GenIR").getChildFile("Procedural"))
+    {
+    }
+
+    ~ProceduralBackend() override
+    {
+        pool.removeAllJobs(true, 5000);
+    }
+
+    void submit(GenerationSubscriber& subscriber, const GenerationRequest& request) override
+    {
+        int id = 0;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            id = ++nextId;
+            pending[&subscriber] = id;
+        }
+
+        pool.addJob(new SynthesisJob(*this, subscriber, request, id), true);
+    }
+
+    bool cancel(GenerationSubscriber& subscriber) override
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+        const juce::ScopedLock lock(stateLock);
+        return pending.erase(&subscriber) > 0;
+    }
+
+    bool isPending(GenerationSubscriber& subscriber) const override
+    {
+        const juce::ScopedLock lock(stateLock);
+        return pending.find(&subscriber) != pending.end();
+    }
+
+    // Synthèse d'une IR, sans moteur : écrit un WAV flottant dans file et retourne son contenu
+    static ImpulseResponse synthesise(const GenerationRequest& request, const juce::File& file, juce::String& summary)
+    {
+        const double sampleRate = request.preparedSampleRate > 0.0 ? request.preparedSampleRate : 44100.0;
+        const RoomModel room = RoomModel::fromPrompt(request.prompt);
+
+        ImpulseResponse impulseResponse;
+        impulseResponse.samples = ProceduralIRSynth::render(room, sampleRate, request.duration, request.seed);
+        impulseResponse.sampleRate = sampleRate;
+        impulseResponse.source = file;
+
+        summary = juce::String(room.outdoor ? "outdoor" : juce::String(juce::roundToInt(room.volume)) + " m3")
+                + ", RT60 " + juce::String((room.t60[2] + room.t60[3]) * 0.5, 2) + " s";
+
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return {};
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+            (unsigned int) impulseResponse.samples.getNumChannels(), 32, {}, 0));
+
+        if (writer == nullptr)
+            return {};
+
+        stream.release();   // appartient désormais au writer
+
+        if (!writer->writeFromAudioSampleBuffer(impulseResponse.samples, 0, impulseResponse.samples.getNumSamples()))
+            return {};
+
+        return impulseResponse;
+    }
+
+private:
+    class SynthesisJob : public juce::ThreadPoolJob
+    {
+    public:
+        SynthesisJob(ProceduralBackend& b, GenerationSubscriber& s, const GenerationRequest& r, int requestId)
+            : juce::ThreadPoolJob("GenIR procedural synthesis"),
+              backend(b), subscriber(s), request(r), id(requestId)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            // Remplacée ou annulée avant de démarrer
+            if (!backend.isCurrent(subscriber, id))
+                return jobHasFinished;
+
+            const juce::uint32 generation = backend.trace->newGeneration();
+            const TraceLog::ScopedGeneration scope(generation);
+            const juce::int64 startUs = TraceLog::nowUs();
+
+            const juce::File file = request.outputFile != juce::File()
+                ? request.outputFile.withFileExtension(".wav")
+                : backend.scratchDirectory.getChildFile("draft_" + juce::String(id) + ".wav");
+
+            juce::String summary;
+            const ImpulseResponse impulseResponse = synthesise(request, file, summary);
+
+            backend.trace->record("procedural synthesis", "generation", startUs, TraceLog::nowUs(), request.prompt);
+            backend.finish(subscriber, id, file, impulseResponse, summary);
+            return jobHasFinished;
+        }
+
+    private:
+        ProceduralBackend& backend;
+        GenerationSubscriber& subscriber;
+        const GenerationRequest request;
+        const int id;
+    };
+
+    bool isCurrent(GenerationSubscriber& subscriber, int id) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        auto it = pending.find(&subscriber);
+        return it != pending.end() && it->second == id;
+    }
+
+    void finish(GenerationSubscriber& subscriber, int id, const juce::File& file,
+                const ImpulseResponse& impulseResponse, const juce::String& summary)
+    {
+        const juce::ScopedLock callbacks(callbackLock);
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto it = pending.find(&subscriber);
+            if (it == pending.end() || it->second != id)
+                return;
+
+            pending.erase(it);
+        }
+
+        if (!impulseResponse.isValid())
+        {
+            subscriber.generationFailed("Error: cannot write procedural IR " + file.getFullPathName());
+            return;
+        }
+
+        subscriber.generationCompleted(file, impulseResponse);
+        subscriber.generationProgress(1.0f, "Procedural draft generated (" + summary + ")");
+    }
+
+    juce::ThreadPool pool;
+    const juce::File scratchDirectory;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    // Dernière demande de chaque demandeur ; une synthèse remplacée est ignorée
+    mutable juce::CriticalSection stateLock;
+    std::map<GenerationSubscriber*, int> pending;
+    int nextId = 0;
+
+    // Tenu pendant les notifications, pour que cancel() puisse garantir qu'il n'y en a plus
+    juce::CriticalSection callbackLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProceduralBackend)
+};
@@ -0,0 +1,492 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+// Synthèse procédurale d'une IR à partir des mots-clés de la description, en quelques
+// millisecondes et sans réseau : brouillon instantané, ou repli quand le serveur est injoignable.
+//
+// Les catégories de mots-clés du générateur (matériaux, espace, architecture, type de lieu,
+// propriétés acoustiques) deviennent un modèle de salle (RoomModel) :
+// - matériaux : coefficients d'absorption par bande d'octave ;
+// - type de lieu et qualificatifs d'espace : volume et proportions de la salle, d'où le
+//   temps de réverbération par bande (Sabine, ou Eyring pour une salle absorbante, plus
+//   l'absorption de l'air) ; un lieu extérieur a une queue courte et des échos discrets ;
+// - architecture : diffusion (vitesse à laquelle les réflexions se fondent dans la queue).
+// L'IR est un son direct, des premières réflexions (sources images du premier ordre puis
+// réflexions aléatoires de densité croissante), et une queue de bruit décroissant séparément
+// dans chaque bande d'octave.
+struct RoomModel
+{
+    static constexpr int numBands = 7;
+
+    static constexpr std::array<double, numBands> bandFrequencies { 125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 8000.0 };
+
+    using Bands = std::array<double, numBands>;
+
+    Bands absorption { 0.10, 0.10, 0.12, 0.14, 0.16, 0.18, 0.20 };   // moyenne des parois
+    double volume = 500.0;                                          // m³
+    double length = 11.0, width = 8.6, height = 5.3;                // m
+    double diffusion = 0.5;                                         // 0 : réflexions nettes, 1 : queue immédiatement dense
+    bool outdoor = false;
+    double reverbScale = 1.0;                                       // « dry », « reverberant »...
+    std::vector<double> echoDelays;                                 // échos discrets (s) : falaise, vallée, « echo »
+    Bands t60 {};                                                   // calculé par computeDecay()
+
+    static constexpr double speedOfSound = 343.0;
+
+    // Modèle décrit par les mots-clés de prompt ; les mots inconnus sont ignorés
+    static RoomModel fromPrompt(const juce::String& prompt)
+    {
+        RoomModel room;
+        const juce::StringArray words = tokenise(prompt);
+
+        // Matériaux : moyenne des absorptions citées
+        Bands materialSum {};
+        int materialCount = 0;
+
+        for (auto& word : words)
+        {
+            Bands bands;
+            if (findMaterial(word, bands))
+            {
+                for (int b = 0; b < numBands; ++b)
+                    materialSum[(size_t) b] += bands[(size_t) b];
+                ++materialCount;
+            }
+        }
+
+        if (materialCount > 0)
+            for (int b = 0; b < numBands; ++b)
+                room.absorption[(size_t) b] = materialSum[(size_t) b] / materialCount;
+
+        // Lieu : le plus grand volume cité l'emporte (« hall » dans « church hall » reste une église)
+        double placeVolume = 0.0, outdoorT60 = 0.0, echoDistance = 0.0;
+        double proportions[3] = { 1.6, 1.25, 1.0 };
+
+        for (auto& word : words)
+        {
+            Place place;
+            if (!findPlace(word, place))
+                continue;
+
+            if (place.outdoor)
+            {
+                room.outdoor = true;
+                outdoorT60 = juce::jmax(outdoorT60, place.outdoorT60);
+                echoDistance = juce::jmax(echoDistance, place.echoDistance);
+            }
+            else if (place.volume > placeVolume)
+            {
+                placeVolume = place.volume;
+                proportions[0] = place.lengthRatio;
+                proportions[1] = place.widthRatio;
+            }
+        }
+
+        if (placeVolume > 0.0)
+        {
+            room.volume = placeVolume;
+            room.outdoor = false;   // « cave », « tunnel »... l'emportent sur « mountain »
+        }
+
+        room.diffusion = 0.4;
+
+        for (auto& word : words)
+        {
+            // Qualificatifs d'espace
+            if (word == "small")            room.volume *= 0.3;
+            else if (word == "large")       room.volume *= 3.0;
+            else if (word == "very-large")  room.volume *= 8.0;
+            else if (word == "high")        proportions[2] *= 1.8;
+            else if (word == "very-high")   proportions[2] *= 3.0;
+            else if (word == "narrow")      { proportions[0] *= 2.0; proportions[1] *= 0.5; room.diffusion -= 0.15; }
+            else if (word == "circular")    { proportions[0] = proportions[1]; room.diffusion -= 0.1; }
+            else if (word == "complex")     room.diffusion += 0.25;
+
+            // Architecture
+            else if (word == "arch")        room.diffusion += 0.15;
+            else if (word == "steeple")     { room.diffusion += 0.1; proportions[2] *= 1.5; }
+            else if (word == "stage")       room.diffusion += 0.1;
+            else if (word == "dome")        { room.diffusion += 0.2; proportions[2] *= 1.3; }
+            else if (word == "column")      room.diffusion += 0.3;
+
+            // Propriétés acoustiques
+            else if (word == "dark")        scaleHighBands(room.absorption, 1.8);
+            else if (word == "bright")      scaleHighBands(room.absorption, 0.6);
+            else if (word == "muffled")     scaleHighBands(room.absorption, 2.5);
+            else if (word == "dry")         room.reverbScale *= 0.5;
+            else if (word == "reverberant") room.reverbScale *= 1.5;
+            else if (word == "very-reverberant") room.reverbScale *= 2.5;
+            else if (word == "echo")        room.echoDelays.push_back(0.28);
+        }
+
+        room.diffusion = juce::jlimit(0.0, 1.0, room.diffusion);
+
+        for (auto& a : room.absorption)
+            a = juce::jlimit(0.01, 0.95, a);
+
+        // Boîte de proportions données et de volume donné
+        const double unit = std::cbrt(room.volume / (proportions[0] * proportions[1] * proportions[2]));
+        room.length = proportions[0] * unit;
+        room.width = proportions[1] * unit;
+        room.height = proportions[2] * unit;
+
+        if (echoDistance > 0.0)
+        {
+            room.echoDelays.push_back(2.0 * echoDistance / speedOfSound);
+            room.echoDelays.push_back(3.1 * echoDistance / speedOfSound);
+        }
+
+        room.computeDecay(outdoorT60);
+        return room;
+    }
+
+    double getSurface() const
+    {
+        return 2.0 * (length * width + length * height + width * height);
+    }
+
+    // Temps de mélange : au-delà, le champ est diffus (approximation usuelle : √V ms)
+    double getMixingTime() const
+    {
+        return outdoor ? 0.02 : juce::jlimit(0.005, 0.15, std::sqrt(volume) * 0.001);
+    }
+
+    double getMeanAbsorption() const
+    {
+        double sum = 0.0;
+        for (auto a : absorption)
+            sum += a;
+        return sum / numBands;
+    }
+
+    // T60 par bande : Sabine tant que la salle est peu absorbante, Eyring au-delà, plus
+    // l'absorption de l'air (4mV). Un lieu extérieur garde la queue courte de son type.
+    void computeDecay(double outdoorT60)
+    {
+        static constexpr Bands airAttenuation { 0.0001, 0.0002, 0.0004, 0.0008, 0.0017, 0.0042, 0.0125 };   // m (1/m)
+
+        const double surface = getSurface();
+        const bool eyring = getMeanAbsorption() > 0.2;
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const double a = absorption[(size_t) b];
+            double t;
+
+            if (outdoor)
+            {
+                // Pas de parois : la queue vient du sol et de la végétation, plus courte dans les aigus
+                t = (outdoorT60 > 0.0 ? outdoorT60 : 0.3) * (1.0 - 0.5 * a);
+            }
+            else
+            {
+                const double absorptionArea = eyring ? -surface * std::log(1.0 - a) : surface * a;
+                t = 0.161 * volume / (absorptionArea + 4.0 * airAttenuation[(size_t) b] * volume);
+            }
+
+            t60[(size_t) b] = juce::jlimit(0.05, 15.0, t * reverbScale);
+        }
+    }
+
+private:
+    static void scaleHighBands(Bands& bands, double factor)
+    {
+        for (int b = 4; b < numBands; ++b)
+            bands[(size_t) b] *= factor;
+    }
+
+    static juce::StringArray tokenise(const juce::String& prompt)
+    {
+        juce::StringArray words;
+        words.addTokens(prompt.toLowerCase(), " \t\r\n,.;:!?()\"'", "");
+        words.removeEmptyStrings();
+
+        // Forme sans « s » final pour les pluriels (« columns », « arches »)
+        const int count = words.size();
+        for (int i = 0; i < count; ++i)
+            if (words[i].length() > 3 && words[i].endsWithChar('s'))
+                words.add(words[i].dropLastCharacters(words[i].endsWith("es") && words[i].length() > 5 ? 2 : 1));
+
+        return words;
+    }
+
+public:
+    // Coefficients d'absorption de Sabine par bande d'octave (125 Hz à 8 kHz), valeurs usuelles.
+    // Retourne false si word n'est pas un matériau connu.
+    static bool findMaterial(const juce::String& word, Bands& bands)
+    {
+        struct Material { const char* name; Bands coefficients; };
+
+        static const Material materials[] = {
+            { "wood",      { 0.15, 0.11, 0.10, 0.07, 0.06, 0.07, 0.07 } },
+            { "floor",     { 0.15, 0.11, 0.10, 0.07, 0.06, 0.07, 0.07 } },
+            { "stone",     { 0.02, 0.02, 0.03, 0.04, 0.05, 0.05, 0.06 } },
+            { "cut-stone", { 0.02, 0.02, 0.03, 0.04, 0.05, 0.05, 0.06 } },
+            { "rock",      { 0.02, 0.03, 0.03, 0.04, 0.05, 0.06, 0.07 } },
+            { "concrete",  { 0.01, 0.01, 0.02, 0.02, 0.02, 0.03, 0.04 } },
+            { "brick",     { 0.03, 0.03, 0.03, 0.04, 0.05, 0.07, 0.07 } },
+            { "marble",    { 0.01, 0.01, 0.01, 0.01, 0.02, 0.02, 0.02 } },
+            { "glass",     { 0.18, 0.06, 0.04, 0.03, 0.02, 0.02, 0.02 } },
+            { "metal",     { 0.01, 0.01, 0.01, 0.02, 0.02, 0.02, 0.03 } },
+            { "metallic",  { 0.01, 0.01, 0.01, 0.02, 0.02, 0.02, 0.03 } },
+            { "carpet",    { 0.08, 0.24, 0.57, 0.69, 0.71, 0.73, 0.73 } },
+            { "canvas",    { 0.05, 0.10, 0.20, 0.30, 0.40, 0.45, 0.45 } },
+            { "leather",   { 0.10, 0.15, 0.25, 0.30, 0.30, 0.30, 0.30 } },
+            { "grass",     { 0.11, 0.26, 0.60, 0.69, 0.92, 0.99, 0.99 } },
+            { "dirt",      { 0.15, 0.25, 0.40, 0.55, 0.60, 0.60, 0.60 } },
+            { "snow",      { 0.45, 0.75, 0.90, 0.95, 0.95, 0.95, 0.95 } },
+            { "pine",      { 0.10, 0.15, 0.25, 0.35, 0.40, 0.45, 0.50 } },
+            { "tree",      { 0.10, 0.15, 0.25, 0.35, 0.40, 0.45, 0.50 } },
+        };
+
+        for (auto& material : materials)
+        {
+            if (word == material.name)
+            {
+                bands = material.coefficients;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Place
+    {
+        double volume = 0.0;            // m³ (lieu fermé)
+        double lengthRatio = 1.6;
+        double widthRatio = 1.25;
+        bool outdoor = false;
+        double outdoorT60 = 0.0;        // s (lieu ouvert)
+        double echoDistance = 0.0;      // m, paroi lointaine qui renvoie un écho
+    };
+
+    static bool findPlace(const juce::String& word, Place& place)
+    {
+        struct Entry { const char* name; Place place; };
+
+        static const Entry places[] = {
+            // Lieux fermés : volume et proportions longueur/largeur (hauteur 1)
+            { "recording-booth", { 8.0,     1.2, 1.0 } },
+            { "compartment",     { 10.0,    1.5, 1.0 } },
+            { "hole",            { 40.0,    1.0, 1.0 } },
+            { "office",          { 60.0,    1.5, 1.2 } },
+            { "shed",            { 100.0,   1.6, 1.2 } },
+            { "work-room",       { 120.0,   1.6, 1.3 } },
+            { "studio",          { 150.0,   1.6, 1.3 } },
+            { "stairwell",       { 300.0,   1.0, 0.5 } },
+            { "passage",         { 400.0,   6.0, 0.8 } },
+            { "tower",           { 1500.0,  0.6, 0.6 } },
+            { "building",        { 2000.0,  1.6, 1.25 } },
+            { "courtroom",       { 1500.0,  1.5, 1.3 } },
+            { "court-room",      { 1500.0,  1.5, 1.3 } },
+            { "lobby",           { 1500.0,  1.8, 1.5 } },
+            { "chapel",          { 1500.0,  2.0, 1.0 } },
+            { "mausoleum",       { 2000.0,  1.2, 1.2 } },
+            { "library",         { 3000.0,  2.0, 1.5 } },
+            { "tunnel",          { 3000.0,  12.0, 1.0 } },
+            { "museum",          { 5000.0,  2.0, 1.5 } },
+            { "cave",            { 5000.0,  2.5, 1.5 } },
+            { "movie-theater",   { 6000.0,  1.6, 1.4 } },
+            { "hall",            { 8000.0,  2.0, 1.2 } },
+            { "movie-set",       { 8000.0,  1.5, 1.5 } },
+            { "church",          { 10000.0, 2.5, 1.0 } },
+            { "gymnasium",       { 12000.0, 1.6, 1.6 } },
+            { "auditorium",      { 15000.0, 1.4, 1.6 } },
+            { "tennis-court",    { 15000.0, 2.0, 1.6 } },
+            { "amphitheater",    { 20000.0, 1.2, 1.6 } },
+            { "warehouse",       { 20000.0, 2.0, 1.6 } },
+            { "factory",         { 25000.0, 2.0, 1.6 } },
+            { "nuclear-reactor", { 30000.0, 1.0, 1.0 } },
+            { "cathedral",       { 40000.0, 2.8, 1.0 } },
+
+            // Lieux ouverts : queue courte, échos des parois lointaines
+            { "outside",   { 0.0, 1.6, 1.25, true, 0.3, 0.0 } },
+            { "road",      { 0.0, 1.6, 1.25, true, 0.4, 0.0 } },
+            { "park",      { 0.0, 1.6, 1.25, true, 0.5, 0.0 } },
+            { "lake",      { 0.0, 1.6, 1.25, true, 0.6, 0.0 } },
+            { "mound",     { 0.0, 1.6, 1.25, true, 0.4, 0.0 } },
+            { "hill",      { 0.0, 1.6, 1.25, true, 0.5, 0.0 } },
+            { "courtyard", { 0.0, 1.6, 1.25, true, 0.9, 15.0 } },
+            { "forest",    { 0.0, 1.6, 1.25, true, 1.2, 0.0 } },
+            { "mountain",  { 0.0, 1.6, 1.25, true, 0.8, 250.0 } },
+            { "valley",    { 0.0, 1.6, 1.25, true, 1.0, 180.0 } },
+            { "cliff",     { 0.0, 1.6, 1.25, true, 0.6, 80.0 } },
+            { "gorge",     { 0.0, 1.6, 1.25, true, 1.4, 40.0 } },
+        };
+
+        for (auto& entry : places)
+        {
+            if (word == entry.name)
+            {
+                place = entry.place;
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+class ProceduralIRSynth
+{
+public:
+    // IR stéréo de duration secondes à sampleRate. Le même modèle et la même seed donnent la même IR.
+    static juce::AudioBuffer<float> render(const RoomModel& room, double sampleRate, float duration, int seed)
+    {
+        const int numSamples = juce::jmax(1, juce::roundToInt(duration * sampleRate));
+        juce::AudioBuffer<float> ir(2, numSamples);
+        ir.clear();
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            juce::Random random((juce::int64) seed * 2 + ch + 1);
+            float* output = ir.getWritePointer(ch);
+
+            addLateTail(room, sampleRate, random, output, numSamples);
+            addEarlyReflections(room, sampleRate, random, ch, output, numSamples);
+        }
+
+        // Son direct, au même instant sur les deux canaux
+        ir.setSample(0, 0, ir.getSample(0, 0) + 1.0f);
+        ir.setSample(1, 0, ir.getSample(1, 0) + 1.0f);
+
+        const float peak = ir.getMagnitude(0, numSamples);
+        if (peak > 0.0f)
+            ir.applyGain(0.9f / peak);
+
+        return ir;
+    }
+
+private:
+    // Bruit filtré dans chaque bande d'octave, décroissant selon le T60 de la bande, qui
+    // s'installe jusqu'au temps de mélange (plus vite si la salle est diffuse)
+    static void addLateTail(const RoomModel& room, double sampleRate, juce::Random& random,
+                            float* output, int numSamples)
+    {
+        std::vector<float> noise((size_t) numSamples);
+        for (auto& n : noise)
+            n = random.nextFloat() * 2.0f - 1.0f;
+
+        // Énergie de la queue par rapport au son direct : plus faible dans un grand volume absorbant
+        const double tailLevel = room.outdoor ? 0.08
+                                              : juce::jlimit(0.05, 0.6, 2.0 / std::sqrt(room.volume * room.getMeanAbsorption()));
+
+        const double mixingTime = room.getMixingTime();
+        const double onset = mixingTime * (1.5 - room.diffusion);
+
+        std::vector<float> band((size_t) numSamples);
+
+        for (int b = 0; b < RoomModel::numBands; ++b)
+        {
+            const double frequency = RoomModel::bandFrequencies[(size_t) b];
+            if (frequency >= sampleRate * 0.45)
+                continue;
+
+            juce::IIRFilter filter;
+            filter.setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, frequency, 1.41));
+
+            std::copy(noise.begin(), noise.end(), band.begin());
+            filter.processSamples(band.data(), numSamples);
+
+            // exp(-6.91 t / T60) : -60 dB à T60
+            const double decayPerSample = std::exp(-6.91 / (room.t60[(size_t) b] * sampleRate));
+            double envelope = tailLevel;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double t = i / sampleRate;
+                const double buildUp = t >= onset ? 1.0 : (t / onset) * (t / onset);
+                output[i] += (float) (band[(size_t) i] * envelope * buildUp);
+                envelope *= decayPerSample;
+            }
+        }
+    }
+
+    // Réflexions sur les six parois (sources images du premier ordre), puis réflexions
+    // aléatoires de densité croissante jusqu'au temps de mélange, et échos discrets
+    static void addEarlyReflections(const RoomModel& room, double sampleRate, juce::Random& random,
+                                    int channel, float* output, int numSamples)
+    {
+        const double reflectance = std::sqrt(1.0 - room.getMeanAbsorption());
+        const double c = RoomModel::speedOfSound;
+
+        // Source et auditeur dans la salle, décalés du centre ; l'auditeur a deux oreilles
+        const double ear = channel == 0 ? -0.1 : 0.1;
+        const double listener[3] = { room.length * 0.35, room.width * 0.5 + ear, 1.5 };
+        const double source[3] = { room.length * 0.65, room.width * 0.4, 1.7 };
+        const double dims[3] = { room.length, room.width, room.height };
+
+        const double directDistance = distance(source, listener);
+
+        auto addReflection = [&](double delaySeconds, double gain)
+        {
+            // Une paroi diffuse étale la réflexion sur quelques millisecondes
+            const int position = juce::roundToInt(delaySeconds * sampleRate);
+            const int spread = 1 + juce::roundToInt(room.diffusion * 0.003 * sampleRate);
+
+            for (int k = 0; k < spread; ++k)
+            {
+                const int index = position + k;
+                if (index <= 0 || index >= numSamples)
+                    break;
+
+                const double shape = spread == 1 ? 1.0 : std::exp(-4.0 * k / spread) * (random.nextFloat() * 2.0 - 1.0);
+                output[index] += (float) (gain * shape);
+            }
+        };
+
+        if (!room.outdoor)
+        {
+            // Premier ordre : image de la source par rapport à chaque paroi
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                for (int wall = 0; wall < 2; ++wall)
+                {
+                    double image[3] = { source[0], source[1], source[2] };
+                    image[axis] = wall == 0 ? -source[axis] : 2.0 * dims[axis] - source[axis];
+
+                    const double path = distance(image, listener);
+                    addReflection((path - directDistance) / c, reflectance * directDistance / path);
+                }
+            }
+
+            // Ordres supérieurs : réflexions aléatoires dont la densité croît en t², jusqu'au mélange
+            const double mixingTime = room.getMixingTime();
+            const double density = 4.0 * juce::MathConstants<double>::pi * c * c * c / room.volume;   // réflexions/s³
+            double t = 2.0 * juce::jmin(dims[0], juce::jmin(dims[1], dims[2])) / c;
+
+            while (t < mixingTime * 1.5)
+            {
+                const double rate = juce::jmax(50.0, density * t * t);
+                t += -std::log(juce::jmax(1.0e-6, (double) random.nextFloat())) / rate;
+
+                const double path = directDistance + t * c;
+                const int order = 1 + (int) (t * c / std::cbrt(room.volume));
+                const double sign = random.nextBool() ? 1.0 : -1.0;
+                addReflection(t, sign * std::pow(reflectance, order) * directDistance / path * (1.0 - 0.5 * room.diffusion));
+            }
+        }
+        else
+        {
+            // Réflexion sur le sol
+            const double groundPath = std::sqrt(directDistance * directDistance + 4.0 * listener[2] * source[2]);
+            addReflection((groundPath - directDistance) / c, 0.5 * reflectance * directDistance / groundPath);
+        }
+
+        for (size_t i = 0; i < room.echoDelays.size(); ++i)
+            addReflection(room.echoDelays[i] + (channel == 0 ? 0.0 : 0.0004), 0.35 / (double) (i + 1));
+    }
+
+    static double distance(const double* a, const double* b)
+    {
+        const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <memory>
+
+// Tampon rempli au fil d'un téléchargement et lu en même temps par un décodeur.
+// Le thread réseau ajoute les octets reçus ; les lecteurs (ProgressiveInputStream)
+// attendent que les octets demandés arrivent, ou que le transfert se termine ou soit abandonné.
+class ProgressiveBuffer
+{
+public:
+    ProgressiveBuffer() = default;
+
+    // Taille totale annoncée par le serveur (Content-Length), -1 si inconnue
+    void setTotalLength(juce::int64 length)
+    {
+        totalLength = length;
+    }
+
+    juce::int64 getTotalLength() const noexcept
+    {
+        return totalLength.load();
+    }
+
+    void append(const void* bytes, size_t numBytes)
+    {
+        {
+            const juce::ScopedLock lock(dataLock);
+            data.append(bytes, numBytes);
+        }
+
+        dataArrived.signal();
+    }
+
+    // Le transfert est complet : les lecteurs voient la fin du flux
+    void finish()
+    {
+        finished = true;
+        dataArrived.signal();
+    }
+
+    // Le transfert a échoué, a été annulé ou redémarré : le contenu reçu n'est plus fiable
+    void abort()
+    {
+        aborted = true;
+        dataArrived.signal();
+    }
+
+    bool isFinished() const noexcept  { return finished.load(); }
+    bool isAborted() const noexcept   { return aborted.load(); }
+
+    juce::int64 getNumBytesReceived() const
+    {
+        const juce::ScopedLock lock(dataLock);
+        return (juce::int64) data.getSize();
+    }
+
+    // Copie jusqu'à numBytes à partir de position, en attendant qu'ils soient reçus.
+    // Retourne le nombre d'octets copiés (moins que demandé seulement en fin de flux ou après abort()).
+    int read(juce::int64 position, void* destination, int numBytes)
+    {
+        for (;;)
+        {
+            const bool ended = finished || aborted;
+
+            {
+                const juce::ScopedLock lock(dataLock);
+                const juce::int64 available = (juce::int64) data.getSize() - position;
+
+                if (aborted)
+                    return 0;
+
+                if (available >= numBytes || (ended && available >= 0))
+                {
+                    const int count = (int) juce::jlimit((juce::int64) 0, (juce::int64) numBytes, available);
+                    data.copyTo(destination, (int) position, (size_t) count);
+                    return count;
+                }
+
+                if (ended)
+                    return 0;
+            }
+
+            dataArrived.wait(100);
+        }
+    }
+
+private:
+    juce::MemoryBlock data;
+    juce::CriticalSection dataLock;
+    juce::WaitableEvent dataArrived;
+
+    std::atomic<juce::int64> totalLength { -1 };
+    std::atomic<bool> finished { false };
+    std::atomic<bool> aborted { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProgressiveBuffer)
+};
+
+// Flux d'entrée JUCE sur un ProgressiveBuffer : les lecteurs audio (WAV, FLAC...) peuvent
+// décoder le début du fichier pendant que la suite est encore en cours de téléchargement.
+// Les lectures bloquent jusqu'à l'arrivée des octets demandés.
+class ProgressiveInputStream : public juce::InputStream
+{
+public:
+    explicit ProgressiveInputStream(std::shared_ptr<ProgressiveBuffer> source)
+        : buffer(std::move(source))
+    {
+    }
+
+    juce::int64 getTotalLength() override
+    {
+        return buffer->getTotalLength();
+    }
+
+    bool isExhausted() override
+    {
+        const juce::int64 total = buffer->getTotalLength();
+        if (total >= 0 && position >= total)
+            return true;
+
+        return buffer->isAborted()
+            || (buffer->isFinished() && position >= buffer->getNumBytesReceived());
+    }
+
+    int read(void* destination, int maxBytesToRead) override
+    {
+        const int count = buffer->read(position, destination, maxBytesToRead);
+        position += count;
+        return count;
+    }
+
+    juce::int64 getPosition() override
+    {
+        return position;
+    }
+
+    bool setPosition(juce::int64 newPosition) override
+    {
+        // Un déplacement au-delà des octets reçus est permis : la lecture suivante attendra
+        position = juce::jmax((juce::int64) 0, newPosition);
+        return true;
+    }
+
+private:
+    std::shared_ptr<ProgressiveBuffer> buffer;
+    juce::int64 position = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProgressiveInputStream)
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+// Cause d'échec d'une étape de génération, remontée jusqu'à l'interface
+enum class FailureCause
+{
+    network,      // connexion impossible ou interrompue
+    timeout,      // délai de l'étape dépassé
+    httpError,    // le serveur a répondu avec un code d'erreur
+    protocol,     // réponse inattendue (JSON invalide, pas de fichier...)
+    rejectedInput, // le serveur refuse les entrées envoyées (nombre d'arguments, valeur hors choix)
+    circuitOpen,  // serveur connu comme indisponible, requête non envoyée
+    cancelled     // génération annulée
+};
+
+// Erreur d'une étape du pipeline (join, events, status, download)
+class GenerationError : public std::runtime_error
+{
+public:
+    GenerationError(const juce::String& stageName, FailureCause failureCause,
+                    const juce::String& detail, int status = 0)
+        : std::runtime_error((stageName + ": " + describe(failureCause)
+                              + (detail.isNotEmpty() ? " (" + detail + ")" : juce::String())).toStdString()),
+          stage(stageName), cause(failureCause), httpStatus(status)
+    {
+    }
+
+    const juce::String& getStage() const noexcept { return stage; }
+    FailureCause getCause() const noexcept { return cause; }
+    int getHttpStatus() const noexcept { return httpStatus; }
+
+    // Les erreurs transitoires peuvent être retentées sur une étape idempotente
+    bool isRetryable() const noexcept
+    {
+        switch (cause)
+        {
+            case FailureCause::network:
+            case FailureCause::timeout:
+                return true;
+            case FailureCause::httpError:
+                return httpStatus == 429 || httpStatus >= 500;
+            default:
+                return false;
+        }
+    }
+
+    // Indique si l'échec doit compter comme une panne du serveur
+    bool indicatesServerDown() const noexcept
+    {
+        return cause == FailureCause::network
+            || cause == FailureCause::timeout
+            || (cause == FailureCause::httpError && httpStatus >= 500);
+    }
+
+    static juce::String describe(FailureCause c)
+    {
+        switch (c)
+        {
+            case FailureCause::network:     return "network error";
+            case FailureCause::timeout:     return "timed out";
+            case FailureCause::httpError:   return "server error";
+            case FailureCause::protocol:    return "unexpected response";
+            case FailureCause::rejectedInput: return "request rejected by the server";
+            case FailureCause::circuitOpen: return "server unavailable, retry later";
+            case FailureCause::cancelled:   return "cancelled";
+        }
+        return "error";
+    }
+
+private:
+    juce::String stage;
+    FailureCause cause;
+    int httpStatus;
+};
+
+// Délais maximum de chaque étape, en millisecondes
+struct StageDeadlines
+{
+    int connectMs = 10000;       // établissement de chaque connexion
+    int joinMs = 20000;          // entrée dans la file d'attente
+    int eventStallMs = 30000;    // silence maximum du flux SSE (Gradio envoie un heartbeat toutes les 15 s)
+    int resultMs = 600000;       // attente du résultat, file d'attente comprise
+    int downloadMs = 120000;     // téléchargement du fichier audio
+};
+
+// Échéance absolue d'une étape
+class Deadline
+{
+public:
+    explicit Deadline(int durationMs)
+        : endMs(juce::Time::getMillisecondCounterHiRes() + durationMs)
+    {
+    }
+
+    double getRemainingMs() const
+    {
+        return juce::jmax(0.0, endMs - juce::Time::getMillisecondCounterHiRes());
+    }
+
+    bool hasExpired() const
+    {
+        return getRemainingMs() <= 0.0;
+    }
+
+private:
+    double endMs;
+};
+
+// Nouvelles tentatives avec délai exponentiel et gigue, pour les étapes idempotentes
+struct RetryPolicy
+{
+    int maxAttempts = 4;
+    int baseDelayMs = 500;
+    int maxDelayMs = 8000;
+
+    // Délai avant la tentative suivante (attempt commence à 1) : la moitié du délai
+    // exponentiel est fixe, l'autre moitié aléatoire pour désynchroniser les clients
+    int getDelayMs(int attempt, juce::Random& random) const
+    {
+        const double exponential = baseDelayMs * std::pow(2.0, juce::jmax(0, attempt - 1));
+        const int capped = (int) juce::jmin((double) maxDelayMs, exponential);
+        return capped / 2 + random.nextInt(capped / 2 + 1);
+    }
+};
+
+// Disjoncteur : après plusieurs pannes consécutives, les requêtes échouent immédiatement
+// pendant un temps de refroidissement, puis une seule requête d'essai est autorisée
+class CircuitBreaker
+{
+public:
+    enum class State { closed, open, halfOpen };
+
+    CircuitBreaker(int threshold = 3, int cooldownMs = 30000)
+        : failureThreshold(threshold), openDurationMs(cooldownMs)
+    {
+    }
+
+    // Retourne false si la requête doit échouer sans contacter le serveur
+    bool allowRequest()
+    {
+        juce::ScopedLock lock(stateLock);
+
+        if (state == State::open)
+        {
+            if (juce::Time::getMillisecondCounterHiRes() - openedAtMs < openDurationMs)
+                return false;
+
+            // Refroidissement écoulé : laisser passer une requête d'essai
+            state = State::halfOpen;
+            return true;
+        }
+
+        return true;
+    }
+
+    void recordSuccess()
+    {
+        juce::ScopedLock lock(stateLock);
+        consecutiveFailures = 0;
+        state = State::closed;
+    }
+
+    void recordFailure()
+    {
+        juce::ScopedLock lock(stateLock);
+        ++consecutiveFailures;
+
+        if (state == State::halfOpen || consecutiveFailures >= failureThreshold)
+        {
+            state = State::open;
+            openedAtMs = juce::Time::getMillisecondCounterHiRes();
+        }
+    }
+
+    State getState() const
+    {
+        juce::ScopedLock lock(stateLock);
+        return state;
+    }
+
+    void reset()
+    {
+        juce::ScopedLock lock(stateLock);
+        consecutiveFailures = 0;
+        state = State::closed;
+    }
+
+private:
+    const int failureThreshold;
+    const double openDurationMs;
+
+    State state = State::closed;
+    int consecutiveFailures = 0;
+    double openedAtMs = 0.0;
+    juce::CriticalSection stateLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CircuitBreaker)
+};
+
+// Jeton d'annulation d'une génération.
+// cancel() peut être appelé depuis n'importe quel thread : il interrompt le transfert HTTP
+// en cours et réveille les attentes, pour que le thread de génération sorte immédiatement.
+class CancellationToken
+{
+public:
+    CancellationToken() = default;
+
+    void cancel()
+    {
+        cancelled = true;
+        wakeUp.signal();
+
+        juce::ScopedLock lock(streamLock);
+        if (activeStream != nullptr)
+            activeStream->cancel();
+    }
+
+    bool isCancelled() const noexcept
+    {
+        return cancelled.load();
+    }
+
+    // Réarme le jeton avant une nouvelle génération
+    void reset()
+    {
+        cancelled = false;
+        wakeUp.reset();
+    }
+
+    // Lève une GenerationError si la génération a été annulée
+    void throwIfCancelled(const juce::String& stage) const
+    {
+        if (isCancelled())
+            throw GenerationError(stage, FailureCause::cancelled, {});
+    }
+
+    // Attente interruptible par cancel()
+    void sleep(const juce::String& stage, int milliseconds)
+    {
+        if (milliseconds > 0)
+            wakeUp.wait(milliseconds);
+
+        throwIfCancelled(stage);
+    }
+
+    // Flux HTTP en cours, que cancel() doit pouvoir interrompre
+    void attach(juce::WebInputStream* stream)
+    {
+        juce::ScopedLock lock(streamLock);
+        activeStream = stream;
+
+        if (cancelled && activeStream != nullptr)
+            activeStream->cancel();
+    }
+
+    void detach(juce::WebInputStream* stream)
+    {
+        juce::ScopedLock lock(streamLock);
+        if (activeStream == stream)
+            activeStream = nullptr;
+    }
+
+private:
+    std::atomic<bool> cancelled { false };
+    juce::WaitableEvent wakeUp { true };
+
+    juce::CriticalSection streamLock;
+    juce::WebInputStream* activeStream = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CancellationToken)
+};
+
+// Flux HTTP rattaché à un jeton d'annulation pendant toute sa durée de vie
+class CancellableStream
+{
+public:
+    CancellableStream(std::unique_ptr<juce::WebInputStream> webStream, CancellationToken* cancellationToken)
+        : stream(std::move(webStream)), token(cancellationToken)
+    {
+        if (token != nullptr)
+            token->attach(stream.get());
+    }
+
+    ~CancellableStream()
+    {
+        if (token != nullptr)
+            token->detach(stream.get());
+    }
+
+    juce::WebInputStream& operator*() const noexcept { return *stream; }
+    juce::WebInputStream* operator->() const noexcept { return stream.get(); }
+
+private:
+    std::unique_ptr<juce::WebInputStream> stream;
+    CancellationToken* token;
+
+    JUCE_DECLARE_NON_COPYABLE(CancellableStream)
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRAnalysis.h"
+
+#include <algorithm>
+#include <vector>
+
+// Recherche des k IRs les plus proches d'une autre par leurs descripteurs acoustiques.
+//
+// Les vecteurs (IRFeatures::toVector) sont rangés bout à bout dans une seule table et
+// centrés-réduits dimension par dimension, pour qu'aucun descripteur n'écrase les autres par
+// son unité. Avec une vingtaine de dimensions, un arbre (k-d, VP) ne fait pas mieux qu'un
+// parcours linéaire de la table : quelques dizaines de milliers d'IRs se comparent en
+// quelques millisecondes.
+class SimilarityIndex
+{
+public:
+    static constexpr int dimensions = IRFeatures::vectorSize;
+
+    struct Match
+    {
+        int item = -1;              // position dans la liste passée à build()
+        float distance = 0.0f;
+    };
+
+    // Reconstruit l'index à partir des descripteurs de chaque élément
+    void build(const std::vector<IRFeatures>& items)
+    {
+        numItems = (int) items.size();
+        table.assign((size_t) numItems * dimensions, 0.0f);
+
+        for (int i = 0; i < numItems; ++i)
+        {
+            const auto vector = items[(size_t) i].toVector();
+            std::copy(vector.begin(), vector.end(), table.begin() + (std::ptrdiff_t) ((size_t) i * dimensions));
+        }
+
+        // Moyenne et écart-type par dimension
+        mean.assign(dimensions, 0.0f);
+        scale.assign(dimensions, 1.0f);
+
+        if (numItems == 0)
+            return;
+
+        for (int d = 0; d < dimensions; ++d)
+        {
+            double sum = 0.0, sumSquares = 0.0;
+
+            for (int i = 0; i < numItems; ++i)
+            {
+                const double v = table[(size_t) i * dimensions + (size_t) d];
+                sum += v;
+                sumSquares += v * v;
+            }
+
+            const double m = sum / numItems;
+            const double variance = juce::jmax(0.0, sumSquares / numItems - m * m);
+
+            mean[(size_t) d] = (float) m;
+            scale[(size_t) d] = variance > 1.0e-9 ? (float) (1.0 / std::sqrt(variance)) : 1.0f;
+        }
+
+        for (int i = 0; i < numItems; ++i)
+            normalise(table.data() + (size_t) i * dimensions);
+    }
+
+    int size() const
+    {
+        return numItems;
+    }
+
+    // Les k éléments les plus proches de query, du plus proche au plus lointain.
+    // exclude(item) écarte un élément (l'IR de la requête elle-même, ses doublons).
+    template <typename ExcludePredicate>
+    std::vector<Match> findNearest(const IRFeatures& query, int k, ExcludePredicate exclude) const
+    {
+        std::vector<Match> matches;
+        if (numItems == 0 || k <= 0)
+            return matches;
+
+        auto vector = query.toVector();
+        normalise(vector.data());
+
+        matches.reserve((size_t) numItems);
+
+        for (int i = 0; i < numItems; ++i)
+        {
+            if (exclude(i))
+                continue;
+
+            const float* row = table.data() + (size_t) i * dimensions;
+            float distance = 0.0f;
+
+            for (int d = 0; d < dimensions; ++d)
+            {
+                const float delta = row[d] - vector[(size_t) d];
+                distance += delta * delta;
+            }
+
+            matches.push_back({ i, distance });
+        }
+
+        const auto count = (size_t) juce::jmin(k, (int) matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + (std::ptrdiff_t) count, matches.end(),
+                          [](const Match& a, const Match& b) { return a.distance < b.distance; });
+        matches.resize(count);
+
+        for (auto& match : matches)
+            match.distance = std::sqrt(match.distance / dimensions);
+
+        return matches;
+    }
+
+private:
+    void normalise(float* vector) const
+    {
+        for (int d = 0; d < dimensions; ++d)
+            vector[d] = (vector[d] - mean[(size_t) d]) * scale[(size_t) d];
+    }
+
+    int numItems = 0;
+    std::vector<float> table;       // numItems × dimensions, centrés-réduits
+    std::vector<float> mean, scale;
+};
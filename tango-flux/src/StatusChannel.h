@@ -0,0 +1,168 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// État de génération publié par le thread réseau (et le thread de l'interface) et lu par
+// l'éditeur sans verrou. Chaque publication incrémente une version : l'éditeur, prévenu par
+// un message de changement, ne met à jour ses composants que si la version a changé.
+//
+// Implémentation : seqlock. Les écrivains sont sérialisés entre eux ; un lecteur ne bloque
+// jamais et recommence seulement s'il a croisé une écriture. Le contenu est copié mot à mot
+// par des atomiques relâchés, ce qui évite toute course de données au sens du C++.
+class StatusChannel : public juce::ChangeBroadcaster
+{
+public:
+    struct Snapshot
+    {
+        juce::uint32 version = 0;
+        float progress = 0.0f;      // avancement réel entre 0 et 1
+        bool generating = false;
+        juce::String message;       // étape en cours ou dernier résultat
+        juce::String irName;        // nom du fichier de l'IR installée
+    };
+
+    StatusChannel()
+    {
+        store(payload);
+    }
+
+    // Lecture sans verrou, depuis n'importe quel thread
+    Snapshot read() const
+    {
+        Payload copy;
+        juce::uint32 sequence = 0;
+
+        for (;;)
+        {
+            sequence = sequenceNumber.load(std::memory_order_acquire);
+
+            if ((sequence & 1) == 0)
+            {
+                std::array<juce::uint64, numWords> words;
+                for (size_t i = 0; i < numWords; ++i)
+                    words[i] = storage[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (sequenceNumber.load(std::memory_order_relaxed) == sequence)
+                {
+                    std::memcpy(&copy, words.data(), sizeof(Payload));
+                    break;
+                }
+            }
+
+            juce::Thread::yield();
+        }
+
+        Snapshot snapshot;
+        snapshot.version = sequence / 2;
+        snapshot.progress = copy.progress;
+        snapshot.generating = copy.generating != 0;
+        snapshot.message = juce::String::fromUTF8(copy.message);
+        snapshot.irName = juce::String::fromUTF8(copy.irName);
+        return snapshot;
+    }
+
+    // Version courante, pour savoir sans copie si quelque chose a changé
+    juce::uint32 getVersion() const noexcept
+    {
+        return sequenceNumber.load(std::memory_order_acquire) / 2;
+    }
+
+    // Début ou fin d'une génération
+    void setGenerating(bool generating, float progress, const juce::String& message)
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(writeLock);
+            payload.generating = generating ? 1 : 0;
+            payload.progress = progress;
+            copyString(message, payload.message);
+            store(payload);
+        }
+
+        sendChangeMessage();
+    }
+
+    // Progression d'une génération en cours
+    void setProgress(float progress, const juce::String& message)
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(writeLock);
+
+            if (payload.progress == progress && juce::String::fromUTF8(payload.message) == message)
+                return;
+
+            payload.progress = progress;
+            copyString(message, payload.message);
+            store(payload);
+        }
+
+        sendChangeMessage();
+    }
+
+    void setIRName(const juce::String& name)
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(writeLock);
+
+            if (juce::String::fromUTF8(payload.irName) == name)
+                return;
+
+            copyString(name, payload.irName);
+            store(payload);
+        }
+
+        sendChangeMessage();
+    }
+
+private:
+    // Contenu de taille fixe, copiable mot à mot
+    struct Payload
+    {
+        float progress = 0.0f;
+        juce::uint32 generating = 0;
+        char message[184] = {};
+        char irName[120] = {};
+    };
+
+    static_assert(std::is_trivially_copyable<Payload>::value, "Payload must be copyable word by word");
+    static_assert(sizeof(Payload) % sizeof(juce::uint64) == 0, "Payload must be a whole number of words");
+
+    static constexpr size_t numWords = sizeof(Payload) / sizeof(juce::uint64);
+
+    template <size_t size>
+    static void copyString(const juce::String& text, char (&destination)[size])
+    {
+        // Tronqué sur une frontière de caractère, toujours terminé par un zéro
+        text.copyToUTF8(destination, size);
+    }
+
+    // Sous writeLock (ou dans le constructeur) ; les lecteurs voient un numéro impair pendant la copie
+    void store(const Payload& source)
+    {
+        std::array<juce::uint64, numWords> words;
+        std::memcpy(words.data(), &source, sizeof(Payload));
+
+        const juce::uint32 sequence = sequenceNumber.load(std::memory_order_relaxed);
+        sequenceNumber.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i)
+            storage[i].store(words[i], std::memory_order_relaxed);
+
+        sequenceNumber.store(sequence + 2, std::memory_order_release);
+    }
+
+    juce::SpinLock writeLock;
+    Payload payload;                                 // copie de l'écrivain, sous writeLock
+
+    std::atomic<juce::uint32> sequenceNumber { 0 };  // impair pendant une écriture
+    std::array<std::atomic<juce::uint64>, numWords> storage {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StatusChannel)
+};
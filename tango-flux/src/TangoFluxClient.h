@@ -1,38 +1,168 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-// Inclusion complète des headers Qt requis
-#include <QtCore/QEventLoop>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonArray>
-#include <QtCore/QFile>
-#include <QtCore/QUrl>
-#include <QtCore/QTimer>
-#include <QtCore/QProcess>
-#include <QtCore/QFileInfo>
-#include <QtCore/QDir>
-#include <QtCore/QStringList>
-#include <QtNetwork/QNetworkAccessManager>
-#include <QtNetwork/QNetworkReply>
-#include <QtNetwork/QNetworkRequest>
-
-// Inclure une copie fonctionnelle de votre client Qt originel (en le renommant pour éviter les conflits)
-// Cette classe est une copie exacte de tangoflux_client.h avec un préfixe QtImpl_
+#include "DaemonClient.h"
+#include "EndpointPool.h"
+#include "GenerationCache.h"
+#include "GenerationRequest.h"
+#include "GenIRFile.h"
+#include "IRAnalysis.h"
+#include "ImpulseResponse.h"
+#include "PartitionedConvolution.h"
+#include "ProceduralBackend.h"
+#include "ProgressiveStream.h"
+#include "RequestPolicy.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
 #include <random>
 #include <string>
-#include <fstream>
 #include <chrono>
-#include <thread>
 #include <iostream>
 
-// Classe TangoFluxClient Qt d'origine, renommée pour éviter les conflits
-class QtImpl_TangoFluxClient {
+// Client de l'API Gradio de TangoFlux, basé uniquement sur le réseau de JUCE (juce::URL / WebInputStream).
+// Il reprend l'interface du client Qt d'origine (QtImpl_TangoFluxClient) sans charger Qt
+// ni faire tourner de boucle d'événements secondaire dans l'hôte : chaque requête est
+// un flux bloquant lu directement depuis le thread de TangoFluxClient.
+// Chaque étape a une échéance, les étapes idempotentes sont retentées avec un délai
+// exponentiel, et un disjoncteur fait échouer immédiatement les requêtes tant que le
+// serveur est connu comme indisponible.
+class JuceImpl_TangoFluxClient {
+public:
+    // Durée de chaque étape de la dernière génération, en millisecondes
+    struct stage_timings {
+        double join_ms = 0.0;            // POST queue/join jusqu'à l'event_id
+        double first_event_ms = 0.0;     // connexion SSE jusqu'au premier événement reçu
+        double result_wait_ms = 0.0;     // attente totale du chemin du fichier (SSE ou statut)
+        double download_ms = 0.0;        // téléchargement du fichier audio
+        double total_ms = 0.0;
+        juce::int64 downloaded_bytes = 0;
+    };
+
+    // Progression réelle (0-1) et description de l'étape en cours
+    using progress_callback = std::function<void(float progress, const juce::String& stage)>;
+
+    // Début du téléchargement du fichier audio : le tampon reçoit les octets au fil du transfert
+    using stream_callback = std::function<void(std::shared_ptr<ProgressiveBuffer> buffer)>;
+
+    // Parts de la barre de progression : file d'attente, inférence, téléchargement
+    static constexpr float queued_progress = 0.02f;
+    static constexpr float inference_start = 0.05f;
+    static constexpr float download_start = 0.9f;
+
 private:
     std::string server_url;
     bool verbose;
     std::string session_hash;
+    stage_timings last_timings;
+
+    // Format demandé au serveur pour le fichier audio ("wav", "flac" ou "ogg").
+    // Un serveur qui ne connaît pas ce paramètre est détecté au premier échec,
+    // puis interrogé sans lui (WAV) jusqu'au prochain changement d'URL.
+    std::string transfer_format = "flac";
+    bool server_accepts_format = true;
+
+    StageDeadlines deadlines;
+    RetryPolicy retry_policy;
+    RetryPolicy status_poll_policy { 0, 1000, 5000 };
+    CircuitBreaker breaker;
+    juce::Random random;
+
+    // Jeton de la génération en cours (nullptr hors génération)
+    CancellationToken* cancellation = nullptr;
+
+    progress_callback on_progress;
+    stream_callback on_stream;
+
+    // Journal des étapes : entrée dans la file du serveur et début de l'inférence (µs, 0 : pas encore)
+    juce::SharedResourcePointer<TraceLog> trace;
+    juce::int64 queued_at_us = 0;
+    juce::int64 inference_start_us = 0;
+
+    // Fin de l'attente dans la file du serveur, au premier signe d'inférence
+    void mark_inference_started() {
+        if (inference_start_us == 0 && queued_at_us != 0) {
+            inference_start_us = TraceLog::nowUs();
+            trace->record("server queue", "server", queued_at_us, inference_start_us);
+        }
+    }
+
+    void report_progress(float progress, const juce::String& stage) {
+        if (on_progress) {
+            on_progress(juce::jlimit(0.0f, 1.0f, progress), stage);
+        }
+    }
+
+    // Interprète un message de file d'attente Gradio (flux SSE ou statut)
+    // et publie la position, l'ETA ou l'avancement des étapes d'inférence
+    void handle_queue_message(const juce::var& message) {
+        const juce::String msg = message["msg"].toString();
+
+        if (msg == "estimation") {
+            juce::String stage = "Queued";
+            if (!message["rank"].isVoid()) {
+                stage << ": position " << ((int) message["rank"] + 1);
+                if ((int) message["queue_size"] > 0) {
+                    stage << " of " << (int) message["queue_size"];
+                }
+            }
+
+            const double eta = message["rank_eta"];
+            if (eta > 0.0) {
+                stage << ", about " << juce::roundToInt(eta) << " s";
+            }
+
+            report_progress(queued_progress, stage);
+        }
+        else if (msg == "process_starts") {
+            mark_inference_started();
+
+            juce::String stage = "Generating";
+            const double eta = message["eta"];
+            if (eta > 0.0) {
+                stage << ", about " << juce::roundToInt(eta) << " s";
+            }
+
+            report_progress(inference_start, stage);
+        }
+        else if (msg == "progress") {
+            const juce::var progress_data = message["progress_data"];
+            if (!progress_data.isArray() || progress_data.size() == 0) {
+                return;
+            }
+
+            // Gradio envoie soit index/length (pas d'inférence), soit une fraction directe
+            mark_inference_started();
+
+            const juce::var& item = progress_data[0];
+            const int index = item["index"];
+            const int length = item["length"];
+
+            float fraction = 0.0f;
+            juce::String stage = "Generating";
+            if (length > 0) {
+                fraction = (float) index / (float) length;
+                stage << ": step " << index << "/" << length;
+            }
+            else if (item["progress"].isDouble()) {
+                fraction = (float) (double) item["progress"];
+                stage << ": " << juce::roundToInt(fraction * 100.0f) << "%";
+            }
+
+            report_progress(inference_start + (download_start - inference_start) * fraction, stage);
+        }
+    }
+
+    static double now_ms() {
+        return juce::Time::getMillisecondCounterHiRes();
+    }
 
     // Génère un identifiant de session aléatoire
     std::string generate_session_hash() {
@@ -48,59 +178,233 @@ private:
         return result;
     }
 
-    // Effectue une requête POST
-    std::string make_post_request(const std::string& url, const std::string& data) {
-        if (verbose) {
-            std::cout << "POST " << url << std::endl;
-            std::cout << "DATA: " << data << std::endl;
+    void throw_if_cancelled(const juce::String& stage) const {
+        if (cancellation != nullptr) {
+            cancellation->throwIfCancelled(stage);
+        }
+    }
+
+    // Attente interrompue immédiatement par une annulation
+    void pause(const juce::String& stage, int milliseconds) {
+        if (cancellation != nullptr) {
+            cancellation->sleep(stage, milliseconds);
+        }
+        else {
+            juce::Thread::sleep(milliseconds);
+        }
+    }
+
+    // Délai de connexion borné par l'échéance de l'étape (0 signifierait « délai par défaut » pour JUCE)
+    int connect_timeout(const Deadline& deadline) const {
+        return juce::jlimit(1, deadlines.connectMs, (int) deadline.getRemainingMs());
+    }
+
+    // Ouvre un flux HTTP et vérifie le code de statut.
+    // timeout_ms borne la connexion puis chaque lecture : un serveur muet plus longtemps fait échouer l'étape.
+    // Le flux est rattaché au jeton d'annulation dès sa création, connexion comprise.
+    std::unique_ptr<CancellableStream> open_stream(const juce::String& stage, const juce::URL& url,
+                                                   bool use_post, const juce::String& headers,
+                                                   int timeout_ms) {
+        throw_if_cancelled(stage);
+
+        if (!breaker.allowRequest()) {
+            throw GenerationError(stage, FailureCause::circuitOpen, juce::String(server_url));
+        }
+
+        auto web_stream = std::make_unique<juce::WebInputStream>(url, use_post);
+        web_stream->withExtraHeaders(headers)
+                   .withConnectionTimeout(timeout_ms);
+
+        auto stream = std::make_unique<CancellableStream>(std::move(web_stream), cancellation);
+
+        if (!(*stream)->connect(nullptr)) {
+            throw_if_cancelled(stage);
+            breaker.recordFailure();
+            throw GenerationError(stage, FailureCause::network, "cannot reach " + url.toString(false));
+        }
+
+        const int status_code = (*stream)->getStatusCode();
+        if (status_code >= 400) {
+            // Une erreur 4xx prouve que le serveur répond : seules les 5xx comptent comme panne
+            if (status_code >= 500) {
+                breaker.recordFailure();
+            }
+            else {
+                breaker.recordSuccess();
+            }
+            throw GenerationError(stage, FailureCause::httpError, "HTTP " + juce::String(status_code), status_code);
+        }
+
+        breaker.recordSuccess();
+        return stream;
+    }
+
+    // Lit le corps de la réponse en respectant l'échéance de l'étape
+    std::string read_body(const juce::String& stage, juce::WebInputStream& stream, const Deadline& deadline) {
+        juce::MemoryOutputStream body;
+        char buffer[8192];
+
+        while (!stream.isExhausted()) {
+            if (deadline.hasExpired()) {
+                throw GenerationError(stage, FailureCause::timeout, "response too slow");
+            }
+
+            const int bytes_read = stream.read(buffer, (int) sizeof(buffer));
+            if (bytes_read <= 0) {
+                break;
+            }
+            body.write(buffer, (size_t) bytes_read);
+        }
+
+        throw_if_cancelled(stage);
+        check_complete(stage, stream, (juce::int64) body.getDataSize());
+        return body.toString().toStdString();
+    }
+
+    // Vérifie qu'un corps de taille annoncée a été reçu en entier
+    void check_complete(const juce::String& stage, juce::WebInputStream& stream, juce::int64 received) {
+        const juce::int64 expected = stream.getTotalLength();
+        if (expected > 0 && received < expected) {
+            breaker.recordFailure();
+            throw GenerationError(stage, FailureCause::network,
+                                  "connection lost after " + juce::String(received) + "/" + juce::String(expected) + " bytes");
         }
+    }
+
+    // Exécute une étape en la retentant sur les erreurs transitoires jusqu'à son échéance.
+    // Une étape non idempotente n'est retentée que si le serveur a explicitement refusé la requête.
+    template <typename Function>
+    auto with_retries(const juce::String& stage, const Deadline& deadline, bool idempotent, Function&& function)
+        -> decltype(function()) {
+        for (int attempt = 1;; ++attempt) {
+            try {
+                return function();
+            }
+            catch (const GenerationError& e) {
+                const bool rejected = e.getCause() == FailureCause::httpError
+                    && (e.getHttpStatus() == 429 || e.getHttpStatus() == 502
+                        || e.getHttpStatus() == 503 || e.getHttpStatus() == 504);
+
+                if (!(idempotent ? e.isRetryable() : rejected) || attempt >= retry_policy.maxAttempts) {
+                    throw;
+                }
 
-        // Créer un QNetworkAccessManager local pour éviter les problèmes de thread
-        QNetworkAccessManager localManager;
-        QNetworkRequest request(QUrl(QString::fromStdString(url)));
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+                const int delay_ms = retry_policy.getDelayMs(attempt, random);
+                if (deadline.getRemainingMs() <= delay_ms) {
+                    throw;
+                }
 
-        QEventLoop loop;
-        QNetworkReply* reply = localManager.post(request, QByteArray(data.c_str()));
+                if (verbose) {
+                    std::cout << e.what() << " - nouvelle tentative dans " << delay_ms << " ms" << std::endl;
+                }
 
-        QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-        loop.exec();
+                pause(stage, delay_ms);
+            }
+        }
+    }
 
-        if (reply->error() != QNetworkReply::NoError) {
-            std::string error = "Erreur de réseau: " + reply->errorString().toStdString();
-            reply->deleteLater();
-            throw std::runtime_error(error);
+    // Effectue une requête POST
+    std::string make_post_request(const juce::String& stage, const std::string& url, const std::string& data,
+                                  const Deadline& deadline) {
+        if (verbose) {
+            std::cout << "POST " << url << std::endl;
+            std::cout << "DATA: " << data << std::endl;
         }
 
-        QByteArray responseData = reply->readAll();
-        reply->deleteLater();
+        juce::URL request_url = juce::URL(juce::String(url)).withPOSTData(juce::String(data));
+        auto stream = open_stream(stage, request_url, true, "Content-Type: application/json\r\n",
+                                  connect_timeout(deadline));
+
+        std::string response = read_body(stage, **stream, deadline);
 
         if (verbose) {
-            std::cout << "Réponse: " << QString(responseData).toStdString() << std::endl;
+            std::cout << "Réponse: " << response << std::endl;
         }
 
-        return QString(responseData).toStdString();
+        return response;
+    }
+
+    // Effectue une requête GET et retourne le corps de la réponse
+    std::string make_get_request(const juce::String& stage, const std::string& url, const Deadline& deadline) {
+        auto stream = open_stream(stage, juce::URL(juce::String(url)), false, {},
+                                  connect_timeout(deadline));
+        return read_body(stage, **stream, deadline);
     }
 
     // Extrait une valeur d'une chaîne JSON
     std::string extract_json_value(const std::string& json_str, const std::string& key) {
-        QJsonDocument doc = QJsonDocument::fromJson(QByteArray(json_str.c_str()));
-        if (doc.isNull() || !doc.isObject()) {
+        juce::var json = juce::JSON::parse(juce::String(json_str));
+        if (!json.isObject()) {
             return "";
         }
 
-        QJsonObject json = doc.object();
-        if (json.contains(QString::fromStdString(key))) {
-            QJsonValue value = json[QString::fromStdString(key)];
-            if (value.isString()) {
-                return value.toString().toStdString();
-            }
+        juce::var value = json[juce::Identifier(juce::String(key))];
+        if (value.isString()) {
+            return value.toString().toStdString();
         }
         return "";
     }
 
+    // Extrait le chemin du fichier audio (wav, flac ou ogg) produit par le serveur d'une réponse Gradio
+    bool extract_file_path(const std::string& response, std::string& file_path) {
+        size_t extension_pos = std::string::npos;
+        for (const char* extension : { ".wav", ".flac", ".ogg" }) {
+            extension_pos = juce::jmin(extension_pos, response.find(std::string(extension) + "\""));
+        }
+
+        if (extension_pos == std::string::npos) {
+            return false;
+        }
+
+        // Chercher un chemin complet avec /tmp/
+        size_t path_start = response.rfind("/tmp/", extension_pos);
+        if (path_start == std::string::npos) {
+            return false;
+        }
+
+        // Reculer jusqu'au premier guillemet ou début de délimiteur
+        size_t quote_start = response.rfind("\"", path_start);
+        if (quote_start == std::string::npos || quote_start >= path_start) {
+            return false;
+        }
+
+        path_start = quote_start + 1;
+        size_t path_end = response.find("\"", extension_pos);
+        if (path_end == std::string::npos) {
+            return false;
+        }
+
+        std::string full_path = response.substr(path_start, path_end - path_start);
+        file_path = "/gradio_api/file=" + full_path;
+        if (verbose) {
+            std::cout << "Chemin complet extrait: " << file_path << std::endl;
+        }
+        return true;
+    }
+
+    // Rejette un résultat en échec (« success »: false), avec le message d'erreur du serveur.
+    // Un refus explicite des entrées (nombre d'arguments, format inconnu) est distingué d'un échec
+    // de la génération elle-même (mémoire, prompt refusé...) : seul le premier justifie le repli WAV.
+    void check_result_success(const juce::String& stage, const std::string& message) {
+        const juce::var json = juce::JSON::parse(juce::String(message));
+        if (json.isObject() && json.hasProperty("success") && !(bool) json["success"]) {
+            const juce::String detail = json["output"]["error"].toString();
+            throw GenerationError(stage, is_input_rejection(detail) ? FailureCause::rejectedInput : FailureCause::protocol,
+                                  detail.isNotEmpty() ? detail : juce::String("generation failed on the server"));
+        }
+    }
+
+    // Messages de Gradio et de Python pour des entrées en trop ou une valeur hors des choix proposés
+    bool is_input_rejection(const juce::String& detail) const {
+        const juce::String text = detail.toLowerCase();
+        return text.contains("input values")                                  // didn't receive enough input values (needed: 5, got: 6)
+            || (text.contains("positional argument") && text.contains("given"))   // takes 5 positional arguments but 6 were given
+            || (text.contains("not in the list of choices") && text.contains(juce::String(transfer_format).toLowerCase()));
+    }
+
     // Fonction pour écouter les événements SSE et récupérer le chemin du fichier
-    bool listen_for_sse_events(const std::string& session_hash_param, std::string& file_path) {
+    bool listen_for_sse_events(const std::string& session_hash_param, std::string& file_path,
+                               const Deadline& deadline) {
         std::string sse_url = server_url + "/gradio_api/queue/data?session_hash=" + session_hash_param;
 
         if (verbose) {
@@ -109,60 +413,52 @@ private:
         }
 
         try {
-            // Créer un QNetworkAccessManager local pour éviter les problèmes de thread
-            QNetworkAccessManager localManager;
-            QNetworkRequest request(QUrl(QString::fromStdString(sse_url)));
-            request.setRawHeader("Accept", "text/event-stream");
-            request.setRawHeader("Cache-Control", "no-cache");
+            const double connect_start = now_ms();
+            const juce::int64 connect_start_us = TraceLog::nowUs();
+
+            // Le délai de lecture vaut le silence maximum toléré entre deux événements
+            auto stream = open_stream("events", juce::URL(juce::String(sse_url)), false,
+                                      "Accept: text/event-stream\r\nCache-Control: no-cache\r\n",
+                                      deadlines.eventStallMs);
 
-            QEventLoop loop;
-            QNetworkReply* reply = localManager.get(request);
+            // Lire le flux ligne par ligne jusqu'au message de fin de traitement
+            juce::WebInputStream& events = **stream;
 
-            // Définir un timeout de 10 secondes
-            QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+            while (!events.isExhausted() && !deadline.hasExpired()) {
+                std::string line = events.readNextLine().toStdString();
 
-            QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-            loop.exec();
+                if (line.rfind("data:", 0) != 0) {
+                    continue;
+                }
 
-            if (reply->error() == QNetworkReply::NoError) {
-                QByteArray responseData = reply->readAll();
-                std::string response = QString(responseData).toStdString();
+                if (last_timings.first_event_ms == 0.0) {
+                    last_timings.first_event_ms = now_ms() - connect_start;
+                    trace->record("sse delivery", "network", connect_start_us, TraceLog::nowUs(), "first event");
+                }
 
                 if (verbose) {
-                    std::cout << "\n===== RÉPONSE SSE =====" << std::endl;
-                    std::cout << response << std::endl;
-                    std::cout << "======================" << std::endl;
+                    std::cout << "SSE " << line << std::endl;
                 }
 
-                // Rechercher un chemin de fichier WAV dans la réponse
-                size_t wav_pos = response.find(".wav");
-                if (wav_pos != std::string::npos) {
-                    // Chercher un chemin complet avec /tmp/
-                    size_t path_start = response.rfind("/tmp/", wav_pos);
-                    if (path_start != std::string::npos) {
-                        // Reculer jusqu'au premier guillemet ou début de délimiteur
-                        size_t quote_start = response.rfind("\"", path_start);
-                        if (quote_start != std::string::npos && quote_start < path_start) {
-                            path_start = quote_start + 1;
-                            size_t path_end = response.find("\"", wav_pos);
-                            if (path_end != std::string::npos) {
-                                std::string full_path = response.substr(path_start, path_end - path_start);
-                                file_path = "/gradio_api/file=" + full_path;
-                                if (verbose) {
-                                    std::cout << "Chemin complet extrait: " << file_path << std::endl;
-                                }
-                                reply->deleteLater();
-                                return true;
-                            }
-                        }
-                    }
+                if (line.find("process_completed") != std::string::npos) {
+                    check_result_success("events", line.substr(5));
+                    return extract_file_path(line, file_path);
                 }
+
+                handle_queue_message(juce::JSON::parse(juce::String(line.substr(5))));
             }
-            reply->deleteLater();
 
+            throw_if_cancelled("events");
             return false;
         }
-        catch (const std::exception& e) {
+        catch (const GenerationError& e) {
+            // Après une annulation, un échec côté serveur ou avec le disjoncteur ouvert,
+            // le repli sur le statut est inutile
+            if (e.getCause() == FailureCause::circuitOpen || e.getCause() == FailureCause::cancelled
+                || e.getCause() == FailureCause::protocol || e.getCause() == FailureCause::rejectedInput) {
+                throw;
+            }
+
             std::cerr << "Exception lors de l'écoute SSE: " << e.what() << std::endl;
             return false;
         }
@@ -174,80 +470,65 @@ private:
             std::cout << "Attente du résultat (event_id: " << event_id << ")..." << std::endl;
         }
 
+        const Deadline deadline(deadlines.resultMs);
         std::string file_path;
-        int attempts = 0;
-        const int max_attempts = 30;
 
         // Stratégie 1: Écouter les événements SSE
         if (verbose) {
             std::cout << "Stratégie 1: Écoute des événements SSE..." << std::endl;
         }
 
-        if (listen_for_sse_events(session_hash, file_path)) {
+        if (listen_for_sse_events(session_hash, file_path, deadline)) {
             return file_path;
         }
 
-        // Stratégie 2: Polling avec API de statut
+        // Stratégie 2: Polling avec API de statut, à intervalle croissant jusqu'à l'échéance
         if (verbose) {
             std::cout << "Stratégie 2: Vérification du statut..." << std::endl;
         }
 
         std::string status_url = server_url + "/gradio_api/queue/status?event_id=" + event_id;
+        TraceLog::Span polling(*trace, "status polling", "network", "SSE fallback");
+        int polls = 0;
+        int consecutive_errors = 0;
 
-        while (file_path.empty() && attempts < max_attempts) {
-            // Créer un QNetworkAccessManager local pour éviter les problèmes de thread
-            QNetworkAccessManager localManager;
-            QNetworkRequest request(QUrl(QString::fromStdString(status_url)));
-            QEventLoop loop;
-            QNetworkReply* reply = localManager.get(request);
-
-            QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-            loop.exec();
-
-            if (reply->error() == QNetworkReply::NoError) {
-                QByteArray responseData = reply->readAll();
-                std::string response = QString(responseData).toStdString();
+        while (!deadline.hasExpired()) {
+            try {
+                std::string response = make_get_request("status", status_url, deadline);
+                consecutive_errors = 0;
+                handle_queue_message(juce::JSON::parse(juce::String(response)));
 
                 // Chercher "process_completed" dans la réponse
                 if (response.find("process_completed") != std::string::npos) {
-                    // Rechercher le chemin du fichier dans la réponse
-                    size_t wav_pos = response.find(".wav");
-                    if (wav_pos != std::string::npos) {
-                        // Chercher un chemin complet avec /tmp/
-                        size_t path_start = response.rfind("/tmp/", wav_pos);
-                        if (path_start != std::string::npos) {
-                            // Reculer jusqu'au premier guillemet ou début de délimiteur
-                            size_t quote_start = response.rfind("\"", path_start);
-                            if (quote_start != std::string::npos && quote_start < path_start) {
-                                path_start = quote_start + 1;
-                                size_t path_end = response.find("\"", wav_pos);
-                                if (path_end != std::string::npos) {
-                                    std::string full_path = response.substr(path_start, path_end - path_start);
-                                    file_path = "/gradio_api/file=" + full_path;
-                                    if (verbose) {
-                                        std::cout << "Chemin complet extrait: " << file_path << std::endl;
-                                    }
-                                    break;
-                                }
-                            }
-                        }
+                    check_result_success("status", response);
+                    if (!extract_file_path(response, file_path)) {
+                        throw GenerationError("status", FailureCause::protocol, "no audio file in the result");
                     }
+                    break;
                 }
             }
+            catch (const GenerationError& e) {
+                if (!e.isRetryable() || ++consecutive_errors >= retry_policy.maxAttempts) {
+                    throw;
+                }
 
-            reply->deleteLater();
+                if (verbose) {
+                    std::cout << "Statut indisponible: " << e.what() << std::endl;
+                }
+            }
 
             // Attendre avant la prochaine tentative
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            attempts++;
+            const int delay_ms = status_poll_policy.getDelayMs(++polls, random);
+            pause("status", juce::jmin(delay_ms, (int) deadline.getRemainingMs()));
 
-            if (verbose && attempts % 5 == 0) {
-                std::cout << "Tentative " << attempts << "/" << max_attempts << "..." << std::endl;
+            if (verbose && polls % 5 == 0) {
+                std::cout << "Vérification " << polls << "..." << std::endl;
             }
         }
 
         if (file_path.empty()) {
-            throw std::runtime_error("Timeout: Aucun résultat reçu après " + std::to_string(max_attempts) + " secondes");
+            throw GenerationError("result", FailureCause::timeout,
+                                  "no result after " + juce::String(deadlines.resultMs / 1000) + " s");
         }
 
         if (verbose) {
@@ -257,41 +538,175 @@ private:
         return file_path;
     }
 
-    // Télécharge un fichier à partir d'une URL
-    bool download_file(const std::string& url, const std::string& output_file) {
-        // Créer un QNetworkAccessManager local pour éviter les problèmes de thread
-        QNetworkAccessManager localManager;
-        QNetworkRequest request((QUrl(QString::fromStdString(url))));
+    // Télécharge un fichier à partir d'une URL.
+    // Le corps est écrit dans un fichier .part : une tentative interrompue reprend où la
+    // précédente s'est arrêtée grâce à une requête Range.
+    // Si un callback de flux est installé, les octets reçus sont aussi transmis au fur et à
+    // mesure dans un ProgressiveBuffer, pour décoder l'IR pendant le téléchargement ; sinon
+    // le corps est demandé compressé en gzip (un corps gzip ne peut pas être décodé progressivement).
+    // Retourne le fichier final, dont l'extension suit le format audio réellement reçu.
+    juce::File download_file(const std::string& url, const juce::File& output_file) {
+        const Deadline deadline(deadlines.downloadMs);
+        const juce::File partial = output_file.getSiblingFile(output_file.getFileName() + ".part");
+        partial.deleteFile();
+
+        bool gzip_encoded = false;
+        std::shared_ptr<ProgressiveBuffer> progressive;
+        report_progress(download_start, "Downloading");
 
-        QEventLoop loop;
-        QNetworkReply* reply = localManager.get(request);
+        try {
+            with_retries("download", deadline, true, [&] {
+                const juce::int64 resume_from = partial.existsAsFile() ? partial.getSize() : 0;
 
-        QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-        loop.exec();
+                juce::String headers;
+                if (!on_stream) {
+                    headers << "Accept-Encoding: gzip\r\n";
+                }
+                if (resume_from > 0) {
+                    headers << "Range: bytes=" << resume_from << "-\r\n";
+                }
 
-        if (reply->error() != QNetworkReply::NoError) {
-            std::cerr << "Erreur de téléchargement: " << reply->errorString().toStdString() << std::endl;
-            reply->deleteLater();
-            return false;
+                auto stream = open_stream("download", juce::URL(juce::String(url)), false, headers,
+                                          connect_timeout(deadline));
+                juce::WebInputStream& body = **stream;
+
+                // 206 : le serveur reprend au décalage demandé ; 200 : il renvoie tout le fichier
+                const bool resumed = resume_from > 0 && body.getStatusCode() == 206;
+                const juce::int64 offset = resumed ? resume_from : 0;
+
+                if (!resumed || !gzip_encoded) {
+                    gzip_encoded = body.getResponseHeaders()
+                                       .getValue("Content-Encoding", {}).containsIgnoreCase("gzip");
+                }
+
+                if (verbose && resumed) {
+                    std::cout << "Reprise du téléchargement à " << resume_from << " octets" << std::endl;
+                }
+
+                juce::FileOutputStream out(partial);
+                if (!out.openedOk()) {
+                    throw GenerationError("download", FailureCause::protocol,
+                                          "cannot write " + partial.getFullPathName());
+                }
+
+                // FileOutputStream se place en fin de fichier : repartir de zéro si le serveur ignore Range
+                if (!resumed) {
+                    out.setPosition(0);
+                    out.truncate();
+                }
+
+                juce::HeapBlock<char> buffer(65536);
+                juce::int64 received = 0;
+                const juce::int64 remaining = body.getTotalLength();
+                const juce::int64 total = remaining > 0 ? offset + remaining : -1;
+
+                // Le flux progressif suit le fichier .part : il est abandonné si le serveur
+                // renvoie tout depuis le début, puis recréé pour le nouveau corps
+                if (progressive != nullptr && !resumed) {
+                    progressive->abort();
+                    progressive.reset();
+                }
+
+                if (on_stream && progressive == nullptr && offset == 0 && !gzip_encoded) {
+                    progressive = std::make_shared<ProgressiveBuffer>();
+                    progressive->setTotalLength(total);
+                    on_stream(progressive);
+                }
+
+                while (!body.isExhausted()) {
+                    if (deadline.hasExpired()) {
+                        throw GenerationError("download", FailureCause::timeout,
+                                              "after " + juce::String(deadlines.downloadMs / 1000) + " s");
+                    }
+
+                    const int bytes_read = body.read(buffer.getData(), 65536);
+                    if (bytes_read <= 0) {
+                        break;
+                    }
+
+                    // Écrire au fur et à mesure : un transfert coupé garde ce qui a été reçu
+                    if (!out.write(buffer.getData(), (size_t) bytes_read)) {
+                        throw GenerationError("download", FailureCause::protocol, out.getStatus().getErrorMessage());
+                    }
+                    received += bytes_read;
+
+                    if (progressive != nullptr) {
+                        progressive->append(buffer.getData(), (size_t) bytes_read);
+                    }
+
+                    if (total > 0) {
+                        const float fraction = (float) (offset + received) / (float) total;
+                        report_progress(download_start + (1.0f - download_start) * fraction,
+                                        "Downloading: " + juce::String(juce::roundToInt(fraction * 100.0f)) + "%");
+                    }
+                }
+
+                out.flush();
+                throw_if_cancelled("download");
+                check_complete("download", body, received);
+
+                if (!out.getStatus().wasOk()) {
+                    throw GenerationError("download", FailureCause::protocol, out.getStatus().getErrorMessage());
+                }
+
+                last_timings.downloaded_bytes = offset + received;
+            });
+        }
+        catch (...) {
+            if (progressive != nullptr) {
+                progressive->abort();
+            }
+            throw;
         }
 
-        QFile file(QString::fromStdString(output_file));
-        if (!file.open(QIODevice::WriteOnly)) {
-            std::cerr << "Erreur: Impossible d'ouvrir le fichier de sortie: " << output_file << std::endl;
-            reply->deleteLater();
-            return false;
+        if (progressive != nullptr) {
+            progressive->finish();
         }
 
-        file.write(reply->readAll());
-        file.close();
-        reply->deleteLater();
+        // Décompression gzip éventuelle (certaines piles HTTP la font déjà elles-mêmes)
+        if (gzip_encoded && has_gzip_header(partial)) {
+            const juce::File inflated = partial.getSiblingFile(partial.getFileName() + ".raw");
 
-        return true;
+            {
+                juce::FileInputStream in(partial);
+                juce::GZIPDecompressorInputStream gzip(&in, false, juce::GZIPDecompressorInputStream::gzipFormat);
+                juce::FileOutputStream out(inflated);
+
+                if (!in.openedOk() || !out.openedOk()) {
+                    throw GenerationError("download", FailureCause::protocol, "cannot decompress the audio file");
+                }
+
+                out.setPosition(0);
+                out.truncate();
+                out.writeFromInputStream(gzip, -1);
+                out.flush();
+
+                if (!out.getStatus().wasOk()) {
+                    throw GenerationError("download", FailureCause::protocol, out.getStatus().getErrorMessage());
+                }
+            }
+
+            inflated.moveFileTo(partial);
+        }
+
+        // Le nom final porte l'extension du format reçu, pour que le lecteur audio adéquat soit choisi
+        const juce::File result = output_file.withFileExtension(ImpulseResponse::detectFileExtension(partial,
+                                                                    output_file.getFileExtension()));
+        if (!partial.moveFileTo(result)) {
+            throw GenerationError("download", FailureCause::protocol, "cannot write " + result.getFullPathName());
+        }
+
+        return result;
+    }
+
+    static bool has_gzip_header(const juce::File& file) {
+        juce::FileInputStream in(file);
+        return in.openedOk() && in.readByte() == (char) 0x1f && in.readByte() == (char) 0x8b;
     }
 
 public:
     // Constructeur
-    QtImpl_TangoFluxClient(const std::string& url, bool verbose_mode = false)
+    JuceImpl_TangoFluxClient(const std::string& url, bool verbose_mode = false)
         : server_url(url), verbose(verbose_mode) {
         // Nettoyer l'URL si nécessaire
         if (!server_url.empty() && server_url.back() == '/') {
@@ -308,20 +723,26 @@ public:
         }
     }
 
-    // Destructeur
-    ~QtImpl_TangoFluxClient() {
-        // Pas besoin de nettoyage explicite pour Qt
-    }
-
-    // Génère un audio avec TangoFlux via l'API Gradio
+    // Génère un audio avec TangoFlux via l'API Gradio.
+    // Lève GenerationError en indiquant l'étape et la cause de l'échec.
+    // Si un jeton est fourni, son annulation interrompt immédiatement le transfert ou l'attente en cours.
+    // Retourne le chemin du fichier écrit : son extension suit le format reçu et peut différer de output_file.
     std::string generate_audio(
         const std::string& prompt,
         float duration = 5.0f,
         int steps = 50,
         float guidance_scale = 3.5f,
         int seed = 42,
-        const std::string& output_file = "output.wav"
+        const std::string& output_file = "output.wav",
+        CancellationToken* cancellation_token = nullptr
     ) {
+        // Le jeton n'est utilisé que pendant cet appel
+        cancellation = cancellation_token;
+        struct token_reset {
+            CancellationToken*& token;
+            ~token_reset() { token = nullptr; }
+        } reset_on_exit { cancellation };
+
         if (verbose) {
             std::cout << "Génération d'audio avec les paramètres:" << std::endl;
             std::cout << "- Prompt: " << prompt << std::endl;
@@ -331,30 +752,57 @@ public:
             std::cout << "- Seed: " << seed << std::endl;
         }
 
+        last_timings = {};
+        const double generation_start = now_ms();
+
         // 1. Rejoindre la file d'attente pour démarrer la génération
         std::string join_url = server_url + "/gradio_api/queue/join";
 
-        std::string join_data = "{"
-            "\"data\": [\"" + prompt + "\", " +
-            std::to_string(duration) + ", " +
-            std::to_string(steps) + ", " +
-            std::to_string(guidance_scale) + ", " +
-            std::to_string(seed) + "]," +
-            "\"event_data\": null," +
-            "\"fn_index\": 0," +
-            "\"trigger_id\": 0," +
-            "\"session_hash\": \"" + session_hash + "\""
-            "}";
+        // Le JSON est construit avec juce::JSON pour que le prompt soit correctement échappé
+        juce::Array<juce::var> data;
+        data.add(juce::String(prompt));
+        data.add((double) duration);
+        data.add(steps);
+        data.add((double) guidance_scale);
+        data.add(seed);
+
+        // Format compressé demandé en entrée supplémentaire, si le serveur la connaît
+        const bool format_requested = server_accepts_format && transfer_format != "wav";
+        if (format_requested) {
+            data.add(juce::String(transfer_format));
+        }
+
+        auto* join_object = new juce::DynamicObject();
+        join_object->setProperty("data", data);
+        join_object->setProperty("event_data", juce::var());
+        join_object->setProperty("fn_index", 0);
+        join_object->setProperty("trigger_id", 0);
+        join_object->setProperty("session_hash", juce::String(session_hash));
+
+        std::string join_data = juce::JSON::toString(juce::var(join_object), true).toStdString();
 
         if (verbose) {
             std::cout << "Rejoindre la file d'attente Gradio..." << std::endl;
         }
 
-        std::string join_response = make_post_request(join_url, join_data);
+        report_progress(0.0f, "Joining queue");
+
+        double stage_start = now_ms();
+        const juce::int64 join_start_us = TraceLog::nowUs();
+        const Deadline join_deadline(deadlines.joinMs);
+
+        // Rejoindre la file n'est pas idempotent : pas de nouvel essai si la requête a pu être traitée
+        std::string join_response = with_retries("join", join_deadline, false, [&] {
+            return make_post_request("join", join_url, join_data, join_deadline);
+        });
         std::string event_id = extract_json_value(join_response, "event_id");
+        last_timings.join_ms = now_ms() - stage_start;
+        queued_at_us = TraceLog::nowUs();
+        inference_start_us = 0;
+        trace->record("queue join", "network", join_start_us, queued_at_us, juce::String(server_url));
 
         if (event_id.empty()) {
-            throw std::runtime_error("Impossible d'obtenir l'identifiant d'événement de la file d'attente");
+            throw GenerationError("join", FailureCause::protocol, "no event_id in the queue response");
         }
 
         if (verbose) {
@@ -362,11 +810,28 @@ public:
         }
 
         // 2. Attendre le résultat
-        std::string file_path = wait_for_result(event_id);
+        stage_start = now_ms();
+        std::string file_path;
+        try {
+            file_path = wait_for_result(event_id);
+        }
+        catch (const GenerationError& e) {
+            // Un serveur plus ancien rejette l'entrée de format : recommencer une fois en WAV.
+            // Un autre échec du serveur est remonté tel quel, sans seconde génération.
+            if (!format_requested || e.getCause() != FailureCause::rejectedInput) {
+                throw;
+            }
 
-        if (file_path.empty()) {
-            throw std::runtime_error("Aucun fichier audio n'a été généré");
+            if (verbose) {
+                std::cout << "Format " << transfer_format << " refusé par le serveur, repli sur WAV" << std::endl;
+            }
+
+            server_accepts_format = false;
+            return generate_audio(prompt, duration, steps, guidance_scale, seed, output_file, cancellation_token);
         }
+        last_timings.result_wait_ms = now_ms() - stage_start;
+        trace->record("inference", "server", inference_start_us != 0 ? inference_start_us : queued_at_us,
+                      TraceLog::nowUs());
 
         // 3. Télécharger le fichier audio
         std::string file_url;
@@ -386,15 +851,19 @@ public:
             std::cout << "Téléchargement du fichier audio: " << file_url << std::endl;
         }
 
-        if (!download_file(file_url, output_file)) {
-            throw std::runtime_error("Échec du téléchargement du fichier audio");
-        }
+        stage_start = now_ms();
+        const juce::int64 download_start_us = TraceLog::nowUs();
+        const juce::File downloaded = download_file(file_url, juce::File(juce::String(output_file)));
+        last_timings.download_ms = now_ms() - stage_start;
+        trace->record("download", "network", download_start_us, TraceLog::nowUs(),
+                      juce::String(last_timings.downloaded_bytes / 1024) + " KiB");
+        last_timings.total_ms = now_ms() - generation_start;
 
         if (verbose) {
-            std::cout << "Audio généré avec succès et sauvegardé dans: " << output_file << std::endl;
+            std::cout << "Audio généré avec succès et sauvegardé dans: " << downloaded.getFullPathName() << std::endl;
         }
 
-        return output_file;
+        return downloaded.getFullPathName().toStdString();
     }
 
     // Accesseurs
@@ -403,6 +872,19 @@ public:
         if (!server_url.empty() && server_url.back() == '/') {
             server_url.pop_back();
         }
+
+        // Nouveau serveur : l'état du disjoncteur et la détection du format ne s'appliquent plus
+        breaker.reset();
+        server_accepts_format = true;
+    }
+
+    // Format du fichier audio demandé au serveur : "flac" (sans perte, par défaut), "ogg" ou "wav"
+    void set_transfer_format(const std::string& format) {
+        transfer_format = format;
+    }
+
+    std::string get_transfer_format() const {
+        return transfer_format;
     }
 
     std::string get_server_url() const {
@@ -416,160 +898,1210 @@ public:
     bool is_verbose() const {
         return verbose;
     }
-};
-
-// Classe adaptateur pour intégrer le client Qt dans JUCE
-class TangoFluxClient : public juce::Thread
-{
-public:
-    // Structure pour les paramètres de génération
-    struct GenerationParams {
-        juce::String prompt;
-        float duration = 5.0f;
-        int steps = 50;
-        float guidanceScale = 3.5f;
-        int seed = 42;
-    };
-
-    // Événements
-    class Listener
-    {
-    public:
-        virtual ~Listener() = default;
-        virtual void generationCompleted(const juce::File& irFile) = 0;
-        virtual void generationFailed(const juce::String& errorMessage) = 0;
-        virtual void generationProgress(float progressPercentage) = 0;
-    };
 
-    // Constructeur et destructeur
-    TangoFluxClient()
-        : juce::Thread("TangoFluxClient"),
-        qtClient("https://86d451fde387122f93.gradio.live", false),
-        verbose(false)
-    {
-        // Initialisation minimale
-        serverUrl = juce::String(qtClient.get_server_url());
+    void set_stage_deadlines(const StageDeadlines& d) {
+        deadlines = d;
     }
 
-    ~TangoFluxClient() override
-    {
-        // Arrêter le thread s'il est en cours d'exécution
-        stopThread(5000);
+    void set_retry_policy(const RetryPolicy& policy) {
+        retry_policy = policy;
     }
 
-    // Méthodes principales
-    void generateIR(const GenerationParams& params, const juce::File& outFile)
-    {
-        // Ne pas démarrer si déjà en cours d'exécution
-        if (isThreadRunning())
-            return;
+    CircuitBreaker::State get_circuit_state() const {
+        return breaker.getState();
+    }
 
-        // Stocker les paramètres pour le thread
-        currentParams = params;
-        outputFile = outFile;
+    void set_progress_callback(progress_callback callback) {
+        on_progress = std::move(callback);
+    }
 
-        // Mettre à jour le statut
-        statusMessage = "Starting generation...";
+    void set_stream_callback(stream_callback callback) {
+        on_stream = std::move(callback);
+    }
 
-        // Démarrer le thread
-        startThread();
+    const stage_timings& get_last_timings() const {
+        return last_timings;
     }
+};
 
-    void setServerUrl(const juce::String& url)
+// Service de génération partagé par toutes les instances du plugin d'un même processus
+// (SharedResourcePointer), au lieu d'un thread, d'un client HTTP et d'une session Gradio par instance.
+// - un nombre limité de générations simultanées par serveur (pool de clients HTTP réutilisés
+//   d'une génération à l'autre, chacun avec sa propre session) ;
+// - plusieurs serveurs possibles (EndpointPool) : chaque génération part sur celui qui devrait
+//   la terminer le plus tôt, et reprend sur un autre si le sien tombe en panne ;
+// - ordonnancement équitable : la prochaine génération est celle du demandeur servi le moins
+//   récemment, les générations spéculatives passant après toutes les autres ;
+// - dédoublonnage : une demande identique (paramètres, seed et serveur) à une génération en
+//   attente ou en cours s'y rattache au lieu d'en lancer une seconde ;
+// - le résultat est copié et notifié à chacun des demandeurs rattachés.
+class GenerationService : public GenerationBackend
+{
+public:
+    using Request = GenerationRequest;
+    using Subscriber = GenerationSubscriber;
+
+    GenerationService()
+        : scratchDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+            .getChildFile("GenIR").getChildFile("Service"))
     {
-        serverUrl = url;
-        if (serverUrl.endsWith("/"))
-            serverUrl = serverUrl.dropLastCharacters(1);
+        scratchDirectory.createDirectory();
 
-        qtClient.set_server_url(serverUrl.toStdString());
-    }
+        for (int i = 0; i < maxWorkers; ++i)
+            workers.add(new Worker(*this, i));
 
-    juce::String getServerUrl() const
-    {
-        return serverUrl;
+        for (auto* worker : workers)
+            worker->startThread();
     }
 
-    juce::String getStatusMessage() const
+    ~GenerationService() override
     {
-        return statusMessage;
+        {
+            const juce::ScopedLock lock(stateLock);
+            for (auto& job : jobs)
+                job->cancellation.cancel();
+        }
+
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+        {
+            worker->notify();
+            worker->stopThread(5000);
+        }
     }
 
-    void setVerboseMode(bool verboseMode)
+    // Clé de dédoublonnage : la clé du cache plus le serveur interrogé
+    static juce::String makeJobKey(const Request& request)
     {
-        verbose = verboseMode;
-        qtClient.set_verbose(verbose);
+        return GenerationCache::makeKey(request.prompt, request.duration, request.steps,
+            request.guidanceScale, request.seed) + "@" + request.serverUrl;
     }
 
-    // Gestion des écouteurs
-    void addListener(Listener* listener)
+    // Soumet ou remplace la demande de subscriber. Si une génération identique est déjà en
+    // attente ou en cours, le demandeur s'y rattache.
+    void submit(Subscriber& subscriber, const Request& request) override
     {
-        juce::ScopedLock lock(listenerLock);
-        listeners.add(listener);
+        const juce::String key = makeJobKey(request);
+        bool mustWait = false;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            const double now = juce::Time::getMillisecondCounterHiRes();
+
+            // Déjà rattaché à cette génération : seule la nature de la demande peut changer.
+            // Une génération qui remet déjà son résultat ne sert plus de nouvelle demande.
+            if (auto job = findJobOf(subscriber))
+            {
+                if (job->key == key && !job->finishing)
+                {
+                    for (auto& attachment : job->attachments)
+                    {
+                        if (attachment.subscriber == &subscriber)
+                        {
+                            attachment.outputFile = request.outputFile;
+                            attachment.speculative = request.speculative;
+                        }
+                    }
+
+                    if (!request.speculative)
+                        job->readyAtMs = juce::jmin(job->readyAtMs, now);
+
+                    notifyWorkers();
+                    return;
+                }
+
+                detach(*job, subscriber);
+            }
+
+            auto job = findJob(key);
+
+            if (job == nullptr)
+            {
+                job = makeJob(key, request, now + juce::jmax(0, request.delayMs));
+                jobs.push_back(job);
+            }
+            else if (!request.speculative)
+            {
+                job->readyAtMs = juce::jmin(job->readyAtMs, now);
+            }
+
+            job->request.verbose = job->request.verbose || request.verbose;
+            job->attachments.push_back({ &subscriber, request.outputFile, request.speculative, false,
+                                         std::make_shared<Delivery>() });
+            lastServed.emplace(&subscriber, (juce::uint64) 0);
+
+            // Les serveurs sont sondés dès qu'on les connaît ; ceux qu'on a remplacés sont oubliés
+            latestUrls = job->urls;
+            updateEndpoints();
+
+            mustWait = !request.speculative && !job->running && countRunning(*job) >= getConcurrencyLimit(*job);
+        }
+
+        if (mustWait)
+            subscriber.generationProgress(0.0f, "Waiting for a free generation slot");
+
+        notifyWorkers();
     }
 
-    void removeListener(Listener* listener)
+    // Détache subscriber de sa génération. Celle-ci est annulée (ou retirée de la file) s'il
+    // était le dernier à l'attendre. Après le retour, subscriber ne reçoit plus aucune notification.
+    // N'attend que la fin d'une notification en cours vers ce demandeur, pas celles des autres.
+    // Retourne false s'il n'attendait aucune génération.
+    bool cancel(Subscriber& subscriber) override
     {
-        juce::ScopedLock lock(listenerLock);
-        listeners.remove(listener);
+        std::shared_ptr<Delivery> delivery;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            auto job = findJobOf(subscriber);
+
+            if (job == nullptr)
+            {
+                lastServed.erase(&subscriber);
+                return false;
+            }
+
+            delivery = findAttachment(*job, subscriber).delivery;
+        }
+
+        {
+            const juce::ScopedLock guard(delivery->lock);
+            delivery->closed = true;
+        }
+
+        // Le demandeur a pu être reporté sur une autre génération entre-temps (finishJob)
+        const juce::ScopedLock lock(stateLock);
+
+        if (auto job = findJobOf(subscriber))
+            detach(*job, subscriber);
+
+        lastServed.erase(&subscriber);
+        updateEndpoints();
+        return true;
+    }
+
+    // Une génération est en attente ou en cours pour subscriber
+    bool isPending(Subscriber& subscriber) const override
+    {
+        const juce::ScopedLock lock(stateLock);
+        return findJobOf(subscriber) != nullptr;
+    }
+
+    // Nombre maximum de générations simultanées par serveur disponible, toutes instances confondues
+    void setMaximumConcurrentGenerations(int count)
+    {
+        maxConcurrent = juce::jlimit(1, maxWorkers, count);
+        notifyWorkers();
+    }
+
+    int getMaximumConcurrentGenerations() const
+    {
+        return maxConcurrent.load();
+    }
+
+    // État des serveurs utilisés
+    juce::Array<EndpointPool::Status> getEndpointStatus() const
+    {
+        return endpoints.getStatus();
     }
 
 private:
-    // Méthode exécutée dans le thread
-    void run() override
+    static constexpr int maxWorkers = 8;
+
+    // Remise des notifications à un demandeur : le verrou est tenu pendant chacune d'elles, et
+    // cancel() le prend pour attendre la fin de celle en cours. Un demandeur n'attend donc jamais
+    // les notifications (installation de l'IR comprise) des autres demandeurs de sa génération.
+    struct Delivery
+    {
+        juce::CriticalSection lock;
+        bool closed = false;   // demande annulée : plus aucune notification
+    };
+
+    struct Attachment
+    {
+        Subscriber* subscriber = nullptr;
+        juce::File outputFile;
+        bool speculative = false;
+        bool served = false;   // a reçu le résultat ou l'échec de la génération
+        std::shared_ptr<Delivery> delivery;   // suit le demandeur s'il est reporté sur une autre génération
+    };
+
+    struct Job
+    {
+        juce::String key;
+        juce::String cacheKey;
+        Request request;
+        juce::StringArray urls;   // serveurs de la demande (EndpointPool::parseUrls)
+        std::vector<Attachment> attachments;
+        juce::File scratchFile;
+        juce::uint64 order = 0;
+        double readyAtMs = 0.0;
+        juce::int64 submittedUs = 0;
+        bool running = false;
+        bool finishing = false;   // résultat en cours de remise : plus de nouveau demandeur
+
+        CancellationToken cancellation;
+    };
+
+    // Thread de génération, avec un client HTTP par serveur réutilisé d'une génération à l'autre
+    // (session Gradio, disjoncteur et format détecté propres à chaque serveur)
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(GenerationService& s, int workerIndex)
+            : juce::Thread("GenIR generation " + juce::String(workerIndex + 1)),
+            service(s),
+            index(workerIndex)
+        {
+        }
+
+        JuceImpl_TangoFluxClient& getClient(const juce::String& url)
+        {
+            auto& client = clients[url];
+
+            if (client == nullptr)
+            {
+                client = std::make_unique<JuceImpl_TangoFluxClient>(url.toStdString(), false);
+
+                // Les messages de file d'attente et de progression du serveur sont relayés aux demandeurs
+                client->set_progress_callback([this](float progress, const juce::String& stage)
+                    {
+                        if (currentJob != nullptr)
+                            service.notifyProgress(*currentJob, progress, stage);
+                    });
+
+                // Le fichier audio est transmis aux demandeurs pendant son téléchargement
+                client->set_stream_callback([this](std::shared_ptr<ProgressiveBuffer> buffer)
+                    {
+                        if (currentJob != nullptr)
+                            service.notifyStreamStarted(*currentJob, buffer);
+                    });
+            }
+
+            return *client;
+        }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                int waitMs = -1;
+                currentJob = service.takeNextJob(index, waitMs);
+
+                if (currentJob == nullptr)
+                {
+                    wait(waitMs);
+                    continue;
+                }
+
+                service.runJob(*currentJob, *this);
+                service.finishJob(currentJob);
+                currentJob.reset();
+            }
+        }
+
+    private:
+        GenerationService& service;
+        const int index;
+        std::map<juce::String, std::unique_ptr<JuceImpl_TangoFluxClient>> clients;
+        std::shared_ptr<Job> currentJob;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+    };
+
+    //==============================================================================
+    // Sous stateLock
+    std::shared_ptr<Job> makeJob(const juce::String& key, const Request& request, double readyAtMs)
+    {
+        auto job = std::make_shared<Job>();
+        job->key = key;
+        job->cacheKey = GenerationCache::makeKey(request.prompt, request.duration, request.steps,
+            request.guidanceScale, request.seed);
+        job->request = request;
+        job->urls = EndpointPool::parseUrls(request.serverUrl);
+        job->order = ++submissionCounter;
+        job->readyAtMs = readyAtMs;
+        job->submittedUs = TraceLog::nowUs();
+        job->scratchFile = scratchDirectory.getChildFile("job_" + juce::String(job->order) + ".wav");
+        return job;
+    }
+
+    // Génération identique à laquelle se rattacher. Une génération annulée (elle ne notifiera
+    // personne) ou qui remet déjà son résultat n'en est pas une.
+    std::shared_ptr<Job> findJob(const juce::String& key) const
+    {
+        for (auto& job : jobs)
+            if (job->key == key && !job->finishing && !job->cancellation.isCancelled())
+                return job;
+        return nullptr;
+    }
+
+    std::shared_ptr<Job> findJobOf(Subscriber& subscriber) const
+    {
+        for (auto& job : jobs)
+            for (auto& attachment : job->attachments)
+                if (attachment.subscriber == &subscriber)
+                    return job;
+        return nullptr;
+    }
+
+    // Rattachement de subscriber à job, qui doit exister
+    static const Attachment& findAttachment(const Job& job, Subscriber& subscriber)
+    {
+        auto it = std::find_if(job.attachments.begin(), job.attachments.end(),
+            [&subscriber](const Attachment& a) { return a.subscriber == &subscriber; });
+        jassert(it != job.attachments.end());
+        return *it;
+    }
+
+    // Appelle callback(subscriber) sous le verrou de ce seul demandeur, sauf s'il a annulé
+    template <typename Callback>
+    static void deliver(const Attachment& attachment, Callback&& callback)
+    {
+        const juce::ScopedLock guard(attachment.delivery->lock);
+
+        if (!attachment.delivery->closed)
+            callback(*attachment.subscriber);
+    }
+
+    // Générations simultanées permises pour job : le plafond par serveur, multiplié par le
+    // nombre de serveurs de sa liste qui répondent
+    int getConcurrencyLimit(const Job& job) const
+    {
+        return juce::jmin(maxWorkers, maxConcurrent.load() * endpoints.getNumAvailable(job.urls));
+    }
+
+    // Générations en cours sur au moins un des serveurs de job
+    int countRunning(const Job& job) const
+    {
+        int running = 0;
+        for (auto& other : jobs)
+            if (other->running && std::any_of(other->urls.begin(), other->urls.end(),
+                                              [&job](const juce::String& url) { return job.urls.contains(url); }))
+                ++running;
+        return running;
+    }
+
+    // Sous stateLock. Serveurs suivis : ceux des générations en attente ou en cours, et ceux de
+    // la dernière demande (mesures gardées pour la suivante)
+    void updateEndpoints()
     {
+        juce::StringArray urls(latestUrls);
+        for (auto& job : jobs)
+            urls.mergeArray(job->urls);
+
+        endpoints.setEndpoints(urls);
+    }
+
+    // Une génération que plus personne n'attend est retirée de la file, ou annulée si elle a démarré
+    void detach(Job& job, Subscriber& subscriber)
+    {
+        auto& attachments = job.attachments;
+        attachments.erase(std::remove_if(attachments.begin(), attachments.end(),
+            [&subscriber](const Attachment& a) { return a.subscriber == &subscriber; }), attachments.end());
+
+        if (!attachments.empty())
+            return;
+
+        if (job.running)
+        {
+            job.cancellation.cancel();
+        }
+        else
+        {
+            jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                [&job](const std::shared_ptr<Job>& j) { return j.get() == &job; }), jobs.end());
+        }
+    }
+
+    static bool isSpeculative(const Job& job)
+    {
+        for (auto& attachment : job.attachments)
+            if (!attachment.speculative)
+                return false;
+        return true;
+    }
+
+    void notifyWorkers()
+    {
+        for (auto* worker : workers)
+            worker->notify();
+    }
+
+    //==============================================================================
+    // Choisit la prochaine génération à lancer par le worker index, ou nullptr.
+    // waitMs reçoit le délai avant qu'une génération différée devienne prête (-1 : aucune).
+    std::shared_ptr<Job> takeNextJob(int workerIndex, int& waitMs)
+    {
+        const juce::ScopedLock lock(stateLock);
+        waitMs = -1;
+
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        std::shared_ptr<Job> best;
+        bool bestSpeculative = true;
+        juce::uint64 bestServed = 0;
+
+        for (auto& job : jobs)
+        {
+            if (job->running)
+                continue;
+
+            if (job->readyAtMs > now)
+            {
+                const int delay = juce::jmax(1, (int) (job->readyAtMs - now));
+                waitMs = waitMs < 0 ? delay : juce::jmin(waitMs, delay);
+                continue;
+            }
+
+            // Ses serveurs sont occupés (ou ce worker est en surnombre pour eux)
+            const int limit = getConcurrencyLimit(*job);
+            if (workerIndex >= limit || countRunning(*job) >= limit)
+                continue;
+
+            // Demandeur servi le moins récemment parmi ceux qui attendent cette génération
+            juce::uint64 served = std::numeric_limits<juce::uint64>::max();
+            for (auto& attachment : job->attachments)
+                served = juce::jmin(served, lastServed[attachment.subscriber]);
+
+            const bool speculative = isSpeculative(*job);
+
+            const bool better = best == nullptr
+                || (bestSpeculative && !speculative)
+                || (bestSpeculative == speculative
+                    && (served < bestServed || (served == bestServed && job->order < best->order)));
+
+            if (better)
+            {
+                best = job;
+                bestSpeculative = speculative;
+                bestServed = served;
+            }
+        }
+
+        if (best != nullptr)
+        {
+            best->running = true;
+            const juce::uint64 turn = ++servedCounter;
+
+            for (auto& attachment : best->attachments)
+                lastServed[attachment.subscriber] = turn;
+        }
+
+        return best;
+    }
+
+    // Retire la génération terminée. Un demandeur qui n'a reçu ni résultat ni échec (rattaché
+    // après la remise, ou après un retour anticipé de runJob) ne reste pas sans réponse : il est
+    // reporté sur une nouvelle génération, en général servie par le cache.
+    void finishJob(const std::shared_ptr<Job>& job)
+    {
+        std::vector<Attachment> unserved;
+
+        {
+            const juce::ScopedLock lock(stateLock);
+            jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+            job->finishing = true;
+
+            for (auto& attachment : job->attachments)
+                if (!attachment.served && !attachment.speculative)
+                    unserved.push_back(attachment);
+
+            if (!unserved.empty() && !job->cancellation.isCancelled())
+            {
+                auto retry = makeJob(job->key, job->request, juce::Time::getMillisecondCounterHiRes());
+                retry->request.speculative = false;
+
+                for (auto& attachment : unserved)
+                    retry->attachments.push_back({ attachment.subscriber, attachment.outputFile, false, false,
+                                                   attachment.delivery });
+
+                jobs.push_back(retry);
+                unserved.clear();
+            }
+
+            updateEndpoints();
+        }
+
+        // Annulée à la fermeture du service : prévenir plutôt que laisser attendre
+        for (auto& attachment : unserved)
+            deliver(attachment, [](Subscriber& s) { s.generationFailed("Error: generation cancelled"); });
+
+        // Une place s'est libérée
+        notifyWorkers();
+    }
+
+    // Copie des demandeurs à notifier (les spéculatifs n'attendent que le cache)
+    std::vector<Attachment> getListeners(Job& job) const
+    {
+        const juce::ScopedLock lock(stateLock);
+        std::vector<Attachment> result;
+
+        for (auto& attachment : job.attachments)
+            if (!attachment.speculative)
+                result.push_back(attachment);
+
+        return result;
+    }
+
+    // Demandeurs à qui remettre le résultat ou l'échec final. La génération n'accepte plus de
+    // nouveau demandeur ; ceux rattachés ensuite sont reportés par finishJob.
+    std::vector<Attachment> takeFinalListeners(Job& job)
+    {
+        const juce::ScopedLock lock(stateLock);
+        std::vector<Attachment> result;
+        job.finishing = true;
+
+        for (auto& attachment : job.attachments)
+        {
+            if (!attachment.speculative)
+            {
+                attachment.served = true;
+                result.push_back(attachment);
+            }
+        }
+
+        return result;
+    }
+
+    void notifyProgress(Job& job, float progress, const juce::String& stage)
+    {
+        for (auto& attachment : getListeners(job))
+            deliver(attachment, [&](Subscriber& s) { s.generationProgress(progress, stage); });
+    }
+
+    void notifyStreamStarted(Job& job, std::shared_ptr<ProgressiveBuffer> buffer)
+    {
+        for (auto& attachment : getListeners(job))
+            deliver(attachment, [&](Subscriber& s) { s.generationStreamStarted(buffer); });
+    }
+
+    void notifyFailed(Job& job, const juce::String& message)
+    {
+        for (auto& attachment : takeFinalListeners(job))
+            deliver(attachment, [&](Subscriber& s) { s.generationFailed(message); });
+    }
+
+    // Exécutée par un worker : cache, génération, décodage, puis remise du résultat à chaque demandeur
+    void runJob(Job& job, Worker& worker)
+    {
+        // Toutes les étapes de cette génération, jusqu'à l'installation de l'IR par les
+        // demandeurs (notifiés sur ce thread), sont rattachées à une même ligne du journal
+        const TraceLog::ScopedGeneration traced(trace->newGeneration());
+        trace->record("slot wait", "service", job.submittedUs, TraceLog::nowUs());
+        TraceLog::Span generationSpan(*trace, "generation", "service", job.request.prompt);
+
+        juce::File resultFile;
+
         try
         {
-            // Notification de progression 10%
+            const bool speculativeOnly = [&] { const juce::ScopedLock lock(stateLock); return isSpeculative(job); }();
+
+            // Une prédiction déjà en cache n'a rien à faire
+            if (speculativeOnly && cache->contains(job.cacheKey))
+                return;
+
+            notifyProgress(job, 0.0f, "Starting generation");
+
+            juce::String statusMessage = "IR loaded from cache";
+            {
+                TraceLog::Span span(*trace, "cache lookup", "service");
+                resultFile = cache->fetch(job.cacheKey, job.scratchFile);
+            }
+
+            if (resultFile == juce::File())
+            {
+                // Une génération identique est peut-être en cours dans un autre processus
+                GenerationCache::ScopedReservation reservation(*cache, job.cacheKey, &job.cancellation,
+                    [this, &job] { notifyProgress(job, 0.0f, "Waiting for an identical generation"); });
+                resultFile = cache->fetch(job.cacheKey, job.scratchFile);
+
+                if (resultFile == juce::File())
+                {
+                    resultFile = packContainer(generateOnEndpoints(job, worker), job.request);
+                    cache->store(job.cacheKey, resultFile);
+                    statusMessage = "IR generated successfully";
+                }
+            }
+
+            job.cancellation.throwIfCancelled("result");
+
+            if (getListeners(job).empty())
             {
-                juce::ScopedLock lock(listenerLock);
-                listeners.call(&Listener::generationProgress, 0.1f);
+                deleteOutputFiles(job.scratchFile);
+                return;
             }
 
-            statusMessage = "Generating... Please wait";
+            // Décodage une seule fois, quel que soit le nombre de demandeurs
+            notifyProgress(job, 1.0f, "Decoding");
 
-            // Utiliser notre client Qt pour générer l'audio
-            qtClient.generate_audio(
-                currentParams.prompt.toStdString(),
-                currentParams.duration,
-                currentParams.steps,
-                currentParams.guidanceScale,
-                currentParams.seed,
-                outputFile.getFullPathName().toStdString()
-            );
+            ImpulseResponse impulseResponse;
+            {
+                TraceLog::Span span(*trace, "decode", "dsp", resultFile.getFileName());
+                if (!impulseResponse.loadFromFile(resultFile))
+                    throw GenerationError("decode", FailureCause::protocol,
+                        "unreadable audio file " + resultFile.getFileName());
+            }
 
-            statusMessage = "IR generated successfully";
+            job.cancellation.throwIfCancelled("decode");
 
-            // Notification de fin de génération
+            // Chaque demandeur reçoit sa copie du fichier, au nom qu'il a choisi
+            for (auto& attachment : takeFinalListeners(job))
             {
-                juce::ScopedLock lock(listenerLock);
-                listeners.call(&Listener::generationCompleted, outputFile);
-                listeners.call(&Listener::generationProgress, 1.0f);
+                const juce::File irFile = attachment.outputFile.withFileExtension(resultFile.getFileExtension());
+
+                deliver(attachment, [&](Subscriber& s)
+                    {
+                        if (!resultFile.copyFileTo(irFile))
+                        {
+                            s.generationFailed("Error: cannot write " + irFile.getFullPathName());
+                            return;
+                        }
+
+                        impulseResponse.source = irFile;
+                        TraceLog::Span span(*trace, "install", "plugin", irFile.getFileName());
+                        s.generationCompleted(irFile, impulseResponse);
+                        s.generationProgress(1.0f, statusMessage);
+                    });
             }
         }
+        catch (const GenerationError& e)
+        {
+            // Une génération annulée n'a plus de demandeur à prévenir
+            if (e.getCause() != FailureCause::cancelled)
+                notifyFailed(job, "Error: " + juce::String(e.what()));
+        }
         catch (const std::exception& e)
         {
-            statusMessage = "Error: " + juce::String(e.what());
+            notifyFailed(job, "Error: " + juce::String(e.what()));
+        }
+
+        // Ne pas laisser de fichier, complet ou partiel, derrière une génération
+        deleteOutputFiles(job.scratchFile);
+    }
+
+    // Range le fichier reçu du serveur dans un conteneur .genir (GenIRFile) : échantillons,
+    // recette, analyse, et spectres pour la configuration du demandeur. C'est ce conteneur qui
+    // est mis en cache et remis aux demandeurs ; ils le projettent en mémoire au lieu de le
+    // décoder. Le fichier reçu est gardé tel quel si l'empaquetage échoue.
+    juce::File packContainer(const juce::File& received, const Request& request)
+    {
+        TraceLog::Span span(*trace, "pack", "service", received.getFileName());
+
+        ImpulseResponse decoded;
+        if (!decoded.loadFromFile(received))
+            return received;
+
+        GenIRFile::Contents contents;
+        contents.sampleRate = decoded.sampleRate;
+        contents.hasRecipe = true;
+        contents.recipe.prompt = request.prompt;
+        contents.recipe.duration = request.duration;
+        contents.recipe.steps = request.steps;
+        contents.recipe.guidanceScale = request.guidanceScale;
+        contents.recipe.seed = request.seed;
+        contents.hasAnalysis = true;
+        contents.analysis = IRAnalysis::analyse(decoded.samples, decoded.sampleRate);
+
+        // Même découpage que PartitionedConvolution, pour que les spectres y soient utilisables tels quels
+        if (request.preparedSampleRate > 0.0 && request.preparedBlockSize > 0)
+        {
+            const int channels = juce::jmin(2, decoded.samples.getNumChannels());
+            const int numPartitions = IRPartitioner::getNumPartitions(decoded.samples.getNumSamples(), decoded.sampleRate,
+                                                                      request.preparedSampleRate, request.preparedBlockSize);
+
+            auto prepared = std::make_shared<PreparedIR>(channels, request.preparedBlockSize, numPartitions,
+                                                         request.preparedSampleRate);
+            IRPartitioner partitioner(*prepared, decoded.sampleRate);
+            partitioner.append(decoded.samples, decoded.samples.getNumSamples());
+            partitioner.finish();
+            contents.spectra.push_back(std::move(prepared));
+        }
+
+        contents.samples = std::move(decoded.samples);
+
+        const juce::File container = received.withFileExtension(GenIRFile::fileExtension);
+        if (!GenIRFile::write(container, contents))
+            return received;
+
+        received.deleteFile();
+        return container;
+    }
+
+    // Génère sur le meilleur serveur de la liste demandée. Si le serveur tombe en panne en
+    // cours de génération, elle reprend depuis le début sur le suivant (même seed : même résultat).
+    juce::File generateOnEndpoints(Job& job, Worker& worker)
+    {
+        const juce::StringArray urls = EndpointPool::parseUrls(job.request.serverUrl);
+        juce::StringArray tried;
+
+        for (;;)
+        {
+            const juce::String url = endpoints.acquire(urls, tried);
+            if (url.isEmpty())
+                throw GenerationError("join", FailureCause::protocol, "no server configured");
 
-            // Notification d'erreur
+            tried.add(url);
+
+            auto& httpClient = worker.getClient(url);
+            httpClient.set_verbose(job.request.verbose);
+            const double start = juce::Time::getMillisecondCounterHiRes();
+            const juce::int64 startUs = TraceLog::nowUs();
+
+            try
             {
-                juce::ScopedLock lock(listenerLock);
-                listeners.call(&Listener::generationFailed, statusMessage);
+                const juce::File written(httpClient.generate_audio(
+                    job.request.prompt.toStdString(),
+                    job.request.duration,
+                    job.request.steps,
+                    job.request.guidanceScale,
+                    job.request.seed,
+                    job.scratchFile.getFullPathName().toStdString(),
+                    &job.cancellation
+                ));
+
+                endpoints.release(url, true, false, juce::Time::getMillisecondCounterHiRes() - start);
+                return written;
+            }
+            catch (const GenerationError& e)
+            {
+                const bool serverFailed = e.indicatesServerDown() || e.getCause() == FailureCause::circuitOpen;
+                endpoints.release(url, false, serverFailed, 0.0);
+                trace->record("failed attempt", "network", startUs, TraceLog::nowUs(), url);
+
+                // Une erreur de la demande elle-même se reproduirait sur un autre serveur
+                if (!serverFailed || e.getCause() == FailureCause::cancelled || tried.size() >= urls.size())
+                    throw;
+
+                deleteOutputFiles(job.scratchFile);
+                notifyProgress(job, 0.0f, "Server unavailable, switching to another one");
             }
         }
     }
 
+public:
+    // Supprime le fichier d'une génération, quel que soit son format, et son .part
+    static void deleteOutputFiles(const juce::File& file)
+    {
+        for (auto* extension : { ".genir", ".wav", ".flac", ".ogg" })
+        {
+            const juce::File candidate = file.withFileExtension(extension);
+            candidate.deleteFile();
+            candidate.getSiblingFile(candidate.getFileName() + ".part").deleteFile();
+        }
+    }
+
+private:
+    juce::File scratchDirectory;
+    juce::SharedResourcePointer<GenerationCache> cache;
+    juce::SharedResourcePointer<TraceLog> trace;
+
+    // Générations en attente et en cours, et dernier tour de service de chaque demandeur
+    mutable juce::CriticalSection stateLock;
+    std::vector<std::shared_ptr<Job>> jobs;
+    std::map<Subscriber*, juce::uint64> lastServed;
+    juce::StringArray latestUrls;   // serveurs de la dernière demande
+    juce::uint64 submissionCounter = 0;
+    juce::uint64 servedCounter = 0;
+
+    std::atomic<int> maxConcurrent { 2 };     // par serveur disponible
+    EndpointPool endpoints;
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GenerationService)
+};
+
+// Interface d'une instance du plugin vers le service de génération partagé
+class TangoFluxClient : private GenerationService::Subscriber
+{
+public:
+    // Structure pour les paramètres de génération
+    struct GenerationParams {
+        juce::String prompt;
+        float duration = 5.0f;
+        int steps = 50;
+        float guidanceScale = 3.5f;
+        int seed = 42;
+    };
+
+    // Moteur des générations de l'instance
+    enum class BackendMode
+    {
+        remote,                 // serveurs TangoFlux (par le démon GenIR s'il est lancé)
+        remoteWithFallback,     // idem, avec un brouillon procédural si aucun serveur ne répond
+        procedural              // synthèse procédurale locale seulement, instantanée
+    };
+
+    // Événements
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // irFile : fichier écrit (wav, flac ou ogg) ; impulseResponse : son contenu déjà décodé
+        virtual void generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse) = 0;
+        virtual void generationFailed(const juce::String& errorMessage) = 0;
+        // progressPercentage : avancement réel entre 0 et 1 ; stage : étape en cours
+        // (position dans la file et ETA, pas d'inférence, téléchargement)
+        virtual void generationProgress(float progressPercentage, const juce::String& stage) = 0;
+        // Début du téléchargement de l'IR : buffer reçoit le fichier au fil du transfert et peut
+        // être décodé avant generationCompleted(). Il est abandonné (abort) si le transfert échoue.
+        virtual void generationStreamStarted(std::shared_ptr<ProgressiveBuffer> buffer) { juce::ignoreUnused(buffer); }
+    };
+
+    // Constructeur et destructeur
+    TangoFluxClient()
+        : serverUrl("https://86d451fde387122f93.gradio.live"),
+        verbose(false)
+    {
+    }
+
+    ~TangoFluxClient() override
+    {
+        // La génération de cette instance est abandonnée ; celle des autres instances
+        // rattachées à la même demande continue
+        prefetcher.reset();
+        cancelRequest(*this);
+    }
+
+    // Méthodes principales
+    void generateIR(const GenerationParams& params, const juce::File& outFile)
+    {
+        // Ne pas démarrer si une génération de cette instance est déjà en attente ou en cours
+        if (isRequestPending(*this))
+            return;
+
+        // Une génération spéculative des mêmes paramètres continue : la demande s'y rattache.
+        // Toute autre est abandonnée pour libérer la file du serveur.
+        if (prefetcher != nullptr)
+            prefetcher->yieldTo(makeCacheKey(params));
+
+        submitRequest(*this, makeRequest(params, outFile, false));
+    }
+
+    // Annule la génération en cours, depuis n'importe quel thread. N'attend que la fin d'une
+    // notification en cours vers cette instance (courte : l'IR est installée sur un autre thread).
+    void cancelGeneration()
+    {
+        disarmFallback();
+
+        if (cancelRequest(*this))
+        {
+            juce::ScopedLock lock(listenerLock);
+            listeners.call(&Listener::generationFailed, juce::String("Generation cancelled"));
+        }
+    }
+
+    // Un ou plusieurs serveurs, séparés par des virgules : chaque génération part sur celui
+    // qui devrait la terminer le plus tôt (voir EndpointPool)
+    void setServerUrl(const juce::String& url)
+    {
+        const juce::String cleaned = EndpointPool::normalise(url);
+
+        juce::ScopedLock lock(settingsLock);
+        serverUrl = cleaned;
+    }
+
+    // Mode spéculatif : les paramètres en cours d'édition sont générés en arrière-plan
+    // après un délai d'inactivité, pour que Generate trouve le résultat prêt ou déjà commencé
+    void setSpeculativeMode(bool enabled)
+    {
+        if (enabled == (prefetcher != nullptr))
+            return;
+
+        if (enabled)
+            prefetcher = std::make_unique<Prefetcher>(*this);
+        else
+            prefetcher.reset();
+    }
+
+    bool isSpeculativeModeEnabled() const
+    {
+        return prefetcher != nullptr;
+    }
+
+    // Paramètres en cours d'édition ; sans effet hors mode spéculatif.
+    // Une génération spéculative différente déjà lancée est annulée.
+    void prefetchIR(const GenerationParams& params)
+    {
+        // Une synthèse procédurale est instantanée : rien à anticiper
+        if (prefetcher != nullptr && params.prompt.trim().isNotEmpty() && backendMode != BackendMode::procedural)
+            prefetcher->request(makeRequest(params, {}, true));
+    }
+
+    juce::String getServerUrl() const
+    {
+        juce::ScopedLock lock(settingsLock);
+        return serverUrl;
+    }
+
+    void setVerboseMode(bool verboseMode)
+    {
+        verbose = verboseMode;
+    }
+
+    // Confier les générations au démon GenIR quand il est lancé (par défaut).
+    // Sans démon joignable, le service du processus est utilisé.
+    void setDaemonEnabled(bool enabled)
+    {
+        daemonEnabled = enabled;
+    }
+
+    // Moteur des prochaines générations ; une génération en cours n'est pas interrompue
+    void setBackendMode(BackendMode mode)
+    {
+        backendMode = mode;
+    }
+
+    BackendMode getBackendMode() const
+    {
+        return backendMode;
+    }
+
+    // Configuration de la convolution de l'instance : le démon y prépare les spectres de
+    // l'IR générée, que l'instance projette en mémoire au lieu de refaire les FFT
+    void setPreparedFormat(double sampleRate, int blockSize)
+    {
+        juce::ScopedLock lock(settingsLock);
+        preparedSampleRate = sampleRate;
+        preparedBlockSize = blockSize;
+    }
+
+    // Gestion des écouteurs
+    void addListener(Listener* listener)
+    {
+        juce::ScopedLock lock(listenerLock);
+        listeners.add(listener);
+    }
+
+    void removeListener(Listener* listener)
+    {
+        juce::ScopedLock lock(listenerLock);
+        listeners.remove(listener);
+    }
+
+private:
+    static juce::String makeCacheKey(const GenerationParams& params)
+    {
+        return GenerationCache::makeKey(params.prompt, params.duration, params.steps,
+            params.guidanceScale, params.seed);
+    }
+
+    GenerationService::Request makeRequest(const GenerationParams& params, const juce::File& outFile,
+        bool speculative) const
+    {
+        GenerationService::Request request;
+        request.prompt = GenerationCache::canonicalisePrompt(params.prompt);   // celui de la clé de cache
+        request.duration = params.duration;
+        request.steps = params.steps;
+        request.guidanceScale = params.guidanceScale;
+        request.seed = params.seed;
+        request.serverUrl = getServerUrl();
+        request.outputFile = outFile;
+        request.speculative = speculative;
+        request.verbose = verbose;
+
+        juce::ScopedLock lock(settingsLock);
+        request.preparedSampleRate = preparedSampleRate;
+        request.preparedBlockSize = preparedBlockSize;
+        return request;
+    }
+
+    // Tous les moteurs, le procédural en dernier : un repli soumis pendant l'annulation des
+    // moteurs distants est ainsi annulé lui aussi
+    std::array<GenerationBackend*, 3> getBackends() const
+    {
+        return { { &daemon.getObject(), &service.getObject(), &procedural.getObject() } };
+    }
+
+    // Une demande distante va au démon s'il répond, sinon au service du processus. L'annulation
+    // et l'état en attente consultent tous les moteurs : le démon a pu apparaître ou disparaître
+    // entre-temps, et le mode a pu changer.
+    void submitRequest(GenerationSubscriber& subscriber, const GenerationRequest& request)
+    {
+        GenerationBackend* backend = &procedural.getObject();
+
+        if (backendMode != BackendMode::procedural)
+            backend = daemonEnabled && daemon->ensureConnected() ? static_cast<GenerationBackend*>(&daemon.getObject())
+                                                                  : &service.getObject();
+
+        // Repli possible : seulement pour une vraie génération de l'instance
+        if (&subscriber == this)
+        {
+            juce::ScopedLock lock(settingsLock);
+            fallbackArmed = backendMode == BackendMode::remoteWithFallback && !request.speculative;
+            fallbackRequest = request;
+        }
+
+        for (auto* other : getBackends())
+            if (other != backend)
+                other->cancel(subscriber);
+
+        backend->submit(subscriber, request);
+    }
+
+    bool cancelRequest(GenerationSubscriber& subscriber)
+    {
+        bool cancelled = false;
+        for (auto* backend : getBackends())
+            cancelled = backend->cancel(subscriber) || cancelled;
+        return cancelled;
+    }
+
+    bool isRequestPending(GenerationSubscriber& subscriber) const
+    {
+        for (auto* backend : getBackends())
+            if (backend->isPending(subscriber))
+                return true;
+        return false;
+    }
+
+    void disarmFallback()
+    {
+        juce::ScopedLock lock(settingsLock);
+        fallbackArmed = false;
+    }
+
+    // Échec distant en mode remoteWithFallback : la même demande part au moteur procédural.
+    // Retourne false si aucun repli n'était prévu.
+    bool fallBackToProcedural(const juce::String& errorMessage)
+    {
+        GenerationRequest request;
+
+        {
+            juce::ScopedLock lock(settingsLock);
+            if (!fallbackArmed)
+                return false;
+
+            fallbackArmed = false;
+            request = fallbackRequest;
+        }
+
+        {
+            juce::ScopedLock lock(listenerLock);
+            listeners.call(&Listener::generationProgress, 0.0f,
+                "Server unreachable (" + errorMessage + "), generating a local draft...");
+        }
+
+        procedural->submit(*this, request);
+        return true;
+    }
+
+    // Génération spéculative en arrière-plan, confiée au service avec une priorité inférieure.
+    // Chaque demande remplace la précédente ; la dernière ne démarre qu'après debounceMs sans
+    // nouvelle demande. Le résultat va uniquement dans le cache partagé : rien n'est installé
+    // ni affiché, et la prédiction est abandonnée dès qu'une vraie génération de paramètres
+    // différents démarre.
+    class Prefetcher : private GenerationService::Subscriber
+    {
+    public:
+        explicit Prefetcher(TangoFluxClient& c)
+            : client(c)
+        {
+        }
+
+        ~Prefetcher() override
+        {
+            client.cancelRequest(*this);
+        }
+
+        void request(GenerationService::Request speculativeRequest)
+        {
+            const juce::String key = GenerationService::makeJobKey(speculativeRequest);
+
+            {
+                juce::ScopedLock lock(requestLock);
+                if (key == requestedKey && client.isRequestPending(*this))
+                    return;
+
+                requestedKey = key;
+            }
+
+            speculativeRequest.delayMs = debounceMs;
+            client.submitRequest(*this, speculativeRequest);
+        }
+
+        // Une vraie génération démarre : abandonner toute prédiction d'autres paramètres
+        void yieldTo(const juce::String& cacheKey)
+        {
+            {
+                juce::ScopedLock lock(requestLock);
+                if (requestedKey.startsWith(cacheKey + "@"))
+                    return;
+
+                requestedKey = {};
+            }
+
+            client.cancelRequest(*this);
+        }
+
+    private:
+        // Une prédiction ratée ou annulée n'a aucune conséquence visible
+        void generationProgress(float, const juce::String&) override {}
+        void generationStreamStarted(std::shared_ptr<ProgressiveBuffer>) override {}
+        void generationCompleted(const juce::File&, const ImpulseResponse&) override {}
+        void generationFailed(const juce::String&) override {}
+
+        TangoFluxClient& client;
+        juce::CriticalSection requestLock;
+        juce::String requestedKey;
+        static constexpr int debounceMs = 1500;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Prefetcher)
+    };
+
+    // Notifications du service, relayées aux écouteurs de cette instance
+    void generationProgress(float progress, const juce::String& stage) override
+    {
+        juce::ScopedLock lock(listenerLock);
+        listeners.call(&Listener::generationProgress, progress, stage);
+    }
+
+    void generationStreamStarted(std::shared_ptr<ProgressiveBuffer> buffer) override
+    {
+        juce::ScopedLock lock(listenerLock);
+        listeners.call(&Listener::generationStreamStarted, buffer);
+    }
+
+    void generationCompleted(const juce::File& irFile, const ImpulseResponse& impulseResponse) override
+    {
+        disarmFallback();
+
+        juce::ScopedLock lock(listenerLock);
+        listeners.call(&Listener::generationCompleted, irFile, impulseResponse);
+    }
+
+    void generationFailed(const juce::String& errorMessage) override
+    {
+        if (fallBackToProcedural(errorMessage))
+            return;
+
+        juce::ScopedLock lock(listenerLock);
+        listeners.call(&Listener::generationFailed, errorMessage);
+    }
+
     // Variables membres
-    QtImpl_TangoFluxClient qtClient;  // Instance du client Qt fonctionnel
+    juce::SharedResourcePointer<GenerationService> service;  // partagé par toutes les instances
+    juce::SharedResourcePointer<DaemonClient> daemon;        // connexion au démon, partagée aussi
+    juce::SharedResourcePointer<ProceduralBackend> procedural;  // synthèse locale, partagée aussi
+    std::atomic<bool> daemonEnabled { true };
+    std::atomic<BackendMode> backendMode { BackendMode::remoteWithFallback };
+
     juce::String serverUrl;
-    bool verbose;
+    mutable juce::CriticalSection settingsLock;
+    std::atomic<bool> verbose;
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
+
+    // Dernière demande distante de l'instance, rejouée en local si elle échoue
+    GenerationRequest fallbackRequest;
+    bool fallbackArmed = false;
 
-    GenerationParams currentParams;
-    juce::File outputFile;
-    juce::String statusMessage;
-    juce::String sessionHash;
+    // Générations spéculatives, présent seulement en mode spéculatif
+    std::unique_ptr<Prefetcher> prefetcher;
 
     juce::ListenerList<Listener> listeners;
     juce::CriticalSection listenerLock;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TangoFluxClient)
-};
\ No newline at end of file
+};
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+// Journal des étapes du pipeline de génération (file d'attente, inférence, téléchargement,
+// décodage, FFT des partitions, échange du moteur de convolution...), partagé par tout le
+// processus (SharedResourcePointer).
+//
+// Chaque étape est un intervalle horodaté, rattaché à la génération en cours sur le thread
+// (ScopedGeneration) : les étapes d'une génération se retrouvent ensemble même quand elles
+// passent d'un thread à l'autre. Le journal est tournant (les capacity dernières étapes) et
+// s'exporte au format « trace event » de Chrome (chrome://tracing, Perfetto), où chaque
+// génération occupe une ligne.
+//
+// record() ne prend aucun verrou ni n'alloue : il peut être appelé depuis le thread audio.
+// Chaque emplacement est protégé par un numéro de séquence, comme StatusChannel.
+class TraceLog
+{
+public:
+    static constexpr int capacity = 4096;
+
+    TraceLog() = default;
+
+    // Horloge commune à toutes les étapes, en microsecondes
+    static juce::int64 nowUs() noexcept
+    {
+        return (juce::int64) (juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks()) * 1.0e6);
+    }
+
+    // Nouvel identifiant de génération (jamais 0, réservé aux étapes hors génération)
+    juce::uint32 newGeneration() noexcept
+    {
+        return ++generationCounter;
+    }
+
+    // Génération à laquelle se rattachent les étapes du thread courant
+    static juce::uint32 getCurrentGeneration() noexcept
+    {
+        return currentGeneration();
+    }
+
+    // Rattache les étapes du thread courant à une génération jusqu'à la fin de la portée
+    class ScopedGeneration
+    {
+    public:
+        explicit ScopedGeneration(juce::uint32 generation) noexcept
+            : previous(currentGeneration())
+        {
+            currentGeneration() = generation;
+        }
+
+        ~ScopedGeneration()
+        {
+            currentGeneration() = previous;
+        }
+
+    private:
+        const juce::uint32 previous;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedGeneration)
+    };
+
+    // Étape terminée. name et category doivent être des littéraux (seul le pointeur est conservé) ;
+    // detail est copié, tronqué à 55 octets.
+    void record(const char* name, const char* category, juce::int64 startUs, juce::int64 endUs,
+                const char* detail = nullptr, juce::uint32 generation = getCurrentGeneration()) noexcept
+    {
+        Event event;
+        event.name = name;
+        event.category = category;
+        event.startUs = startUs;
+        event.durationUs = juce::jmax((juce::int64) 0, endUs - startUs);
+        event.threadId = (juce::uint64) (juce::pointer_sized_uint) juce::Thread::getCurrentThreadId();
+        event.generation = generation;
+
+        if (detail != nullptr)
+        {
+            std::strncpy(event.detail, detail, sizeof(event.detail) - 1);
+            event.detail[sizeof(event.detail) - 1] = 0;
+        }
+
+        registerThreadName(event.threadId);
+        store(event);
+    }
+
+    void record(const char* name, const char* category, juce::int64 startUs, juce::int64 endUs,
+                const juce::String& detail, juce::uint32 generation = getCurrentGeneration())
+    {
+        char buffer[sizeof(Event::detail)] = {};
+        detail.copyToUTF8(buffer, sizeof(buffer));
+        record(name, category, startUs, endUs, buffer, generation);
+    }
+
+    // Étape mesurée de la construction à la destruction
+    class Span
+    {
+    public:
+        Span(TraceLog& log, const char* spanName, const char* spanCategory, const juce::String& spanDetail = {})
+            : trace(log), name(spanName), category(spanCategory), detail(spanDetail), startUs(nowUs())
+        {
+        }
+
+        ~Span()
+        {
+            trace.record(name, category, startUs, nowUs(), detail);
+        }
+
+        void setDetail(const juce::String& text)
+        {
+            detail = text;
+        }
+
+    private:
+        TraceLog& trace;
+        const char* name;
+        const char* category;
+        juce::String detail;
+        const juce::int64 startUs;
+
+        JUCE_DECLARE_NON_COPYABLE(Span)
+    };
+
+    //==============================================================================
+    // Dernières étapes, de la plus ancienne à la plus récente, une par ligne
+    juce::StringArray getRecentLines(int maxLines = 200) const
+    {
+        juce::StringArray lines;
+
+        for (auto& event : snapshot(maxLines))
+        {
+            juce::String line;
+            line << juce::String((double) event.startUs / 1000.0, 1).paddedLeft(' ', 12) << " ms  "
+                 << (event.generation != 0 ? "gen " + juce::String(event.generation) : juce::String("-")).paddedRight(' ', 8)
+                 << juce::String(event.category).paddedRight(' ', 10)
+                 << juce::String(event.name).paddedRight(' ', 20)
+                 << juce::String((double) event.durationUs / 1000.0, 2).paddedLeft(' ', 10) << " ms";
+
+            if (event.detail[0] != 0)
+                line << "  " << juce::String::fromUTF8(event.detail);
+
+            lines.add(line);
+        }
+
+        return lines;
+    }
+
+    // Écrit le journal au format JSON « trace event » de Chrome
+    bool exportChromeTrace(const juce::File& file) const
+    {
+        juce::Array<juce::var> traceEvents;
+        juce::Array<juce::uint32> generations;
+        juce::Array<juce::uint64> threads;
+
+        for (auto& event : snapshot(capacity))
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("name", juce::String(event.name));
+            object->setProperty("cat", juce::String(event.category));
+            object->setProperty("ph", "X");
+            object->setProperty("ts", event.startUs);
+            object->setProperty("dur", event.durationUs);
+            object->setProperty("pid", (int) event.generation);
+            object->setProperty("tid", threadIndex(threads, event.threadId));
+
+            if (event.detail[0] != 0)
+            {
+                auto* args = new juce::DynamicObject();
+                args->setProperty("detail", juce::String::fromUTF8(event.detail));
+                object->setProperty("args", juce::var(args));
+            }
+
+            traceEvents.add(juce::var(object));
+            generations.addIfNotAlreadyThere(event.generation);
+        }
+
+        // Noms des lignes : une par génération, et les threads qui y ont travaillé
+        for (auto generation : generations)
+            traceEvents.add(makeMetadata("process_name", (int) generation, 0,
+                generation != 0 ? "Generation " + juce::String(generation) : juce::String("Plugin")));
+
+        {
+            const juce::SpinLock::ScopedLockType lock(namesLock);
+
+            for (int i = 0; i < threads.size(); ++i)
+            {
+                auto it = threadNames.find(threads[i]);
+                const juce::String name = it != threadNames.end() ? it->second : "Thread " + juce::String(i + 1);
+
+                for (auto generation : generations)
+                    traceEvents.add(makeMetadata("thread_name", (int) generation, i + 1, name));
+            }
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("traceEvents", traceEvents);
+        root->setProperty("displayTimeUnit", "ms");
+
+        return file.replaceWithText(juce::JSON::toString(juce::var(root), true));
+    }
+
+private:
+    // Contenu d'un emplacement, copiable mot à mot
+    struct Event
+    {
+        const char* name = nullptr;
+        const char* category = nullptr;
+        juce::int64 startUs = 0;
+        juce::int64 durationUs = 0;
+        juce::uint64 threadId = 0;
+        juce::uint32 generation = 0;
+        juce::uint32 padding = 0;
+        char detail[56] = {};
+    };
+
+    static_assert(std::is_trivially_copyable<Event>::value, "Event must be copyable word by word");
+    static_assert(sizeof(Event) % sizeof(juce::uint64) == 0, "Event must be a whole number of words");
+
+    static constexpr size_t numWords = sizeof(Event) / sizeof(juce::uint64);
+
+    struct Slot
+    {
+        std::atomic<juce::uint64> sequence { 0 };   // 2 * index + 1 pendant l'écriture, 2 * index + 2 après
+        std::array<std::atomic<juce::uint64>, numWords> words {};
+    };
+
+    static juce::uint32& currentGeneration() noexcept
+    {
+        thread_local juce::uint32 generation = 0;
+        return generation;
+    }
+
+    void store(const Event& event) noexcept
+    {
+        std::array<juce::uint64, numWords> words;
+        std::memcpy(words.data(), &event, sizeof(Event));
+
+        const juce::uint64 index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[(size_t) (index % capacity)];
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // Copie cohérente des maxEvents dernières étapes ; un emplacement en cours d'écriture est ignoré
+    std::vector<Event> snapshot(int maxEvents) const
+    {
+        const juce::uint64 end = nextIndex.load(std::memory_order_acquire);
+        const juce::uint64 count = juce::jmin(end, (juce::uint64) juce::jlimit(0, capacity, maxEvents));
+
+        std::vector<Event> events;
+        events.reserve((size_t) count);
+
+        for (juce::uint64 index = end - count; index < end; ++index)
+        {
+            const Slot& slot = slots[(size_t) (index % capacity)];
+            const juce::uint64 sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence != 2 * index + 2)
+                continue;
+
+            std::array<juce::uint64, numWords> words;
+            for (size_t i = 0; i < numWords; ++i)
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+
+            Event event;
+            std::memcpy(&event, words.data(), sizeof(Event));
+            events.push_back(event);
+        }
+
+        return events;
+    }
+
+    // Nom des threads JUCE, relevé une fois par thread (les threads de l'hôte, dont le thread
+    // audio, n'en ont pas : rien n'est alloué pour eux)
+    void registerThreadName(juce::uint64 threadId) noexcept
+    {
+        thread_local bool registered = false;
+        if (registered)
+            return;
+
+        registered = true;
+
+        if (auto* thread = juce::Thread::getCurrentThread())
+        {
+            const juce::SpinLock::ScopedLockType lock(namesLock);
+            threadNames[threadId] = thread->getThreadName();
+        }
+    }
+
+    static int threadIndex(juce::Array<juce::uint64>& threads, juce::uint64 threadId)
+    {
+        threads.addIfNotAlreadyThere(threadId);
+        return threads.indexOf(threadId) + 1;
+    }
+
+    static juce::var makeMetadata(const juce::String& type, int pid, int tid, const juce::String& name)
+    {
+        auto* args = new juce::DynamicObject();
+        args->setProperty("name", name);
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", type);
+        object->setProperty("ph", "M");
+        object->setProperty("pid", pid);
+        object->setProperty("tid", tid);
+        object->setProperty("args", juce::var(args));
+        return juce::var(object);
+    }
+
+    std::array<Slot, capacity> slots;
+    std::atomic<juce::uint64> nextIndex { 0 };
+    std::atomic<juce::uint32> generationCounter { 0 };
+
+    mutable juce::SpinLock namesLock;
+    std::map<juce::uint64, juce::String> threadNames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceLog)
+};